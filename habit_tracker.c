@@ -1,1431 +1,6800 @@
 #include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <math.h>
 #include <sqlite3.h>
+#include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+
+// Allocation accounting. Long-lived allocations go through mem_alloc /
+// mem_strdup with the subsystem that owns them and are released with
+// mem_free, which reads the owner back from a small header in front of the
+// block. Counters are process-wide so worker threads can allocate too.
+typedef enum {
+    MEM_STORAGE,
+    MEM_MODEL,
+    MEM_TIMETABLE_UI,
+    MEM_DASHBOARD_UI,
+    MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+static const char *mem_subsystem_names[MEM_SUBSYSTEM_COUNT] = {"storage", "model", "timetable-ui", "dashboard-ui"};
+
+typedef union {
+    struct {
+        gsize size;
+        MemSubsystem subsystem;
+    } info;
+    gint64 align;
+    double align_double;
+    gpointer align_pointer;
+} MemHeader;
+
+static gssize mem_live_bytes[MEM_SUBSYSTEM_COUNT];
+static gssize mem_peak_bytes[MEM_SUBSYSTEM_COUNT];
+static gint mem_live_objects[MEM_SUBSYSTEM_COUNT];
+
+static gpointer mem_alloc(MemSubsystem subsystem, gsize size) {
+    MemHeader *header = g_malloc0(sizeof(MemHeader) + size);
+    header->info.size = size;
+    header->info.subsystem = subsystem;
+
+    gssize live = (gssize)g_atomic_pointer_add(&mem_live_bytes[subsystem], (gssize)size) + (gssize)size;
+    gssize peak = (gssize)g_atomic_pointer_get(&mem_peak_bytes[subsystem]);
+    while (live > peak && !g_atomic_pointer_compare_and_exchange(&mem_peak_bytes[subsystem], peak, live)) {
+        peak = (gssize)g_atomic_pointer_get(&mem_peak_bytes[subsystem]);
+    }
+    g_atomic_int_inc(&mem_live_objects[subsystem]);
+    return header + 1;
+}
+
+static char *mem_strdup(MemSubsystem subsystem, const char *str) {
+    if (!str) return NULL;
+    gsize len = strlen(str) + 1;
+    char *copy = mem_alloc(subsystem, len);
+    memcpy(copy, str, len);
+    return copy;
+}
+
+static void mem_free(gpointer ptr) {
+    if (!ptr) return;
+    MemHeader *header = (MemHeader *)ptr - 1;
+    g_atomic_pointer_add(&mem_live_bytes[header->info.subsystem], -(gssize)header->info.size);
+    g_atomic_int_add(&mem_live_objects[header->info.subsystem], -1);
+    g_free(header);
+}
+
+static char *mem_format_report(void) {
+    GString *report = g_string_new("");
+    gssize total_bytes = 0;
+    gint total_objects = 0;
+    g_string_append_printf(report, "%-14s %10s %12s %12s\n", "subsystem", "objects", "live bytes", "peak bytes");
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        gssize live = (gssize)g_atomic_pointer_get(&mem_live_bytes[i]);
+        gint objects = g_atomic_int_get(&mem_live_objects[i]);
+        g_string_append_printf(report, "%-14s %10d %12" G_GSSIZE_FORMAT " %12" G_GSSIZE_FORMAT "\n",
+                               mem_subsystem_names[i], objects, live, (gssize)g_atomic_pointer_get(&mem_peak_bytes[i]));
+        total_bytes += live;
+        total_objects += objects;
+    }
+    g_string_append_printf(report, "%-14s %10d %12" G_GSSIZE_FORMAT, "total", total_objects, total_bytes);
+    return g_string_free(report, FALSE);
+}
+
+static void mem_report_leaks(void) {
+    gboolean leaked = FALSE;
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        gint objects = g_atomic_int_get(&mem_live_objects[i]);
+        if (objects != 0) {
+            g_printerr("Leak report: %s still holds %d objects (%" G_GSSIZE_FORMAT " bytes)\n",
+                       mem_subsystem_names[i], objects, (gssize)g_atomic_pointer_get(&mem_live_bytes[i]));
+            leaked = TRUE;
+        }
+    }
+    if (!leaked && g_getenv("HABIT_TRACKER_MEM_REPORT")) {
+        g_printerr("Leak report: no tracked allocations outstanding\n");
+    }
+}
+
+typedef enum {
+    LATENCY_ACTION_DONE_TODAY,
+    LATENCY_ACTION_MARK_TASK_DONE,
+    LATENCY_ACTION_COUNT
+} LatencyAction;
+
+// Log-linear buckets in the style of HdrHistogram: values below 32us get an
+// exact bucket, every power-of-two range above that is split into 16 linear
+// sub-buckets, so any recorded latency is kept to within ~6%.
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_US ((gint64)1 << 36)
+#define LATENCY_BUCKETS (2 * LATENCY_SUB_BUCKETS + 32 * LATENCY_SUB_BUCKETS)
+
+typedef struct {
+    guint64 counts[LATENCY_BUCKETS];
+    guint64 total;
+    gint64 min_us;
+    gint64 max_us;
+    gint64 sum_us;
+} LatencyHistogram;
+
+#define HABIT_DB_PATH "habit_tracker.db"
+#define HABIT_SNAPSHOT_PATH "habit_tracker.snapshot"
+#define HABIT_ARCHIVE_DB_PATH "habit_tracker_archive.db"
+
+static const char *weekday_names[7] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+static const char *month_names[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                      "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+static const char *time_slot_names[12] = {
+    "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
+    "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
+    "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
+};
+
+// Completion history for analytics: one bit per day, word 0 starting at
+// first_day (a multiple of 64). Loaded on demand for the Statistics page.
+typedef struct {
+    gint32 first_day;
+    guint words;
+    guint capacity;
+    guint64 *bits;
+} HistoryBitmap;
+
+// Logged amounts of a habit with a numeric target, as two parallel columns
+// sorted by day, and a rollup per Monday-first week from first_week on
+// holding the week's total and how many of its days have an amount.
+typedef struct {
+    guint count;
+    guint capacity;
+    gint32 *days;
+    float *amounts;
+    gint32 first_week;
+    guint weeks;
+    guint week_capacity;
+    double *week_totals;
+    guint16 *week_days;
+} HabitValues;
+
+// Habits are referenced everywhere by their habits.id; the name is only
+// display data, so renaming touches one row and one struct field.
+// Weekdays a habit is scheduled on (bit 0 = Monday) from from_day until
+// the next version; G_MININT32 marks the schedule the habit always had.
+typedef struct {
+    gint32 from_day;
+    guint8 days_mask;
+} ScheduleVersion;
+
+typedef struct {
+    gint64 id;
+    char *name;
+    char *days;
+    char *time_slot;
+    int days_completed;
+    double target;  // 0 for a plain done/not-done habit
+    char *unit;
+    HabitValues *values;
+    gint32 counter_base;
+    guint16 *counter_tree;
+    double strength;
+    gint32 strength_day;
+    int quota;  // completions wanted per week, 0 to follow days instead
+    gboolean quota_rolling;
+    int quota_done;
+    gint32 quota_day;
+    ScheduleVersion *schedule;
+    guint schedule_count;
+    float *forecast_weights;
+    HistoryBitmap *history;
+} Habit;
+
+#define HABIT_ID_TO_POINTER(id) GSIZE_TO_POINTER((gsize)(id))
+#define HABIT_ID_FROM_POINTER(p) ((gint64)GPOINTER_TO_SIZE(p))
+
+typedef struct {
+    char *task;
+    char *day;
+    char *time_slot;
+} TaskEntry;
+
+// Everything the first screen needs, read by the startup worker on its own
+// connection and handed to the main thread to be turned into widgets.
+typedef struct {
+    GPtrArray *habits;
+    GPtrArray *tasks;
+    GPtrArray *completed_tasks;
+    gint64 data_version;
+    gboolean unchanged;
+} StartupData;
+
+typedef struct {
+    gint64 habit_id;
+    int time_slot;
+    guint32 weekday_done[7];
+    guint32 weekday_days[7];
+    guint32 month_done[12];
+    guint32 month_days[12];
+} HabitStats;
 
 typedef struct {
+    HabitStats *habits;
+    guint habit_count;
+    guint32 slot_done[12];
+    guint32 slot_days[12];
+    gint64 compute_us;
+} AnalyticsResult;
+
+#define CORRELATION_TOP_PAIRS 100
+
+typedef enum {
+    CORRELATION_SORT_POSITIVE,
+    CORRELATION_SORT_NEGATIVE,
+    CORRELATION_SORT_TOGETHER,
+    CORRELATION_SORT_COUNT
+} CorrelationSort;
+
+// first and second index CorrelationResult.habit_ids.
+typedef struct {
+    guint32 first;
+    guint32 second;
+    guint32 together;
+    float phi;
+} CorrelationPair;
+
+typedef struct {
+    gint32 first_day;
+    guint32 days;
+    guint words;
+    guint habit_count;
+    gint64 *habit_ids;
+    guint64 *vectors;
+    guint32 *totals;
+    CorrelationPair top[CORRELATION_SORT_COUNT][CORRELATION_TOP_PAIRS];
+    guint top_count[CORRELATION_SORT_COUNT];
+    gint64 compute_us;
+} CorrelationResult;
+
+typedef struct {
+    char *sql;
+    guint64 calls;
+    gint64 total_ns;
+    gint64 max_ns;
+    guint64 rows;
+} SqlStatementStats;
+
+typedef struct {
+    GtkApplication *app;
     GtkWidget *main_window;
     GtkWidget *habits_vbox;
     GList *habits;
+    GHashTable *habits_by_id;
     GList *habit_widgets;
+    GHashTable *habit_boxes;
     sqlite3 *db;
     GtkWidget *habits_box;
     GtkWidget *pending_tasks_box;
     GtkWidget *completed_tasks_box;
     GtkWidget *timetable_grid;
+    GtkWidget *timetable_page;
+    GList *tasks;
+    GList *completed_tasks;
+    gint64 data_version;
+    LatencyHistogram commit_latency[LATENCY_ACTION_COUNT];
+    LatencyHistogram paint_latency[LATENCY_ACTION_COUNT];
+    GList *latency_probes;
+    guint latency_signal_source;
+    GtkWidget *notebook;
+    GtkWidget *hud_label;
+    GdkFrameClock *hud_frame_clock;
+    gulong hud_before_paint_handler;
+    gulong hud_after_paint_handler;
+    gint64 hud_paint_start_us;
+    gint64 hud_last_refresh_us;
+    GtkWidget *hud_counted_page;
+    guint hud_widget_count;
+    gint64 hud_widget_count_us;
+    guint hud_frames;
+    gint64 hud_frame_time_sum_us;
+    gint64 hud_frame_time_max_us;
+    guint hud_draw_calls_max;
+    guint hud_db_queries_max;
+    guint frame_draw_calls;
+    guint frame_db_queries;
+    guint64 db_statements;
+    gboolean sql_profile_enabled;
+    gint64 sql_slow_threshold_ns;
+    GMutex sql_profile_lock;
+    GHashTable *sql_stats;
+    GHashTable *sql_running_rows;
+    GtkWidget *memory_panel;
+    GtkWidget *memory_panel_label;
+    guint memory_panel_source;
+    char *metrics_path;
+    guint metrics_source;
+    GtkWidget *management_buttons_box;
+    GtkWidget *loading_label;
+    GCancellable *startup_cancellable;
+    StartupData *startup_data;
+    guint startup_task_pos;
+    guint startup_completed_pos;
+    guint startup_habit_pos;
+    guint startup_source;
+    gint64 startup_us;
+    gint64 first_frame_us;
+    gint64 loaded_us;
+    GdkFrameClock *first_frame_clock;
+    gulong first_frame_handler;
+    gint64 last_input_us;
+    guint maintenance_timer;
+    guint maintenance_source;
+    guint maintenance_step;
+    guint maintenance_table;
+    gint64 maintenance_budget_us;
+    gint64 maintained_version;
+    gboolean incremental_vacuum;
+    GCancellable *purge_cancellable;
+    gboolean purge_pending;
+    GCancellable *archive_cancellable;
+    GtkWidget *edit_habits_window;
+    GtkWidget *edit_habits_grid;
+    GtkWidget *archive_window;
+    gboolean show_rolling_counts;
+    GtkWidget *stats_page;
+    gboolean stats_page_current;
+    AnalyticsResult *analytics;
+    GCancellable *analytics_cancellable;
+    GCancellable *history_cancellable;
+    gboolean history_stale;
+    GtkWidget *heatmap_page;
+    gboolean heatmap_page_current;
+    GHashTable *heatmap_tiles;
+    GQueue heatmap_tile_lru;
+    GtkWidget *month_area;
+    GtkWidget *month_label;
+    int month_shown;
+    GHashTable *month_overviews;
+    GCancellable *month_cancellable;
+    gboolean month_stale;
+    GtkWidget *correlation_page;
+    GtkWidget *correlation_results;
+    gboolean correlation_page_current;
+    CorrelationResult *correlation;
+    GCancellable *correlation_cancellable;
+    guint correlation_debounce_source;
+    guint correlation_range;
+    CorrelationSort correlation_sort;
+    GCancellable *forecast_cancellable;
+    GCancellable *values_cancellable;
+    gboolean values_stale;
+    GHashTable *session_weeks;
+    gint64 session_habit_id;
+    char *session_task;
+    gint64 session_start_us;
+    guint session_source;
+    GtkWidget *session_button;
+    gulong session_destroy_handler;
+    GtkWidget *session_badge;
+    GtkWidget *session_week_label;
+    guint day_rollover_source;
 } AppData;
 
 // Forward declaration
 static void on_done_today_clicked(GtkButton *button, AppData *app_data);
+static void on_habit_amount_changed(GtkSpinButton *spin_button, AppData *app_data);
 
+static int weekday_index(const char *day) {
+    for (int i = 0; i < 7; i++) {
+        if (strcmp(weekday_names[i], day) == 0) return i + 1;
+    }
+    return 0;
+}
 
-static void on_habit_toggled(GtkCheckButton *check_button, AppData *app_data) {
-    const char *habit_name = gtk_check_button_get_label(check_button);
-    gboolean completed = gtk_check_button_get_active(check_button);
+static int time_slot_index(const char *time_slot) {
+    for (int i = 0; i < 12; i++) {
+        if (strcmp(time_slot_names[i], time_slot) == 0) return i + 1;
+    }
+    return 0;
+}
 
-    GDateTime *date = g_date_time_new_now_local();
-    if (date == NULL) return;
+// Completion dates are day numbers: days since 1970-01-01 of the local
+// calendar date. They are computed from the civil date, never from a
+// timestamp, so a DST change cannot move a day and consecutive days always
+// differ by exactly 1. DAY_NUMBER_SQL converts a 'YYYY-MM-DD' column.
+#define DAY_NUMBER_SQL(column) "CAST(julianday(" column ") - 2440587.5 AS INTEGER)"
+
+static gint32 day_number_from_ymd(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
 
-    gint year = g_date_time_get_year(date);
-    gint month = g_date_time_get_month(date);
-    gint day = g_date_time_get_day_of_month(date);
+static void day_number_to_ymd(gint32 day_number, int *year, int *month, int *day) {
+    int shifted = day_number + 719468;
+    int era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+    int day_of_era = shifted - era * 146097;
+    int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int month_index = (5 * day_of_year + 2) / 153;
+    *day = day_of_year - (153 * month_index + 2) / 5 + 1;
+    *month = month_index < 10 ? month_index + 3 : month_index - 9;
+    *year = year_of_era + era * 400 + (*month <= 2);
+}
 
-    g_date_time_unref(date);
+// 0 = Mon ... 6 = Sun; day 0 was a Thursday.
+static int day_number_weekday(gint32 day_number) {
+    return ((day_number % 7) + 7 + 3) % 7;
+}
 
-    char query[256];
-    snprintf(query, sizeof(query),
-             "INSERT OR REPLACE INTO habit_tracking (date, habit_name, completed) VALUES ('%04d-%02d-%02d', '%s', %d);",
-             year, month, day, habit_name, completed);
-    sqlite3_exec(app_data->db, query, NULL, NULL, NULL);
+static gint32 day_number_today(void) {
+    GDateTime *now = g_date_time_new_now_local();
+    gint32 today = day_number_from_ymd(g_date_time_get_year(now), g_date_time_get_month(now),
+                                       g_date_time_get_day_of_month(now));
+    g_date_time_unref(now);
+    return today;
 }
 
-static int get_days_completed(sqlite3 *db, const char *habit_name) {
-    char query[256];
-    snprintf(query, sizeof(query),
-             "SELECT COUNT(DISTINCT date) FROM habit_tracking WHERE habit_name = '%s' AND completed = 1;",
-             habit_name);
+static HistoryBitmap *history_new(void) {
+    return mem_alloc(MEM_MODEL, sizeof(HistoryBitmap));
+}
 
-    sqlite3_stmt *stmt;
-    int days = 0;
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, NULL) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            days = sqlite3_column_int(stmt, 0);
-        }
-    }
-    sqlite3_finalize(stmt);
-    return days;
+static void history_free(gpointer data) {
+    HistoryBitmap *history = data;
+    if (!history) return;
+    mem_free(history->bits);
+    mem_free(history);
 }
 
-static void draw_habit_logo(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer data) {
-    const char *habit_name = (const char *)data;
-    AppData *app_data = g_object_get_data(G_OBJECT(area), "app_data");
-    int days = get_days_completed(app_data->db, habit_name);
+// Sets or clears one day, growing the bitmap in either direction to reach
+// it. Appends double the capacity so loading sorted days stays linear.
+static void history_set(HistoryBitmap *history, gint32 day, gboolean done) {
+    gint32 end_day = history->first_day + (gint32)history->words * 64;
+    if (!done && (!history->bits || day < history->first_day || day >= end_day)) return;
+
+    gint32 word_day = day - ((day % 64) + 64) % 64;
+    if (!history->bits) history->first_day = word_day;
+    guint shift_words = word_day < history->first_day ? (history->first_day - word_day) / 64 : 0;
+    gint32 first_day = history->first_day - (gint32)shift_words * 64;
+    guint needed = MAX(history->words + shift_words, (guint)((word_day - first_day) / 64 + 1));
+    if (shift_words > 0 || needed > history->capacity) {
+        guint capacity = MAX(needed, history->capacity * 2);
+        guint64 *bits = mem_alloc(MEM_MODEL, capacity * sizeof(guint64));
+        if (history->bits) memcpy(bits + shift_words, history->bits, history->words * sizeof(guint64));
+        mem_free(history->bits);
+        history->bits = bits;
+        history->capacity = capacity;
+        history->first_day = first_day;
+    }
+    history->words = needed;
 
-    int radius = MIN(width, height) / 2 - 5;
+    guint offset = day - history->first_day;
+    if (done) {
+        history->bits[offset / 64] |= (guint64)1 << (offset % 64);
+    } else {
+        history->bits[offset / 64] &= ~((guint64)1 << (offset % 64));
+    }
+}
 
-    cairo_arc(cr, width / 2, height / 2, radius, 0, 2 * G_PI);
-    cairo_set_source_rgb(cr, 0.25, 0.65, 0.25);
-    cairo_fill(cr);
+// Portable SWAR popcount; compilers turn it into one instruction where the
+// target has one, and it avoids the libgcc call __builtin_popcountll
+// becomes on baseline x86-64.
+static inline guint bit_count64(guint64 word) {
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (guint)((word * 0x0101010101010101ull) >> 56);
+}
 
-    char days_str[16];
-    snprintf(days_str, sizeof(days_str), "%d", days);
-    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-    cairo_set_font_size(cr, 20);
-    cairo_text_extents_t extents;
-    cairo_text_extents(cr, days_str, &extents);
-    cairo_move_to(cr, width / 2 - extents.width / 2, height / 2 + extents.height / 2);
-    cairo_show_text(cr, days_str);
+// Completed days in [first_day, end_day) for spans of at most 64 days,
+// which touch no more than two words.
+static guint history_count_span(const HistoryBitmap *history, gint32 first_day, gint32 end_day) {
+    if (end_day <= history->first_day) return 0;
+    guint begin = MAX(first_day, history->first_day) - history->first_day;
+    guint end = MIN((guint)(end_day - history->first_day), history->words * 64);
+    if (begin >= end) return 0;
+    guint64 first_word = history->bits[begin / 64] >> (begin % 64);
+    if (end - begin < 64) first_word &= ((guint64)1 << (end - begin)) - 1;
+    guint count = bit_count64(first_word);
+    guint last = (end - 1) / 64;
+    if (last != begin / 64) count += bit_count64(history->bits[last] & (~(guint64)0 >> (63 - (end - 1) % 64)));
+    return count;
 }
 
-static void on_remove_habit(GtkButton *button, AppData *app_data) {
-    const char *habit_name = (const char *)g_object_get_data(G_OBJECT(button), "habit_name");
-    GtkWidget *row = (GtkWidget *)g_object_get_data(G_OBJECT(button), "row");
+// The 64 days starting at day as one word, bit 0 being day itself.
+static guint64 history_window64(const HistoryBitmap *history, gint32 day) {
+    gint64 offset = (gint64)day - history->first_day;
+    if (history->words == 0 || offset <= -64 || offset >= (gint64)history->words * 64) return 0;
+    if (offset < 0) return history->bits[0] << -offset;
+    guint word = offset / 64, shift = offset % 64;
+    guint64 result = history->bits[word] >> shift;
+    if (shift && word + 1 < history->words) result |= history->bits[word + 1] << (64 - shift);
+    return result;
+}
 
-    if (!habit_name || !row) {
-        g_printerr("Error: Invalid habit_name or row in on_remove_habit\n");
-        return;
+static gint32 history_first_completed_day(const HistoryBitmap *history) {
+    for (guint w = 0; w < history->words; w++) {
+        if (history->bits[w]) return history->first_day + (gint32)w * 64 + __builtin_ctzll(history->bits[w]);
     }
+    return G_MAXINT32;
+}
 
-    GList *link = g_list_find_custom(app_data->habits, habit_name, (GCompareFunc)strcmp);
-    if (link) {
-        g_free(link->data);
-        app_data->habits = g_list_delete_link(app_data->habits, link);
-    } else {
-        g_printerr("Error: Habit %s not found in habits list\n", habit_name);
+static Habit *habit_new(gint64 id, const char *name, const char *days, const char *time_slot) {
+    Habit *habit = mem_alloc(MEM_MODEL, sizeof(Habit));
+    habit->id = id;
+    habit->name = mem_strdup(MEM_MODEL, name);
+    habit->days = mem_strdup(MEM_MODEL, days ? days : "");
+    habit->time_slot = mem_strdup(MEM_MODEL, time_slot ? time_slot : "");
+    habit->unit = mem_strdup(MEM_MODEL, "");
+    return habit;
+}
+
+static void habit_values_free(HabitValues *values);
+
+static void habit_set_target(Habit *habit, double target, const char *unit) {
+    habit->target = target;
+    mem_free(habit->unit);
+    habit->unit = mem_strdup(MEM_MODEL, unit ? unit : "");
+}
+
+static void habit_free(gpointer data) {
+    Habit *habit = data;
+    if (!habit) return;
+    mem_free(habit->name);
+    mem_free(habit->days);
+    mem_free(habit->time_slot);
+    mem_free(habit->unit);
+    mem_free(habit->schedule);
+    habit_values_free(habit->values);
+    mem_free(habit->counter_tree);
+    mem_free(habit->forecast_weights);
+    history_free(habit->history);
+    mem_free(habit);
+}
+
+// Rolling completion windows. Each habit keeps a Fenwick tree over the
+// COUNTER_SPAN_DAYS day numbers starting at counter_base, with one slot per
+// day holding 1 if it was completed. Toggling a day and counting any window
+// inside the span are both O(log n) and never touch the database. The span
+// starts COUNTER_HEADROOM_DAYS short of reaching today, and a day past its
+// end slides it forward.
+#define COUNTER_SPAN_DAYS 512
+#define COUNTER_HEADROOM_DAYS 32
+
+static gint32 habit_counter_base_for(gint32 day) {
+    return day - (COUNTER_SPAN_DAYS - COUNTER_HEADROOM_DAYS) + 1;
+}
+
+// Sum of slots 0..index.
+static int counter_prefix(const guint16 *tree, int index) {
+    int sum = 0;
+    for (; index >= 0; index = (index & (index + 1)) - 1) {
+        sum += tree[index];
     }
+    return sum;
+}
 
-    gtk_grid_remove(GTK_GRID(gtk_widget_get_parent(row)), row);
-    gtk_widget_unparent(row);
+static void habit_counter_reset(Habit *habit, gint32 base_day) {
+    mem_free(habit->counter_tree);
+    habit->counter_tree = mem_alloc(MEM_MODEL, COUNTER_SPAN_DAYS * sizeof(guint16));
+    habit->counter_base = base_day;
+}
 
-    GList *iter = app_data->habit_widgets;
-    gboolean found = FALSE;
-    while (iter) {
-        GtkWidget *widget = (GtkWidget *)iter->data;
-        const char *name = (const char *)g_object_get_data(G_OBJECT(widget), "habit_name");
-        if (name && strcmp(name, habit_name) == 0) {
-            gtk_box_remove(GTK_BOX(app_data->habits_box), widget);
-            app_data->habit_widgets = g_list_remove(app_data->habit_widgets, widget);
-            g_free((char *)name);
-            gtk_widget_unparent(widget);
-            found = TRUE;
-            break;
-        }
-        iter = iter->next;
+// Undoes the build to get one value per day, shifts the values to the new
+// base and builds again. Each pass hands every slot's sum to its parent
+// once, so the rebase is linear in COUNTER_SPAN_DAYS.
+static void habit_counter_rebase(Habit *habit, gint32 base_day) {
+    guint16 *tree = habit->counter_tree;
+    for (int i = COUNTER_SPAN_DAYS - 1; i >= 0; i--) {
+        int parent = i | (i + 1);
+        if (parent < COUNTER_SPAN_DAYS) tree[parent] -= tree[i];
+    }
+    int shift = base_day - habit->counter_base;
+    guint16 values[COUNTER_SPAN_DAYS] = {0};
+    for (int i = 0; i < COUNTER_SPAN_DAYS; i++) {
+        int source = i + shift;
+        if (source >= 0 && source < COUNTER_SPAN_DAYS) values[i] = tree[source];
     }
+    memcpy(tree, values, sizeof(values));
+    for (int i = 0; i < COUNTER_SPAN_DAYS; i++) {
+        int parent = i | (i + 1);
+        if (parent < COUNTER_SPAN_DAYS) tree[parent] += tree[i];
+    }
+    habit->counter_base = base_day;
+}
 
-    if (!found) {
-        GtkWidget *child = gtk_widget_get_first_child(app_data->habits_box);
-        while (child) {
-            const char *name = (const char *)g_object_get_data(G_OBJECT(child), "habit_name");
-            if (name && strcmp(name, habit_name) == 0) {
-                gtk_box_remove(GTK_BOX(app_data->habits_box), child);
-                g_free((char *)name);
-                gtk_widget_unparent(child);
-                found = TRUE;
-                break;
-            }
+static void habit_counter_add(Habit *habit, gint32 day, int delta) {
+    if (!habit->counter_tree) habit_counter_reset(habit, habit_counter_base_for(day));
+    if (day - habit->counter_base >= COUNTER_SPAN_DAYS) habit_counter_rebase(habit, habit_counter_base_for(day));
+    int index = day - habit->counter_base;
+    if (index < 0) return;
+    for (; index < COUNTER_SPAN_DAYS; index |= index + 1) {
+        habit->counter_tree[index] += delta;
+    }
+}
 
-            GtkWidget *drawing_area = gtk_widget_get_first_child(child);
-            if (drawing_area) {
-                name = (const char *)g_object_get_data(G_OBJECT(drawing_area), "habit_name");
-                if (name && strcmp(name, habit_name) == 0) {
-                    gtk_box_remove(GTK_BOX(app_data->habits_box), child);
-                    g_free((char *)name);
-                    gtk_widget_unparent( child);
-                    found = TRUE;
-                    break;
-                }
-            }
-            child = gtk_widget_get_next_sibling(child);
-        }
+// Completed days in [first_day, last_day], clipped to the tracked span.
+static int habit_counter_range(const Habit *habit, gint32 first_day, gint32 last_day) {
+    if (!habit->counter_tree) return 0;
+    int first = MAX(first_day - habit->counter_base, 0);
+    int last = MIN(last_day - habit->counter_base, COUNTER_SPAN_DAYS - 1);
+    if (first > last) return 0;
+    return counter_prefix(habit->counter_tree, last) - counter_prefix(habit->counter_tree, first - 1);
+}
+
+// Habit strength: an exponentially weighted completion rate,
+// strength(t) = (1 - λ) Σ λ^(t - d) over completed days d <= t, where
+// λ = 2^(-1/STRENGTH_HALF_LIFE_DAYS). Each habit stores the value as of
+// strength_day. A later day only decays it by λ^n. Since the sum is
+// linear, toggling day d adds or removes (1 - λ) λ^(strength_day - d),
+// so a retroactive edit is O(1) as well. Weights older than the counter
+// span are below 1e-10, so a full recompute only reads the rolling
+// counter.
+#define STRENGTH_HALF_LIFE_DAYS 13
+
+static double strength_decay[COUNTER_SPAN_DAYS];          // λ^k
+static double strength_weights_reversed[COUNTER_SPAN_DAYS]; // (1 - λ) λ^(span - 1 - k)
+
+static void strength_tables_init(void) {
+    static gsize initialized = 0;
+    if (!g_once_init_enter(&initialized)) return;
+    double lambda = exp2(-1.0 / STRENGTH_HALF_LIFE_DAYS);
+    for (int k = 0; k < COUNTER_SPAN_DAYS; k++) {
+        strength_decay[k] = pow(lambda, k);
     }
+    for (int k = 0; k < COUNTER_SPAN_DAYS; k++) {
+        strength_weights_reversed[k] = (1.0 - lambda) * strength_decay[COUNTER_SPAN_DAYS - 1 - k];
+    }
+    g_once_init_leave(&initialized, 1);
+}
 
-    if (found) {
-        gtk_widget_queue_draw(app_data->habits_box);
-    } else {
-        g_printerr("Error: Habit widget %s not found in habits_box\n", habit_name);
+static double strength_decay_for(gint64 days) {
+    return days < COUNTER_SPAN_DAYS ? strength_decay[days] : 0.0;
+}
+
+static double habit_strength_at(const Habit *habit, gint32 day) {
+    strength_tables_init();
+    if (day <= habit->strength_day) return habit->strength;
+    return habit->strength * strength_decay_for((gint64)day - habit->strength_day);
+}
+
+static void habit_strength_toggle(Habit *habit, gint32 day, int delta) {
+    strength_tables_init();
+    if (day > habit->strength_day) {
+        habit->strength = habit_strength_at(habit, day);
+        habit->strength_day = day;
     }
+    double weight = strength_decay_for((gint64)habit->strength_day - day) * (1.0 - strength_decay[1]);
+    habit->strength = CLAMP(habit->strength + delta * weight, 0.0, 1.0);
+}
 
-    const char *days[] = {"", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
-    const char *times[] = {
-        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
-        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
-        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
-    };
-    char query[256];
-    snprintf(query, sizeof(query), "SELECT days, time_slot FROM habit_tracking WHERE habit_name = '%s';", habit_name);
-    sqlite3_stmt *stmt;
-    const char *days_str = "";
-    const char *time_slot = "";
-    if (sqlite3_prepare_v2(app_data->db, query, -1, &stmt, NULL) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            days_str = (const char *)sqlite3_column_text(stmt, 0);
-            time_slot = (const char *)sqlite3_column_text(stmt, 1);
-            if (!time_slot) time_slot = "";
-        }
+// Rebuilds the strength as of day from the rolling counter: the per-day
+// values are recovered from the Fenwick tree by undoing its linear build,
+// then dotted with the weights, stored reversed so both arrays are read
+// front to back.
+static void habit_strength_recompute(Habit *habit, gint32 day) {
+    strength_tables_init();
+    habit->strength = 0.0;
+    habit->strength_day = day;
+    if (!habit->counter_tree) return;
+
+    double values[COUNTER_SPAN_DAYS];
+    for (int i = 0; i < COUNTER_SPAN_DAYS; i++) {
+        values[i] = habit->counter_tree[i];
     }
-    sqlite3_finalize(stmt);
+    for (int i = COUNTER_SPAN_DAYS - 1; i >= 0; i--) {
+        int parent = i | (i + 1);
+        if (parent < COUNTER_SPAN_DAYS) values[parent] -= values[i];
+    }
+    gint64 offset = (gint64)day - habit->counter_base;
+    if (offset < 0) return;
+
+    // Past the span's end every slot decays by the same extra factor.
+    int newest = MIN(offset, COUNTER_SPAN_DAYS - 1);
+    const double *weights = strength_weights_reversed + (COUNTER_SPAN_DAYS - 1 - newest);
+    double sum = 0.0;
+    for (int i = 0; i <= newest; i++) {
+        sum += values[i] * weights[i];
+    }
+    habit->strength = CLAMP(sum * strength_decay_for(offset - newest), 0.0, 1.0);
+}
 
-    if (days_str && time_slot && strlen(time_slot) > 0) {
-        int time_idx = 0;
-        for (int i = 0; i < 12; i++) {
-            if (strcmp(times[i], time_slot) == 0) {
-                time_idx = i + 1;
-                break;
-            }
-        }
+// Weekly quotas. A habit with a quota is due until it has been completed
+// quota times in its window: Monday through today for a calendar week,
+// the last seven days for a rolling one. quota_done is the count in the
+// window ending at quota_day, kept current by habit_quota_toggle and moved
+// along by habit_quota_advance when the day rolls over.
+static gint32 habit_quota_window_start(const Habit *habit, gint32 day) {
+    return habit->quota_rolling ? day - 6 : day - day_number_weekday(day);
+}
 
-        char *days_copy = g_strdup(days_str);
-        char *token = strtok(days_copy, ",");
-        while (token) {
-            int day_idx = 0;
-            for (int i = 1; i <= 7; i++) {
-                if (strcmp(days[i], token) == 0) {
-                    day_idx = i;
-                    break;
-                }
-            }
-            if (day_idx > 0 && time_idx > 0 && app_data->timetable_grid) {
-                GtkWidget *task_box = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_idx, time_idx);
-                if (task_box) {
-                    GtkWidget *child = gtk_widget_get_first_child(task_box);
-                    while (child) {
-                        if (GTK_IS_LABEL(child)) {
-                            const char *label_text = gtk_label_get_text(GTK_LABEL(child));
-                            if (strcmp(label_text, habit_name) == 0) {
-                                gtk_box_remove(GTK_BOX(task_box), child);
-                                break;
-                            }
-                        }
-                        child = gtk_widget_get_next_sibling(child);
-                    }
-                }
-            }
-            token = strtok(NULL, ",");
-        }
-        g_free(days_copy);
+static void habit_quota_recompute(Habit *habit, gint32 day) {
+    habit->quota_done = habit_counter_range(habit, habit_quota_window_start(habit, day), day);
+    habit->quota_day = day;
+}
+
+// Moving forward within an overlapping window only touches the days that
+// leave and enter it; a new calendar week or a long gap starts over.
+static void habit_quota_advance(Habit *habit, gint32 day) {
+    if (day == habit->quota_day) return;
+    gint32 old_start = habit_quota_window_start(habit, habit->quota_day);
+    gint32 new_start = habit_quota_window_start(habit, day);
+    if (day < habit->quota_day || new_start > habit->quota_day) {
+        habit_quota_recompute(habit, day);
+        return;
     }
+    habit->quota_done += habit_counter_range(habit, habit->quota_day + 1, day) -
+                         habit_counter_range(habit, old_start, new_start - 1);
+    habit->quota_day = day;
+}
 
-    snprintf(query, sizeof(query), "DELETE FROM habit_tracking WHERE habit_name = '%s';", habit_name);
-    sqlite3_exec(app_data->db, query, NULL, NULL, NULL);
+static void habit_quota_toggle(Habit *habit, gint32 day, int delta) {
+    if (day <= habit->quota_day && day >= habit_quota_window_start(habit, habit->quota_day)) {
+        habit->quota_done += delta;
+    }
 }
 
-static void on_day_toggled(GtkToggleButton *toggle_button, gpointer data) {
-    AppData *app_data = (AppData *)g_object_get_data(G_OBJECT(toggle_button), "app_data");
-    const char *habit_name = (const char *)g_object_get_data(G_OBJECT(toggle_button), "habit_name");
-    GtkWidget *hour_dropdown_generic = (GtkWidget *)g_object_get_data(G_OBJECT(toggle_button), "hour_dropdown");
+static int habit_quota_done_at(const Habit *habit, gint32 day) {
+    if (day == habit->quota_day) return habit->quota_done;
+    return habit_counter_range(habit, habit_quota_window_start(habit, day), day);
+}
 
-    GtkDropDown* hour_dropdown = GTK_DROP_DOWN(hour_dropdown_generic);
+// Schedule versions. Editing a habit's days adds a version starting today
+// instead of rewriting the past, so adherence for earlier ranges is still
+// measured against the days that were scheduled then.
+static guint8 schedule_mask_from_days(const char *days) {
+    static const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+    guint8 mask = 0;
+    for (int weekday = 0; weekday < 7; weekday++) {
+        if (days && strstr(days, day_names[weekday])) mask |= 1 << weekday;
+    }
+    return mask;
+}
 
+// Versions stay sorted by from_day; a version for an existing from_day
+// replaces it, and one that repeats the previous mask is dropped.
+static void habit_schedule_set(Habit *habit, gint32 from_day, guint8 days_mask) {
+    guint count = habit->schedule_count;
+    while (count > 0 && habit->schedule[count - 1].from_day >= from_day) count--;
+    if (count > 0 && habit->schedule[count - 1].days_mask == days_mask) {
+        habit->schedule_count = count;
+        return;
+    }
+    if (count == habit->schedule_count) {
+        ScheduleVersion *schedule = mem_alloc(MEM_MODEL, (count + 1) * sizeof(ScheduleVersion));
+        if (count) memcpy(schedule, habit->schedule, count * sizeof(ScheduleVersion));
+        mem_free(habit->schedule);
+        habit->schedule = schedule;
+    }
+    habit->schedule[count].from_day = from_day;
+    habit->schedule[count].days_mask = days_mask;
+    habit->schedule_count = count + 1;
+}
 
-    GString *days = g_string_new("");
-    const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+// Habits created before schedules were versioned get their current days
+// as the schedule they always had.
+static void habit_schedule_ensure(Habit *habit) {
+    if (habit->schedule_count == 0) habit_schedule_set(habit, G_MININT32, schedule_mask_from_days(habit->days));
+}
 
-    GtkWidget *parent_box = gtk_widget_get_parent(GTK_WIDGET(toggle_button));
-    if (!GTK_IS_BOX(parent_box)) {
-         parent_box = gtk_widget_get_parent(gtk_widget_get_parent(GTK_WIDGET(toggle_button)));
+// Whether the dashboard offers today's check-in: for a quota habit while
+// completions remain this week, or today's can still be undone; otherwise
+// on the habit's scheduled weekdays.
+static gboolean habit_due_today(const Habit *habit, gint32 today, const char *current_day_name) {
+    if (habit->quota > 0) {
+        return habit_quota_done_at(habit, today) < habit->quota || habit_counter_range(habit, today, today) > 0;
     }
+    return strstr(habit->days, current_day_name) != NULL;
+}
 
+// Quantities. A habit with a target logs an amount per day; the day counts
+// as completed once the amount reaches the target. Sums over a date range
+// take whole weeks from the rollups and only the ragged ends from the day
+// column; percentiles select from the contiguous slice of the amount
+// column the range maps to.
+static HabitValues *habit_values_new(void) {
+    return mem_alloc(MEM_MODEL, sizeof(HabitValues));
+}
 
-    GtkWidget *child = gtk_widget_get_first_child(parent_box);
-    int current_button_idx = 0;
-    while(child) {
-        if(GTK_IS_TOGGLE_BUTTON(child)) {
-             if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(child))) {
-                if (days->len > 0) g_string_append(days, ",");
-                g_string_append(days, day_names[current_button_idx % 7]);
-            }
-            current_button_idx++;
-        }
-        if(child == GTK_WIDGET(toggle_button) && hour_dropdown == NULL){
+static void habit_values_free(HabitValues *values) {
+    if (!values) return;
+    mem_free(values->days);
+    mem_free(values->amounts);
+    mem_free(values->week_totals);
+    mem_free(values->week_days);
+    mem_free(values);
+}
 
-            GtkWidget* next_sibling = gtk_widget_get_next_sibling(child);
-            while(next_sibling && !GTK_IS_DROP_DOWN(next_sibling)){
-                 next_sibling = gtk_widget_get_next_sibling(next_sibling);
-            }
-            if(GTK_IS_DROP_DOWN(next_sibling)){
-                hour_dropdown = GTK_DROP_DOWN(next_sibling);
-            }
+// Monday-first weeks: day_number_week(day) * 7 - 3 is that week's Monday.
+static gint32 day_number_week(gint32 day) {
+    return (day - day_number_weekday(day) + 3) / 7;
+}
+
+// Index of the first logged day at or after day.
+static guint habit_values_lower_bound(const HabitValues *values, gint32 day) {
+    guint low = 0, high = values->count;
+    while (low < high) {
+        guint middle = (low + high) / 2;
+        if (values->days[middle] < day) {
+            low = middle + 1;
+        } else {
+            high = middle;
         }
-         child = gtk_widget_get_next_sibling(child);
-         if(current_button_idx >=7 && hour_dropdown != NULL) break;
     }
+    return low;
+}
 
+static double habit_values_get(const HabitValues *values, gint32 day) {
+    guint index = habit_values_lower_bound(values, day);
+    return index < values->count && values->days[index] == day ? values->amounts[index] : 0.0;
+}
 
-    const char *times[] = {
-        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
-        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
-        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
-    };
-    guint selected_time = 0;
-    if(hour_dropdown){
-        selected_time = gtk_drop_down_get_selected(hour_dropdown);
+static void habit_values_rollup(HabitValues *values, gint32 day, double delta, int day_delta) {
+    gint32 week = day_number_week(day);
+    if (values->weeks == 0) values->first_week = week;
+    guint shift = week < values->first_week ? values->first_week - week : 0;
+    guint needed = MAX(values->weeks + shift, (guint)(week - (values->first_week - (gint32)shift)) + 1);
+    if (shift > 0 || needed > values->week_capacity) {
+        guint capacity = MAX(needed, values->week_capacity * 2);
+        double *totals = mem_alloc(MEM_MODEL, capacity * sizeof(double));
+        guint16 *days = mem_alloc(MEM_MODEL, capacity * sizeof(guint16));
+        if (values->weeks) {
+            memcpy(totals + shift, values->week_totals, values->weeks * sizeof(double));
+            memcpy(days + shift, values->week_days, values->weeks * sizeof(guint16));
+        }
+        mem_free(values->week_totals);
+        mem_free(values->week_days);
+        values->week_totals = totals;
+        values->week_days = days;
+        values->week_capacity = capacity;
+        values->first_week -= shift;
     }
-    const char *time_slot = times[selected_time];
+    values->weeks = needed;
+    values->week_totals[week - values->first_week] += delta;
+    values->week_days[week - values->first_week] += day_delta;
+}
 
-    const char *day_labels[] = {"", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
-    for (int day = 1; day <= 7; day++) {
-        for (int time_idx_loop = 1; time_idx_loop <= 12; time_idx_loop++) {
-            if (!app_data->timetable_grid) continue;
-            GtkWidget *task_box = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day, time_idx_loop);
-            if (task_box) {
-                GtkWidget *current_child = gtk_widget_get_first_child(task_box);
-                while (current_child) {
-                    GtkWidget *next_child = gtk_widget_get_next_sibling(current_child);
-                    if (GTK_IS_LABEL(current_child)) {
-                        const char *label_text = gtk_label_get_text(GTK_LABEL(current_child));
-                        if (strcmp(label_text, habit_name) == 0) {
-                            gtk_box_remove(GTK_BOX(task_box), current_child);
-                        }
-                    }
-                    current_child = next_child;
-                }
+// Stores amount for day; 0 removes the day from the columns.
+static void habit_values_set(HabitValues *values, gint32 day, double amount) {
+    // Rollups accumulate exactly what the float column holds.
+    amount = (float)amount;
+    guint index = habit_values_lower_bound(values, day);
+    gboolean present = index < values->count && values->days[index] == day;
+    double previous = present ? values->amounts[index] : 0.0;
+    if (present && amount == 0.0) {
+        memmove(values->days + index, values->days + index + 1, (values->count - index - 1) * sizeof(gint32));
+        memmove(values->amounts + index, values->amounts + index + 1, (values->count - index - 1) * sizeof(float));
+        values->count--;
+    } else if (present) {
+        values->amounts[index] = amount;
+    } else if (amount != 0.0) {
+        if (values->count == values->capacity) {
+            guint capacity = MAX(16, values->capacity * 2);
+            gint32 *days = mem_alloc(MEM_MODEL, capacity * sizeof(gint32));
+            float *amounts = mem_alloc(MEM_MODEL, capacity * sizeof(float));
+            if (values->count) {
+                memcpy(days, values->days, values->count * sizeof(gint32));
+                memcpy(amounts, values->amounts, values->count * sizeof(float));
             }
+            mem_free(values->days);
+            mem_free(values->amounts);
+            values->days = days;
+            values->amounts = amounts;
+            values->capacity = capacity;
         }
+        memmove(values->days + index + 1, values->days + index, (values->count - index) * sizeof(gint32));
+        memmove(values->amounts + index + 1, values->amounts + index, (values->count - index) * sizeof(float));
+        values->days[index] = day;
+        values->amounts[index] = amount;
+        values->count++;
+    } else {
+        return;
     }
+    habit_values_rollup(values, day, amount - previous, present == (amount != 0.0) ? 0 : (present ? -1 : 1));
+}
 
-    int time_idx_timetable = selected_time + 1;
-    char *days_copy = g_strdup(days->str);
-    char *token = strtok(days_copy, ",");
-    while (token) {
-        int day_idx = 0;
-        for (int i = 0; i < 7; i++) {
-            if (strcmp(day_names[i], token) == 0) {
-                day_idx = i + 1;
-                break;
+static double habit_values_slice_sum(const HabitValues *values, gint32 first_day, gint32 end_day) {
+    double sum = 0.0;
+    for (guint i = habit_values_lower_bound(values, first_day); i < values->count && values->days[i] < end_day; i++) {
+        sum += values->amounts[i];
+    }
+    return sum;
+}
+
+// Total logged in [first_day, last_day].
+static double habit_values_sum(const HabitValues *values, gint32 first_day, gint32 last_day) {
+    gint32 first_week = day_number_week(first_day) + (day_number_weekday(first_day) != 0);
+    gint32 last_week = day_number_week(last_day) - (day_number_weekday(last_day) != 6);
+    if (first_week > last_week) return habit_values_slice_sum(values, first_day, last_day + 1);
+
+    double sum = habit_values_slice_sum(values, first_day, first_week * 7 - 3) +
+                 habit_values_slice_sum(values, (last_week + 1) * 7 - 3, last_day + 1);
+    gint32 rollup_end = values->first_week + (gint32)values->weeks;
+    for (gint32 week = MAX(first_week, values->first_week); week <= last_week && week < rollup_end; week++) {
+        sum += values->week_totals[week - values->first_week];
+    }
+    return sum;
+}
+
+// The fraction-th quantile of the amounts logged in [first_day, last_day],
+// by quickselect on a copy of that slice; NAN when nothing was logged.
+static double habit_values_percentile(const HabitValues *values, gint32 first_day, gint32 last_day, double fraction) {
+    guint first = habit_values_lower_bound(values, first_day);
+    guint end = habit_values_lower_bound(values, last_day + 1);
+    if (first >= end) return NAN;
+
+    guint count = end - first;
+    float *slice = g_new(float, count);
+    memcpy(slice, values->amounts + first, count * sizeof(float));
+    guint k = (guint)(fraction * (count - 1) + 0.5);
+    guint low = 0, high = count - 1;
+    while (low < high) {
+        float pivot = slice[(low + high) / 2];
+        guint i = low, j = high;
+        while (i <= j) {
+            while (slice[i] < pivot) i++;
+            while (slice[j] > pivot) j--;
+            if (i <= j) {
+                float swap = slice[i];
+                slice[i] = slice[j];
+                slice[j] = swap;
+                i++;
+                if (j == 0) break;
+                j--;
             }
         }
-        if (day_idx > 0 && app_data->timetable_grid) {
-            GtkWidget *task_box = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_idx, time_idx_timetable);
-            if (task_box) {
-                GtkWidget *habit_label = gtk_label_new(habit_name);
-                gtk_widget_set_halign(habit_label, GTK_ALIGN_START);
-                gtk_widget_add_css_class(habit_label, "habit-label");
-                gtk_box_append(GTK_BOX(task_box), habit_label);
-            }
+        if (k <= j) {
+            high = j;
+        } else if (k >= i) {
+            low = i;
+        } else {
+            break;
         }
-        token = strtok(NULL, ",");
     }
-    g_free(days_copy);
+    double result = slice[k];
+    g_free(slice);
+    return result;
+}
 
-    char query[256];
-    snprintf(query, sizeof(query),
-             "UPDATE habit_tracking SET days = '%s', time_slot = '%s' WHERE habit_name = '%s';",
-             days->str, time_slot, habit_name);
-    if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
-        g_printerr("Failed to update days and time for habit %s: %s\n", habit_name, sqlite3_errmsg(app_data->db));
-    }
+// app_data->habits keeps the display order; habits_by_id indexes the same
+// Habit structs by id and is kept in step by the two helpers below.
+static Habit *habit_find(AppData *app_data, gint64 id) {
+    return g_hash_table_lookup(app_data->habits_by_id, &id);
+}
 
-    g_string_free(days, TRUE);
+static void habits_append(AppData *app_data, Habit *habit) {
+    app_data->habits = g_list_append(app_data->habits, habit);
+    g_hash_table_insert(app_data->habits_by_id, &habit->id, habit);
 }
 
+static void habits_remove(AppData *app_data, Habit *habit) {
+    g_hash_table_remove(app_data->habits_by_id, &habit->id);
+    app_data->habits = g_list_remove(app_data->habits, habit);
+}
 
-static void on_add_habit_in_edit(GtkButton *button, gpointer data) {
-    AppData *app_data = (AppData *)g_object_get_data(G_OBJECT(button), "app_data");
-    GtkWidget *entry = (GtkWidget *)g_object_get_data(G_OBJECT(button), "entry");
-    GtkWidget *habits_grid = (GtkWidget *)g_object_get_data(G_OBJECT(button), "habits_grid");
-    GtkWidget *days_box_container = (GtkWidget *)g_object_get_data(G_OBJECT(button), "days_box");
-    GtkWidget *hour_dropdown_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "hour_dropdown");
+// The dashboard box of a habit; habit_boxes indexes app_data->habit_widgets.
+static GtkWidget *habit_box_find(AppData *app_data, gint64 habit_id) {
+    return g_hash_table_lookup(app_data->habit_boxes, &habit_id);
+}
 
-    const char *times[] = {
-        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
-        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
-        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
-    };
+static TaskEntry *task_entry_new(const char *task, const char *day, const char *time_slot) {
+    TaskEntry *entry = mem_alloc(MEM_MODEL, sizeof(TaskEntry));
+    entry->task = mem_strdup(MEM_MODEL, task ? task : "");
+    entry->day = mem_strdup(MEM_MODEL, day ? day : "");
+    entry->time_slot = mem_strdup(MEM_MODEL, time_slot ? time_slot : "");
+    return entry;
+}
 
-    const char *habit_name = gtk_editable_get_text(GTK_EDITABLE(entry));
-    if (habit_name && strlen(habit_name) > 0) {
-        GString *days_str_g = g_string_new("");
-        const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
-        GtkWidget *child_day_button = gtk_widget_get_first_child(days_box_container);
-        int day_idx_loop = 0;
-        while(child_day_button && day_idx_loop < 7){
-            if(GTK_IS_TOGGLE_BUTTON(child_day_button)){
-                if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(child_day_button))) {
-                    if (days_str_g->len > 0) g_string_append(days_str_g, ",");
-                    g_string_append(days_str_g, day_names[day_idx_loop]);
+static void task_entry_free(gpointer data) {
+    TaskEntry *entry = data;
+    if (!entry) return;
+    mem_free(entry->task);
+    mem_free(entry->day);
+    mem_free(entry->time_slot);
+    mem_free(entry);
+}
+
+static void tasks_model_remove(AppData *app_data, const char *task, const char *day, const char *time_slot) {
+    for (GList *iter = app_data->tasks; iter; iter = iter->next) {
+        TaskEntry *entry = iter->data;
+        if (strcmp(entry->task, task) == 0 && strcmp(entry->day, day) == 0 && strcmp(entry->time_slot, time_slot) == 0) {
+            task_entry_free(entry);
+            app_data->tasks = g_list_delete_link(app_data->tasks, iter);
+            return;
+        }
+    }
+}
+
+static void remove_task_from_timetable(AppData *app_data, const char *task, const char *day, const char *time_slot) {
+    int day_idx_map = weekday_index(day);
+    int time_idx_map = time_slot_index(time_slot);
+    if (app_data->timetable_grid && day_idx_map > 0 && time_idx_map > 0) {
+        GtkWidget *task_box_grid = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_idx_map, time_idx_map);
+        if (task_box_grid) {
+            GtkWidget *grid_child_label = gtk_widget_get_first_child(task_box_grid);
+            while (grid_child_label) {
+                GtkWidget *next_grid_child = gtk_widget_get_next_sibling(grid_child_label);
+                if (GTK_IS_LABEL(grid_child_label)) {
+                    const char *label_text_grid = gtk_label_get_text(GTK_LABEL(grid_child_label));
+                    if (strcmp(label_text_grid, task) == 0) {
+                        gtk_box_remove(GTK_BOX(task_box_grid), grid_child_label);
+                        break;
+                    }
                 }
-                day_idx_loop++;
+                grid_child_label = next_grid_child;
             }
-            child_day_button = gtk_widget_get_next_sibling(child_day_button);
         }
+    }
+}
 
+static const char *latency_action_names[LATENCY_ACTION_COUNT] = {"done-today", "mark-task-done"};
 
-        guint selected_time = gtk_drop_down_get_selected(GTK_DROP_DOWN(hour_dropdown_widget));
-        const char *time_slot = times[selected_time];
+static guint latency_bucket_index(gint64 value_us) {
+    value_us = CLAMP(value_us, 0, LATENCY_MAX_US - 1);
+    if (value_us < 2 * LATENCY_SUB_BUCKETS) return (guint)value_us;
+
+    guint shift = g_bit_storage((gulong)value_us) - 1 - LATENCY_SUB_BUCKET_BITS;
+    guint sub_bucket = (guint)(value_us >> shift) - LATENCY_SUB_BUCKETS;
+    return 2 * LATENCY_SUB_BUCKETS + (shift - 1) * LATENCY_SUB_BUCKETS + sub_bucket;
+}
 
-        app_data->habits = g_list_append(app_data->habits, g_strdup(habit_name));
+static gint64 latency_bucket_upper_bound(guint index) {
+    if (index < 2 * LATENCY_SUB_BUCKETS) return index;
 
-        GtkWidget *habit_box_main = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
-        GtkWidget *drawing_area = gtk_drawing_area_new();
-        gtk_widget_set_size_request(drawing_area, 60, 60);
-        gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(drawing_area), draw_habit_logo, g_strdup(habit_name), g_free);
-        g_object_set_data(G_OBJECT(drawing_area), "app_data", app_data);
-        g_object_set_data(G_OBJECT(drawing_area), "habit_name", g_strdup(habit_name));
-        gtk_box_append(GTK_BOX(habit_box_main), drawing_area);
+    guint shift = (index - 2 * LATENCY_SUB_BUCKETS) / LATENCY_SUB_BUCKETS + 1;
+    guint sub_bucket = (index - 2 * LATENCY_SUB_BUCKETS) % LATENCY_SUB_BUCKETS;
+    return ((gint64)(LATENCY_SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
 
-        g_object_set_data(G_OBJECT(habit_box_main), "habit_name", g_strdup(habit_name));
+static void latency_histogram_record(LatencyHistogram *histogram, gint64 value_us) {
+    histogram->counts[latency_bucket_index(value_us)]++;
+    if (histogram->total == 0 || value_us < histogram->min_us) histogram->min_us = value_us;
+    if (value_us > histogram->max_us) histogram->max_us = value_us;
+    histogram->sum_us += value_us;
+    histogram->total++;
+}
 
-        GtkWidget *label_main = gtk_label_new(habit_name);
-        gtk_widget_set_halign(label_main, GTK_ALIGN_CENTER);
-        gtk_box_append(GTK_BOX(habit_box_main), label_main);
+static gint64 latency_histogram_percentile(const LatencyHistogram *histogram, double percentile) {
+    if (histogram->total == 0) return 0;
 
-        GDateTime *today = g_date_time_new_now_local();
-        int day_of_week_today = g_date_time_get_day_of_week(today);
-        int adjusted_day_today = (day_of_week_today == 7) ? 6 : (day_of_week_today - 1);
-        const char *current_day_str = day_names[adjusted_day_today];
-        g_date_time_unref(today);
+    guint64 wanted = (guint64)(percentile / 100.0 * histogram->total + 0.5);
+    if (wanted == 0) wanted = 1;
+    guint64 seen = 0;
+    for (guint i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= wanted) return MIN(latency_bucket_upper_bound(i), histogram->max_us);
+    }
+    return histogram->max_us;
+}
 
-        if (strstr(days_str_g->str, current_day_str)) {
-            GtkWidget *done_button = gtk_button_new_with_label("Done Today");
-            g_object_set_data(G_OBJECT(done_button), "habit_name", g_strdup(habit_name));
-            g_object_set_data(G_OBJECT(done_button), "drawing_area", drawing_area);
-            g_signal_connect(done_button, "clicked", G_CALLBACK(on_done_today_clicked), app_data);
-            gtk_box_append(GTK_BOX(habit_box_main), done_button);
+static void latency_dump(AppData *app_data) {
+    g_print("%-16s %-14s %8s %9s %9s %9s %9s %9s\n",
+            "action", "span", "count", "p50(us)", "p90(us)", "p99(us)", "p99.9(us)", "max(us)");
+    for (int action = 0; action < LATENCY_ACTION_COUNT; action++) {
+        const LatencyHistogram *spans[] = {&app_data->commit_latency[action], &app_data->paint_latency[action]};
+        const char *span_names[] = {"click->commit", "click->paint"};
+        for (int i = 0; i < 2; i++) {
+            g_print("%-16s %-14s %8" G_GUINT64_FORMAT " %9" G_GINT64_FORMAT " %9" G_GINT64_FORMAT
+                    " %9" G_GINT64_FORMAT " %9" G_GINT64_FORMAT " %9" G_GINT64_FORMAT "\n",
+                    latency_action_names[action], span_names[i], spans[i]->total,
+                    latency_histogram_percentile(spans[i], 50.0),
+                    latency_histogram_percentile(spans[i], 90.0),
+                    latency_histogram_percentile(spans[i], 99.0),
+                    latency_histogram_percentile(spans[i], 99.9),
+                    spans[i]->max_us);
         }
+    }
+}
 
+static gboolean on_dump_latency_signal(gpointer data) {
+    latency_dump((AppData *)data);
+    return G_SOURCE_CONTINUE;
+}
 
-        gtk_box_append(GTK_BOX(app_data->habits_box), habit_box_main);
-        app_data->habit_widgets = g_list_append(app_data->habit_widgets, habit_box_main);
-
-        char query[256];
-        snprintf(query, sizeof(query),
-                 "INSERT OR IGNORE INTO habit_tracking (date, habit_name, completed, days, time_slot) VALUES ('', '%s', 0, '%s', '%s');",
-                 habit_name, days_str_g->str, time_slot);
-        if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
-            g_printerr("Failed to add habit to database: %s\n", sqlite3_errmsg(app_data->db));
-        }
+static void on_dump_latency_action(GSimpleAction *action, GVariant *parameter, gpointer data) {
+    latency_dump((AppData *)data);
+}
 
-        int time_idx_timetable = selected_time + 1;
-        char *days_copy = g_strdup(days_str_g->str);
-        char *token = strtok(days_copy, ",");
-        while (token) {
-            int day_idx_timetable = 0;
-            for (int i = 0; i < 7; i++) {
-                if (strcmp(day_names[i], token) == 0) {
-                    day_idx_timetable = i + 1;
-                    break;
-                }
-            }
-            if (day_idx_timetable > 0 && app_data->timetable_grid) {
-                GtkWidget *task_box = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_idx_timetable, time_idx_timetable);
-                if (task_box) {
-                    GtkWidget *habit_label_timetable = gtk_label_new(habit_name);
-                    gtk_widget_set_halign(habit_label_timetable, GTK_ALIGN_START);
-                    gtk_widget_add_css_class(habit_label_timetable, "habit-label");
-                    gtk_box_append(GTK_BOX(task_box), habit_label_timetable);
-                }
-            }
-            token = strtok(NULL, ",");
-        }
-        g_free(days_copy);
+// One in-flight interaction: stamped when the button handler starts, again
+// once its write has been committed, and finally by the first after-paint of
+// the frame clock that redraws the affected widget.
+typedef struct {
+    AppData *app_data;
+    LatencyAction action;
+    gint64 click_us;
+    GdkFrameClock *frame_clock;
+    gulong after_paint_handler;
+} LatencyProbe;
+
+static void latency_probe_free(LatencyProbe *probe) {
+    if (probe->frame_clock) {
+        g_signal_handler_disconnect(probe->frame_clock, probe->after_paint_handler);
+        g_object_unref(probe->frame_clock);
+    }
+    probe->app_data->latency_probes = g_list_remove(probe->app_data->latency_probes, probe);
+    g_free(probe);
+}
 
-        int next_row_grid = 0;
-        GtkWidget *grid_child = gtk_widget_get_first_child(habits_grid);
-        while(grid_child){
-            next_row_grid++;
-            grid_child = gtk_widget_get_next_sibling(grid_child);
-        }
-        if(next_row_grid == 0) next_row_grid = 1;
+static void on_latency_probe_painted(GdkFrameClock *frame_clock, LatencyProbe *probe) {
+    latency_histogram_record(&probe->app_data->paint_latency[probe->action],
+                             g_get_monotonic_time() - probe->click_us);
+    latency_probe_free(probe);
+}
 
+static void latency_probe_committed(AppData *app_data, LatencyAction action, gint64 click_us, GtkWidget *widget) {
+    latency_histogram_record(&app_data->commit_latency[action], g_get_monotonic_time() - click_us);
 
-        GtkWidget *row_box_edit = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-        GtkWidget *row_label_edit = gtk_label_new(habit_name);
-        gtk_widget_set_size_request(row_label_edit, 100, -1);
-        gtk_box_append(GTK_BOX(row_box_edit), row_label_edit);
+    GdkFrameClock *frame_clock = widget ? gtk_widget_get_frame_clock(widget) : NULL;
+    if (!frame_clock) return;
 
-        GtkWidget* day_buttons_in_row[7];
+    LatencyProbe *probe = g_new0(LatencyProbe, 1);
+    probe->app_data = app_data;
+    probe->action = action;
+    probe->click_us = click_us;
+    probe->frame_clock = g_object_ref(frame_clock);
+    probe->after_paint_handler = g_signal_connect(frame_clock, "after-paint", G_CALLBACK(on_latency_probe_painted), probe);
+    app_data->latency_probes = g_list_prepend(app_data->latency_probes, probe);
+    gtk_widget_queue_draw(widget);
+}
 
-        for (int i = 0; i < 7; i++) {
-            GtkWidget *day_button_edit = gtk_toggle_button_new_with_label(day_names[i]);
-            gtk_widget_set_size_request(day_button_edit, 50, -1);
-            if (strstr(days_str_g->str, day_names[i])) {
-                gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(day_button_edit), TRUE);
+// SQL profiler. Every statement is counted for the HUD; with
+// HABIT_TRACKER_SQL_PROFILE or HABIT_TRACKER_SLOW_QUERY_MS set, statements are
+// also timed and grouped by their text with literals replaced by '?', so the
+// many snprintf-built variants of one query share a single entry.
+#define SQL_SLOW_QUERY_DEFAULT_MS 50
+
+static char *sql_normalize(const char *sql) {
+    GString *normalized = g_string_sized_new(strlen(sql));
+    const char *c = sql;
+    while (*c) {
+        if (*c == '\'') {
+            c++;
+            while (*c && !(*c == '\'' && c[1] != '\'')) {
+                c += (*c == '\'') ? 2 : 1;
             }
-            g_object_set_data(G_OBJECT(day_button_edit), "app_data", app_data);
-            g_object_set_data(G_OBJECT(day_button_edit), "habit_name", g_strdup(habit_name));
-            day_buttons_in_row[i] = day_button_edit;
-            gtk_box_append(GTK_BOX(row_box_edit), day_button_edit);
+            if (*c) c++;
+            g_string_append_c(normalized, '?');
+        } else if (g_ascii_isdigit(*c) && (normalized->len == 0 ||
+                   !(g_ascii_isalnum(normalized->str[normalized->len - 1]) || normalized->str[normalized->len - 1] == '_'))) {
+            while (g_ascii_isdigit(*c) || *c == '.') c++;
+            g_string_append_c(normalized, '?');
+        } else {
+            g_string_append_c(normalized, *c++);
         }
+    }
+    return g_string_free(normalized, FALSE);
+}
 
-        GtkStringList *times_list_edit = gtk_string_list_new(NULL);
-        for (int i = 0; i < 12; i++) {
-            gtk_string_list_append(times_list_edit, times[i]);
-        }
-        GtkWidget *row_hour_dropdown_edit = gtk_drop_down_new(G_LIST_MODEL(times_list_edit), NULL);
-        gtk_drop_down_set_selected(GTK_DROP_DOWN(row_hour_dropdown_edit), selected_time);
-        gtk_widget_set_size_request(row_hour_dropdown_edit, 120, -1);
-        g_object_set_data(G_OBJECT(row_hour_dropdown_edit), "app_data", app_data);
-        g_object_set_data(G_OBJECT(row_hour_dropdown_edit), "habit_name", g_strdup(habit_name));
+static void sql_stats_free(gpointer data) {
+    SqlStatementStats *stats = data;
+    mem_free(stats->sql);
+    mem_free(stats);
+}
 
-        for(int i=0; i<7; ++i){
-            g_object_set_data(G_OBJECT(day_buttons_in_row[i]), "hour_dropdown", row_hour_dropdown_edit);
-            g_signal_connect(day_buttons_in_row[i], "toggled", G_CALLBACK(on_day_toggled), app_data);
-        }
-        g_signal_connect(row_hour_dropdown_edit, "notify::selected", G_CALLBACK(on_day_toggled), app_data);
+static void sql_profile_record(AppData *app_data, sqlite3_stmt *stmt, gint64 elapsed_ns) {
+    const char *sql = sqlite3_sql(stmt);
+    if (!sql) return;
+    char *normalized = sql_normalize(sql);
 
+    g_mutex_lock(&app_data->sql_profile_lock);
+    guint64 rows = GPOINTER_TO_UINT(g_hash_table_lookup(app_data->sql_running_rows, stmt));
+    g_hash_table_remove(app_data->sql_running_rows, stmt);
+    if (!sqlite3_stmt_readonly(stmt)) {
+        rows += sqlite3_changes(sqlite3_db_handle(stmt));
+    }
 
-        gtk_box_append(GTK_BOX(row_box_edit), row_hour_dropdown_edit);
+    SqlStatementStats *stats = g_hash_table_lookup(app_data->sql_stats, normalized);
+    if (!stats) {
+        stats = mem_alloc(MEM_STORAGE, sizeof(SqlStatementStats));
+        stats->sql = mem_strdup(MEM_STORAGE, normalized);
+        g_hash_table_insert(app_data->sql_stats, stats->sql, stats);
+    }
+    g_free(normalized);
+    stats->calls++;
+    stats->total_ns += elapsed_ns;
+    stats->max_ns = MAX(stats->max_ns, elapsed_ns);
+    stats->rows += rows;
+    g_mutex_unlock(&app_data->sql_profile_lock);
+
+    if (elapsed_ns >= app_data->sql_slow_threshold_ns) {
+        char *expanded = sqlite3_expanded_sql(stmt);
+        g_printerr("Slow query (%.2f ms, %" G_GUINT64_FORMAT " rows): %s\n",
+                   elapsed_ns / 1e6, rows, expanded ? expanded : sql);
+        sqlite3_free(expanded);
+    }
+}
 
-        GtkWidget *remove_button_edit = gtk_button_new_with_label("Remove");
-        g_object_set_data(G_OBJECT(remove_button_edit), "habit_name", g_strdup(habit_name));
-        g_object_set_data(G_OBJECT(remove_button_edit), "row", row_box_edit);
-        g_signal_connect(remove_button_edit, "clicked", G_CALLBACK(on_remove_habit), app_data);
-        gtk_box_append(GTK_BOX(row_box_edit), remove_button_edit);
+static int on_db_trace(unsigned int type, void *context, void *p, void *x) {
+    AppData *app_data = context;
+    switch (type) {
+        case SQLITE_TRACE_STMT:
+            app_data->db_statements++;
+            app_data->frame_db_queries++;
+            break;
+        case SQLITE_TRACE_ROW:
+            g_mutex_lock(&app_data->sql_profile_lock);
+            g_hash_table_insert(app_data->sql_running_rows, p,
+                                GUINT_TO_POINTER(GPOINTER_TO_UINT(g_hash_table_lookup(app_data->sql_running_rows, p)) + 1));
+            g_mutex_unlock(&app_data->sql_profile_lock);
+            break;
+        case SQLITE_TRACE_PROFILE:
+            sql_profile_record(app_data, (sqlite3_stmt *)p, *(sqlite3_int64 *)x);
+            break;
+    }
+    return 0;
+}
 
-        gtk_grid_attach(GTK_GRID(habits_grid), row_box_edit, 0, next_row_grid, 10, 1);
+static void sql_profile_setup(AppData *app_data) {
+    const char *profile_env = g_getenv("HABIT_TRACKER_SQL_PROFILE");
+    const char *slow_ms_env = g_getenv("HABIT_TRACKER_SLOW_QUERY_MS");
+    unsigned int mask = SQLITE_TRACE_STMT;
+
+    app_data->sql_profile_enabled = (profile_env && *profile_env) || (slow_ms_env && *slow_ms_env);
+    if (app_data->sql_profile_enabled) {
+        double slow_ms = slow_ms_env && *slow_ms_env ? g_ascii_strtod(slow_ms_env, NULL) : SQL_SLOW_QUERY_DEFAULT_MS;
+        app_data->sql_slow_threshold_ns = (gint64)(slow_ms * 1e6);
+        app_data->sql_stats = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, sql_stats_free);
+        app_data->sql_running_rows = g_hash_table_new(g_direct_hash, g_direct_equal);
+        mask |= SQLITE_TRACE_ROW | SQLITE_TRACE_PROFILE;
+    }
+    sqlite3_trace_v2(app_data->db, mask, on_db_trace, app_data);
+}
 
+static gint compare_sql_stats_by_total(gconstpointer a, gconstpointer b) {
+    const SqlStatementStats *stats_a = *(SqlStatementStats *const *)a;
+    const SqlStatementStats *stats_b = *(SqlStatementStats *const *)b;
+    return (stats_b->total_ns > stats_a->total_ns) - (stats_b->total_ns < stats_a->total_ns);
+}
 
-        gtk_editable_set_text(GTK_EDITABLE(entry), "");
-        child_day_button = gtk_widget_get_first_child(days_box_container);
-        day_idx_loop = 0;
-         while(child_day_button && day_idx_loop < 7){
-            if(GTK_IS_TOGGLE_BUTTON(child_day_button)){
-                gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(child_day_button), FALSE);
-                day_idx_loop++;
-            }
-            child_day_button = gtk_widget_get_next_sibling(child_day_button);
-        }
-        gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_widget), 0);
+static void sql_profile_report(AppData *app_data) {
+    if (!app_data->sql_stats) return;
 
-        g_string_free(days_str_g, TRUE);
-        g_object_unref(times_list_edit);
+    GPtrArray *sorted = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, app_data->sql_stats);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_ptr_array_add(sorted, value);
     }
+    g_ptr_array_sort(sorted, compare_sql_stats_by_total);
+
+    g_print("SQL profile (%u distinct statements)\n", sorted->len);
+    g_print("%8s %11s %10s %10s %10s  %s\n", "calls", "total(ms)", "avg(us)", "max(us)", "rows", "statement");
+    for (guint i = 0; i < sorted->len; i++) {
+        SqlStatementStats *stats = g_ptr_array_index(sorted, i);
+        g_print("%8" G_GUINT64_FORMAT " %11.2f %10.1f %10.1f %10" G_GUINT64_FORMAT "  %s\n",
+                stats->calls, stats->total_ns / 1e6, stats->total_ns / 1e3 / stats->calls,
+                stats->max_ns / 1e3, stats->rows, stats->sql);
+    }
+    g_ptr_array_free(sorted, TRUE);
 }
 
-static void on_edit_habits(GtkButton *button, AppData *app_data) {
-    GtkWidget *edit_window = gtk_window_new();
-    gtk_window_set_title(GTK_WINDOW(edit_window), "Edit Habits");
-    gtk_window_set_default_size(GTK_WINDOW(edit_window), 900, 600);
-    gtk_window_set_transient_for(GTK_WINDOW(edit_window), GTK_WINDOW(app_data->main_window));
-    gtk_window_set_modal(GTK_WINDOW(edit_window), TRUE);
-
-    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_widget_set_margin_start(vbox, 10);
-    gtk_widget_set_margin_end(vbox, 10);
-    gtk_widget_set_margin_top(vbox, 10);
-    gtk_widget_set_margin_bottom(vbox, 10);
-    gtk_window_set_child(GTK_WINDOW(edit_window), vbox);
+// Frame-time HUD. While visible it times each frame from before-paint to
+// after-paint on the main window's frame clock and refreshes its text twice
+// a second, so the HUD itself costs at most two extra frames per second.
+// The widget tree walk is only done for the current page, and at most
+// every HUD_WIDGET_COUNT_INTERVAL_US unless the page changes.
+#define HUD_REFRESH_INTERVAL_US (G_USEC_PER_SEC / 2)
+#define HUD_WIDGET_COUNT_INTERVAL_US (5 * G_USEC_PER_SEC)
 
-    GtkWidget *habits_grid = gtk_grid_new();
-    gtk_grid_set_row_spacing(GTK_GRID(habits_grid), 10);
-    gtk_grid_set_column_spacing(GTK_GRID(habits_grid), 5);
-    gtk_grid_set_column_homogeneous(GTK_GRID(habits_grid), TRUE);
 
+static guint count_widgets(GtkWidget *widget) {
+    guint count = 1;
+    for (GtkWidget *child = gtk_widget_get_first_child(widget); child; child = gtk_widget_get_next_sibling(child)) {
+        count += count_widgets(child);
+    }
+    return count;
+}
 
-    const char *labels[] = {"Habit", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun", "Time Slot", "Action"};
-    for (int i = 0; i < 10; i++) {
-        GtkWidget *label = gtk_label_new(labels[i]);
-        gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
-        gtk_grid_attach(GTK_GRID(habits_grid), label, i, 0, 1, 1);
+static void hud_refresh(AppData *app_data) {
+    GString *text = g_string_new("");
+    double avg_ms = app_data->hud_frames ? app_data->hud_frame_time_sum_us / 1000.0 / app_data->hud_frames : 0.0;
+    g_string_append_printf(text, "frame  %.1f ms avg  %.1f ms max  %.1f fps\n",
+                           avg_ms, app_data->hud_frame_time_max_us / 1000.0,
+                           gdk_frame_clock_get_fps(app_data->hud_frame_clock));
+    g_string_append_printf(text, "draw callbacks/frame  max %u\n", app_data->hud_draw_calls_max);
+    g_string_append_printf(text, "DB queries/frame  max %u", app_data->hud_db_queries_max);
+
+    int current = gtk_notebook_get_current_page(GTK_NOTEBOOK(app_data->notebook));
+    GtkWidget *page = gtk_notebook_get_nth_page(GTK_NOTEBOOK(app_data->notebook), current);
+    gint64 now_us = g_get_monotonic_time();
+    if (page != app_data->hud_counted_page ||
+        now_us - app_data->hud_widget_count_us >= HUD_WIDGET_COUNT_INTERVAL_US) {
+        app_data->hud_counted_page = page;
+        app_data->hud_widget_count = page ? count_widgets(page) : 0;
+        app_data->hud_widget_count_us = now_us;
+    }
+    if (page) {
+        g_string_append_printf(text, "\nwidgets  %s: %u",
+                               gtk_notebook_get_tab_label_text(GTK_NOTEBOOK(app_data->notebook), page),
+                               app_data->hud_widget_count);
     }
+    gtk_label_set_text(GTK_LABEL(app_data->hud_label), text->str);
+    g_string_free(text, TRUE);
+
+    app_data->hud_frames = 0;
+    app_data->hud_frame_time_sum_us = 0;
+    app_data->hud_frame_time_max_us = 0;
+    app_data->hud_draw_calls_max = 0;
+    app_data->hud_db_queries_max = 0;
+}
 
-    int current_row_idx = 1;
-    const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
-    const char *times[] = {
-        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
-        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
-        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
-    };
+static void on_hud_before_paint(GdkFrameClock *frame_clock, AppData *app_data) {
+    app_data->hud_paint_start_us = g_get_monotonic_time();
+}
 
-    for (GList *iter = app_data->habits; iter; iter = iter->next) {
-        const char *habit_name = (const char *)iter->data;
-        GtkWidget *row_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+static void on_hud_after_paint(GdkFrameClock *frame_clock, AppData *app_data) {
+    gint64 now_us = g_get_monotonic_time();
+    if (app_data->hud_paint_start_us) {
+        gint64 frame_time_us = now_us - app_data->hud_paint_start_us;
+        app_data->hud_frames++;
+        app_data->hud_frame_time_sum_us += frame_time_us;
+        app_data->hud_frame_time_max_us = MAX(app_data->hud_frame_time_max_us, frame_time_us);
+        app_data->hud_paint_start_us = 0;
+    }
+    app_data->hud_draw_calls_max = MAX(app_data->hud_draw_calls_max, app_data->frame_draw_calls);
+    app_data->hud_db_queries_max = MAX(app_data->hud_db_queries_max, app_data->frame_db_queries);
+    app_data->frame_draw_calls = 0;
+    app_data->frame_db_queries = 0;
+
+    if (now_us - app_data->hud_last_refresh_us >= HUD_REFRESH_INTERVAL_US) {
+        app_data->hud_last_refresh_us = now_us;
+        hud_refresh(app_data);
+    }
+}
 
-        GtkWidget *label = gtk_label_new(habit_name);
-         gtk_widget_set_hexpand(label, TRUE);
-        gtk_widget_set_halign(label, GTK_ALIGN_START);
-        gtk_box_append(GTK_BOX(row_box), label);
+static void hud_stop(AppData *app_data) {
+    if (app_data->hud_frame_clock) {
+        g_signal_handler_disconnect(app_data->hud_frame_clock, app_data->hud_before_paint_handler);
+        g_signal_handler_disconnect(app_data->hud_frame_clock, app_data->hud_after_paint_handler);
+        g_object_unref(app_data->hud_frame_clock);
+        app_data->hud_frame_clock = NULL;
+    }
+}
 
+// Metrics export for node-exporter's textfile collector. When
+// HABIT_TRACKER_METRICS_FILE is set, the registry below is sampled every
+// HABIT_TRACKER_METRICS_INTERVAL seconds (default 15) and written in the
+// Prometheus text format; g_file_set_contents renames a temporary file into
+// place so the collector never reads a half-written file.
+#define METRICS_DEFAULT_INTERVAL_S 15
+
+typedef enum {
+    METRIC_DB_QUERIES,
+    METRIC_DB_CACHE_HITS,
+    METRIC_DB_CACHE_MISSES,
+    METRIC_DB_CACHE_HIT_RATIO,
+    METRIC_RESIDENT_MEMORY,
+    METRIC_HABITS,
+    METRIC_PENDING_TASKS,
+    METRIC_COMPLETED_TASKS,
+    METRIC_STARTUP_FIRST_FRAME,
+    METRIC_STARTUP_LOADED,
+    METRIC_COUNT
+} MetricId;
 
-        char query[256];
-        snprintf(query, sizeof(query), "SELECT days, time_slot FROM habit_tracking WHERE habit_name = '%s' AND (date = '' OR date IS NULL);", habit_name);
-        sqlite3_stmt *stmt;
-        const char *days_str = "";
-        const char *time_slot_str = "";
-        if (sqlite3_prepare_v2(app_data->db, query, -1, &stmt, NULL) == SQLITE_OK) {
-            if (sqlite3_step(stmt) == SQLITE_ROW) {
-                const char *db_days = (const char *)sqlite3_column_text(stmt, 0);
-                const char *db_time = (const char *)sqlite3_column_text(stmt, 1);
-                if (db_days) days_str = db_days;
-                if (db_time) time_slot_str = db_time;
-            }
+typedef struct {
+    const char *name;
+    const char *type;
+    const char *help;
+} MetricInfo;
+
+static const MetricInfo metric_info[METRIC_COUNT] = {
+    {"habit_tracker_db_queries_total", "counter", "SQLite statements executed on the UI connection."},
+    {"habit_tracker_db_cache_hits_total", "counter", "SQLite page cache hits."},
+    {"habit_tracker_db_cache_misses_total", "counter", "SQLite page cache misses."},
+    {"habit_tracker_db_cache_hit_ratio", "gauge", "SQLite page cache hits over lookups."},
+    {"habit_tracker_resident_memory_bytes", "gauge", "Resident set size of the process."},
+    {"habit_tracker_habits", "gauge", "Habits in the in-memory model."},
+    {"habit_tracker_pending_tasks", "gauge", "Rows in the Pending Tasks list."},
+    {"habit_tracker_completed_tasks", "gauge", "Rows in the Completed Tasks list."},
+    {"habit_tracker_startup_first_frame_seconds", "gauge", "Process start to first painted frame."},
+    {"habit_tracker_startup_loaded_seconds", "gauge", "Process start to all startup data materialized."},
+};
+
+static double metrics_resident_memory_bytes(void) {
+    char *statm = NULL;
+    double bytes = 0.0;
+    if (g_file_get_contents("/proc/self/statm", &statm, NULL, NULL)) {
+        unsigned long size_pages = 0, resident_pages = 0;
+        if (sscanf(statm, "%lu %lu", &size_pages, &resident_pages) == 2) {
+            bytes = (double)resident_pages * sysconf(_SC_PAGESIZE);
         }
-        sqlite3_finalize(stmt);
-
-        GtkWidget* day_buttons_in_row[7];
+        g_free(statm);
+    }
+    return bytes;
+}
 
-        for (int i = 0; i < 7; i++) {
-            GtkWidget *day_button = gtk_toggle_button_new_with_label(day_names[i]);
-            if (strstr(days_str, day_names[i])) {
-                gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(day_button), TRUE);
-            }
-            g_object_set_data(G_OBJECT(day_button), "app_data", app_data);
-            g_object_set_data(G_OBJECT(day_button), "habit_name", g_strdup(habit_name));
-            day_buttons_in_row[i] = day_button;
-            gtk_box_append(GTK_BOX(row_box), day_button);
-        }
-
-        GtkStringList *times_list = gtk_string_list_new(NULL);
-        int selected_time = 0;
-        for (int i = 0; i < 12; i++) {
-            gtk_string_list_append(times_list, times[i]);
-            if (strcmp(time_slot_str, times[i]) == 0) {
-                selected_time = i;
-            }
-        }
-        GtkWidget *hour_dropdown = gtk_drop_down_new(G_LIST_MODEL(times_list), NULL);
-        gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown), selected_time);
-        g_object_set_data(G_OBJECT(hour_dropdown), "app_data", app_data);
-        g_object_set_data(G_OBJECT(hour_dropdown), "habit_name", g_strdup(habit_name));
+static guint count_children(GtkWidget *widget) {
+    guint count = 0;
+    for (GtkWidget *child = gtk_widget_get_first_child(widget); child; child = gtk_widget_get_next_sibling(child)) {
+        count++;
+    }
+    return count;
+}
 
-        for(int i=0; i<7; ++i){
-            g_object_set_data(G_OBJECT(day_buttons_in_row[i]), "hour_dropdown", hour_dropdown);
-            g_signal_connect(day_buttons_in_row[i], "toggled", G_CALLBACK(on_day_toggled), app_data);
-        }
-        g_signal_connect(hour_dropdown, "notify::selected", G_CALLBACK(on_day_toggled), app_data);
+static void metrics_collect(AppData *app_data, double values[METRIC_COUNT]) {
+    int cache_hits = 0, cache_misses = 0, highwater = 0;
+    if (app_data->db) {
+        sqlite3_db_status(app_data->db, SQLITE_DBSTATUS_CACHE_HIT, &cache_hits, &highwater, 0);
+        sqlite3_db_status(app_data->db, SQLITE_DBSTATUS_CACHE_MISS, &cache_misses, &highwater, 0);
+    }
 
-        gtk_box_append(GTK_BOX(row_box), hour_dropdown);
+    values[METRIC_DB_QUERIES] = (double)app_data->db_statements;
+    values[METRIC_DB_CACHE_HITS] = cache_hits;
+    values[METRIC_DB_CACHE_MISSES] = cache_misses;
+    values[METRIC_DB_CACHE_HIT_RATIO] = cache_hits + cache_misses ? (double)cache_hits / (cache_hits + cache_misses) : 0.0;
+    values[METRIC_RESIDENT_MEMORY] = metrics_resident_memory_bytes();
+    values[METRIC_HABITS] = g_list_length(app_data->habits);
+    values[METRIC_PENDING_TASKS] = count_children(app_data->pending_tasks_box);
+    values[METRIC_COMPLETED_TASKS] = count_children(app_data->completed_tasks_box);
+    values[METRIC_STARTUP_FIRST_FRAME] = app_data->first_frame_us ? (app_data->first_frame_us - app_data->startup_us) / 1e6 : 0.0;
+    values[METRIC_STARTUP_LOADED] = app_data->loaded_us ? (app_data->loaded_us - app_data->startup_us) / 1e6 : 0.0;
+}
 
-        GtkWidget *remove_button = gtk_button_new_with_label("Remove");
-        g_object_set_data(G_OBJECT(remove_button), "habit_name", g_strdup(habit_name));
-        g_object_set_data(G_OBJECT(remove_button), "row", row_box);
-        g_signal_connect(remove_button, "clicked", G_CALLBACK(on_remove_habit), app_data);
-        gtk_box_append(GTK_BOX(row_box), remove_button);
+static void metrics_write(AppData *app_data) {
+    double values[METRIC_COUNT];
+    metrics_collect(app_data, values);
 
-        gtk_grid_attach(GTK_GRID(habits_grid), row_box, 0, current_row_idx++, 10, 1);
-        g_object_unref(times_list);
+    GString *out = g_string_new("");
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        g_string_append_printf(out, "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n",
+                               metric_info[i].name, metric_info[i].help,
+                               metric_info[i].name, metric_info[i].type,
+                               metric_info[i].name, values[i]);
     }
 
+    g_string_append(out, "# HELP habit_tracker_commit_latency_seconds Click to committed write.\n"
+                         "# TYPE habit_tracker_commit_latency_seconds summary\n");
+    const double quantiles[] = {0.5, 0.9, 0.99};
+    for (int action = 0; action < LATENCY_ACTION_COUNT; action++) {
+        const LatencyHistogram *histogram = &app_data->commit_latency[action];
+        for (guint i = 0; i < G_N_ELEMENTS(quantiles); i++) {
+            g_string_append_printf(out, "habit_tracker_commit_latency_seconds{action=\"%s\",quantile=\"%g\"} %.6f\n",
+                                   latency_action_names[action], quantiles[i],
+                                   latency_histogram_percentile(histogram, quantiles[i] * 100.0) / 1e6);
+        }
+        g_string_append_printf(out, "habit_tracker_commit_latency_seconds_sum{action=\"%s\"} %.6f\n"
+                                    "habit_tracker_commit_latency_seconds_count{action=\"%s\"} %" G_GUINT64_FORMAT "\n",
+                               latency_action_names[action], histogram->sum_us / 1e6,
+                               latency_action_names[action], histogram->total);
+    }
 
-    GtkWidget *scrolled_window = gtk_scrolled_window_new();
-    gtk_widget_set_vexpand(scrolled_window, TRUE);
-    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scrolled_window), habits_grid);
-    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window),
-                                   GTK_POLICY_AUTOMATIC,
-                                   GTK_POLICY_AUTOMATIC);
-    gtk_box_append(GTK_BOX(vbox), scrolled_window);
+    g_string_append(out, "# HELP habit_tracker_widgets Widgets per notebook page.\n"
+                         "# TYPE habit_tracker_widgets gauge\n");
+    int n_pages = gtk_notebook_get_n_pages(GTK_NOTEBOOK(app_data->notebook));
+    for (int i = 0; i < n_pages; i++) {
+        GtkWidget *page = gtk_notebook_get_nth_page(GTK_NOTEBOOK(app_data->notebook), i);
+        g_string_append_printf(out, "habit_tracker_widgets{page=\"%s\"} %u\n",
+                               gtk_notebook_get_tab_label_text(GTK_NOTEBOOK(app_data->notebook), page),
+                               count_widgets(page));
+    }
 
-    GtkWidget *separator = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
-    gtk_box_append(GTK_BOX(vbox), separator);
+    g_string_append(out, "# HELP habit_tracker_tracked_bytes Live bytes allocated per subsystem.\n"
+                         "# TYPE habit_tracker_tracked_bytes gauge\n");
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        g_string_append_printf(out, "habit_tracker_tracked_bytes{subsystem=\"%s\"} %" G_GSSIZE_FORMAT "\n",
+                               mem_subsystem_names[i], (gssize)g_atomic_pointer_get(&mem_live_bytes[i]));
+    }
 
-    GtkWidget *add_box_outer = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_box_append(GTK_BOX(vbox), add_box_outer);
+    GError *error = NULL;
+    if (!g_file_set_contents(app_data->metrics_path, out->str, out->len, &error)) {
+        g_printerr("Failed to write metrics to %s: %s\n", app_data->metrics_path, error->message);
+        g_error_free(error);
+    }
+    g_string_free(out, TRUE);
+}
 
-    GtkWidget *add_habit_heading = gtk_label_new("Add New Habit");
-    gtk_widget_add_css_class(add_habit_heading, "heading");
-    gtk_widget_set_halign(add_habit_heading, GTK_ALIGN_CENTER);
-    gtk_box_append(GTK_BOX(add_box_outer), add_habit_heading);
+static gboolean on_metrics_timeout(gpointer data) {
+    metrics_write((AppData *)data);
+    return G_SOURCE_CONTINUE;
+}
 
-    GtkWidget *add_box_fields = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-    gtk_box_append(GTK_BOX(add_box_outer), add_box_fields);
+static void metrics_setup(AppData *app_data) {
+    const char *path = g_getenv("HABIT_TRACKER_METRICS_FILE");
+    if (!path || !*path) return;
 
+    const char *interval_env = g_getenv("HABIT_TRACKER_METRICS_INTERVAL");
+    guint interval_s = interval_env ? (guint)g_ascii_strtoull(interval_env, NULL, 10) : 0;
+    if (interval_s == 0) interval_s = METRICS_DEFAULT_INTERVAL_S;
 
-    GtkWidget *habit_entry = gtk_entry_new();
-    gtk_entry_set_placeholder_text(GTK_ENTRY(habit_entry), "Enter new habit name...");
-    gtk_widget_set_hexpand(habit_entry, TRUE);
-    gtk_box_append(GTK_BOX(add_box_fields), habit_entry);
+    app_data->metrics_path = g_strdup(path);
+    app_data->metrics_source = g_timeout_add_seconds(interval_s, on_metrics_timeout, app_data);
+}
 
-    GtkWidget *days_box_new = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-    for (int i = 0; i < 7; i++) {
-        GtkWidget *day_button = gtk_toggle_button_new_with_label(day_names[i]);
-        gtk_box_append(GTK_BOX(days_box_new), day_button);
+static gboolean memory_panel_refresh(gpointer data) {
+    AppData *app_data = data;
+    char *report = mem_format_report();
+    guint habit_count = g_list_length(app_data->habits);
+    gssize per_habit_bytes = 0;
+    for (int i = MEM_MODEL; i < MEM_SUBSYSTEM_COUNT; i++) {
+        per_habit_bytes += (gssize)g_atomic_pointer_get(&mem_live_bytes[i]);
     }
-    gtk_box_append(GTK_BOX(add_box_fields), days_box_new);
+    char *text = g_strdup_printf("%s\n\nhabits %u, %.0f tracked bytes per habit", report, habit_count,
+                                 habit_count ? (double)per_habit_bytes / habit_count : 0.0);
+    gtk_label_set_text(GTK_LABEL(app_data->memory_panel_label), text);
+    g_free(text);
+    g_free(report);
+    return G_SOURCE_CONTINUE;
+}
 
-    GtkStringList *times_list_new = gtk_string_list_new(NULL);
-    for (int i = 0; i < 12; i++) {
-        gtk_string_list_append(times_list_new, times[i]);
+static void on_memory_panel_destroy(GtkWidget *panel, AppData *app_data) {
+    if (app_data->memory_panel_source) {
+        g_source_remove(app_data->memory_panel_source);
+        app_data->memory_panel_source = 0;
     }
-    GtkWidget *hour_dropdown_new = gtk_drop_down_new(G_LIST_MODEL(times_list_new), NULL);
-    gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_new), 0);
-    gtk_box_append(GTK_BOX(add_box_fields), hour_dropdown_new);
+    app_data->memory_panel = NULL;
+    app_data->memory_panel_label = NULL;
+}
 
-    GtkWidget *add_button_bottom = gtk_button_new_with_label("Add Habit");
-    g_object_set_data(G_OBJECT(add_button_bottom), "app_data", app_data);
-    g_object_set_data(G_OBJECT(add_button_bottom), "entry", habit_entry);
-    g_object_set_data(G_OBJECT(add_button_bottom), "habits_grid", habits_grid);
-    g_object_set_data(G_OBJECT(add_button_bottom), "days_box", days_box_new);
-    g_object_set_data(G_OBJECT(add_button_bottom), "hour_dropdown", hour_dropdown_new);
-    g_signal_connect(add_button_bottom, "clicked", G_CALLBACK(on_add_habit_in_edit), app_data);
-    gtk_box_append(GTK_BOX(add_box_outer), add_button_bottom);
-    gtk_widget_set_halign(add_button_bottom, GTK_ALIGN_CENTER);
+static void on_memory_panel_action(GSimpleAction *action, GVariant *parameter, gpointer data) {
+    AppData *app_data = data;
+    if (app_data->memory_panel) {
+        gtk_window_destroy(GTK_WINDOW(app_data->memory_panel));
+        return;
+    }
 
+    app_data->memory_panel = gtk_window_new();
+    gtk_window_set_title(GTK_WINDOW(app_data->memory_panel), "Memory");
+    gtk_window_set_transient_for(GTK_WINDOW(app_data->memory_panel), GTK_WINDOW(app_data->main_window));
+    gtk_window_set_default_size(GTK_WINDOW(app_data->memory_panel), 420, 200);
+
+    app_data->memory_panel_label = gtk_label_new("");
+    gtk_widget_add_css_class(app_data->memory_panel_label, "hud");
+    gtk_widget_set_halign(app_data->memory_panel_label, GTK_ALIGN_START);
+    gtk_widget_set_valign(app_data->memory_panel_label, GTK_ALIGN_START);
+    gtk_window_set_child(GTK_WINDOW(app_data->memory_panel), app_data->memory_panel_label);
+
+    memory_panel_refresh(app_data);
+    app_data->memory_panel_source = g_timeout_add_seconds(1, memory_panel_refresh, app_data);
+    g_signal_connect(app_data->memory_panel, "destroy", G_CALLBACK(on_memory_panel_destroy), app_data);
+    gtk_window_present(GTK_WINDOW(app_data->memory_panel));
+}
 
-    GtkWidget *separator2 = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
-    gtk_box_append(GTK_BOX(vbox), separator2);
+// Ctrl+Shift+R adds 7/30/365-day completion counts under each badge number.
+static void on_rolling_counts_action(GSimpleAction *action, GVariant *parameter, gpointer data) {
+    AppData *app_data = data;
+    app_data->show_rolling_counts = !app_data->show_rolling_counts;
+    for (GList *iter = app_data->habit_widgets; iter; iter = iter->next) {
+        GtkWidget *drawing_area = gtk_widget_get_first_child(GTK_WIDGET(iter->data));
+        if (drawing_area) gtk_widget_queue_draw(drawing_area);
+    }
+}
 
-    GtkWidget *save_button = gtk_button_new_with_label("Close");
-    gtk_widget_set_halign(save_button, GTK_ALIGN_END);
-    g_signal_connect_swapped(save_button, "clicked", G_CALLBACK(gtk_window_destroy), edit_window);
-    gtk_box_append(GTK_BOX(vbox), save_button);
+static void on_toggle_hud_action(GSimpleAction *action, GVariant *parameter, gpointer data) {
+    AppData *app_data = data;
+    if (gtk_widget_get_visible(app_data->hud_label)) {
+        hud_stop(app_data);
+        gtk_widget_set_visible(app_data->hud_label, FALSE);
+        return;
+    }
 
-    gtk_window_present(GTK_WINDOW(edit_window));
-    g_object_unref(times_list_new);
+    GdkFrameClock *frame_clock = gtk_widget_get_frame_clock(app_data->main_window);
+    if (!frame_clock) return;
+
+    app_data->hud_frame_clock = g_object_ref(frame_clock);
+    app_data->hud_before_paint_handler = g_signal_connect(frame_clock, "before-paint", G_CALLBACK(on_hud_before_paint), app_data);
+    app_data->hud_after_paint_handler = g_signal_connect(frame_clock, "after-paint", G_CALLBACK(on_hud_after_paint), app_data);
+    app_data->hud_paint_start_us = 0;
+    app_data->hud_last_refresh_us = 0;
+    app_data->hud_counted_page = NULL;
+    app_data->frame_draw_calls = 0;
+    app_data->frame_db_queries = 0;
+    gtk_widget_set_visible(app_data->hud_label, TRUE);
 }
 
 
-static void on_mark_task_done(GtkButton *button, AppData *app_data) {
-    const char *task = (const char *)g_object_get_data(G_OBJECT(button), "task");
-    const char *day = (const char *)g_object_get_data(G_OBJECT(button), "day");
-    const char *time_slot = (const char *)g_object_get_data(G_OBJECT(button), "time_slot");
-    GtkWidget *task_row = (GtkWidget *)g_object_get_data(G_OBJECT(button), "task_row");
-    GtkWidget *task_label_timetable = (GtkWidget *)g_object_get_data(G_OBJECT(button), "task_label_timetable");
 
+// Cold history. Completions older than the hot horizon (ARCHIVE_HOT_DAYS_DEFAULT
+// days, or HABIT_TRACKER_HOT_DAYS) live in HABIT_ARCHIVE_DB_PATH, attached to
+// every connection as "archive", so habit_tracker.db only carries the recent
+// rows the dashboard reads. archive.habit_totals keeps each habit's archived
+// completion count, which lifetime counts add to the hot rows instead of
+// scanning the archive; the temp view all_completions spans both files for
+// queries that need individual days. A day present in both files (see
+// archive_thread) is taken from the hot file only.
+#define ARCHIVE_HOT_DAYS_DEFAULT 365
+#define ARCHIVE_CHUNK_ROWS 500
+
+#define COMPLETIONS_TABLE_COLUMNS \
+    "habit_id INTEGER NOT NULL, day INTEGER NOT NULL, completed INTEGER NOT NULL, PRIMARY KEY (habit_id, day)"
+#define ARCHIVE_TOTALS_TABLE_COLUMNS \
+    "habit_id INTEGER PRIMARY KEY, completed_days INTEGER NOT NULL, first_day INTEGER, last_day INTEGER"
+
+static gboolean completions_view_create(sqlite3 *db) {
+    const char *view_sql =
+        "CREATE TEMP VIEW IF NOT EXISTS all_completions AS "
+        "SELECT habit_id, day, completed FROM main.habit_completions UNION ALL "
+        "SELECT habit_id, day, completed FROM archive.habit_completions AS a WHERE NOT EXISTS "
+        "(SELECT 1 FROM main.habit_completions AS m WHERE m.habit_id = a.habit_id AND m.day = a.day);";
+    if (sqlite3_exec(db, view_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create all_completions view: %s\n", sqlite3_errmsg(db));
+        return FALSE;
+    }
+    return TRUE;
+}
 
-    if (task_label_timetable && gtk_widget_get_parent(task_label_timetable)) {
-        gtk_box_remove(GTK_BOX(gtk_widget_get_parent(task_label_timetable)), task_label_timetable);
+static gboolean archive_attach(sqlite3 *db) {
+    char attach_sql[256];
+    snprintf(attach_sql, sizeof(attach_sql), "ATTACH DATABASE '%s' AS archive;", HABIT_ARCHIVE_DB_PATH);
+    if (sqlite3_exec(db, attach_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        return FALSE;
     }
+    return completions_view_create(db);
+}
 
+// Reads the schedule versions of the habits in habits_by_id (keyed by id).
+// habit_id limits the query to one habit; 0 loads them all.
+static void habit_schedules_load(sqlite3 *db, GHashTable *habits_by_id, gint64 habit_id) {
+    sqlite3_stmt *stmt;
+    const char *sql = habit_id ? "SELECT habit_id, from_day, days_mask FROM habit_schedules "
+                                 "WHERE habit_id = ?1 ORDER BY from_day;"
+                               : "SELECT habit_id, from_day, days_mask FROM habit_schedules ORDER BY habit_id, from_day;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        if (habit_id) sqlite3_bind_int64(stmt, 1, habit_id);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            gint64 row_habit_id = sqlite3_column_int64(stmt, 0);
+            Habit *habit = g_hash_table_lookup(habits_by_id, &row_habit_id);
+            if (habit) habit_schedule_set(habit, sqlite3_column_int(stmt, 1), sqlite3_column_int(stmt, 2));
+        }
+    } else {
+        g_printerr("Cannot load habit schedules: %s\n", sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(stmt);
 
-    if (task_row && gtk_widget_get_parent(task_row)){
-        gtk_box_remove(GTK_BOX(app_data->pending_tasks_box), task_row);
+    GHashTableIter iter;
+    Habit *habit;
+    g_hash_table_iter_init(&iter, habits_by_id);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&habit)) {
+        habit_schedule_ensure(habit);
     }
+}
 
+// Fills the rolling counters of the habits in habits_by_id (keyed by id)
+// from source, all_completions or main.habit_completions. habit_id limits
+// the query to one habit; 0 loads them all.
+static void habit_counters_load(sqlite3 *db, const char *source, GHashTable *habits_by_id, gint64 habit_id) {
+    gint32 base_day = habit_counter_base_for(day_number_today());
+    GHashTableIter iter;
+    Habit *habit;
+    g_hash_table_iter_init(&iter, habits_by_id);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&habit)) {
+        habit_counter_reset(habit, base_day);
+    }
 
-    char insert_query[512];
-    snprintf(insert_query, sizeof(insert_query),
-             "INSERT INTO completed_tasks (task, day, time_slot) VALUES ('%s', '%s', '%s');",
-             task, day, time_slot);
-    if (sqlite3_exec(app_data->db, insert_query, NULL, NULL, NULL) != SQLITE_OK) {
-        g_printerr("Failed to insert task into completed_tasks: %s\n", sqlite3_errmsg(app_data->db));
+    // Separate statements for one habit and for all of them, so the single
+    // habit query can seek on the (habit_id, day) key.
+    char query[256];
+    snprintf(query, sizeof(query), "SELECT habit_id, day FROM %s WHERE completed = 1 AND day >= ?1%s;",
+             source, habit_id ? " AND habit_id = ?2" : "");
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, query, -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, base_day);
+        if (habit_id) sqlite3_bind_int64(stmt, 2, habit_id);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            gint64 row_habit_id = sqlite3_column_int64(stmt, 0);
+            habit = g_hash_table_lookup(habits_by_id, &row_habit_id);
+            if (habit) habit_counter_add(habit, sqlite3_column_int(stmt, 1), 1);
+        }
+    } else {
+        g_printerr("Cannot load rolling counters: %s\n", sqlite3_errmsg(db));
     }
+    sqlite3_finalize(stmt);
 
-    char delete_query[512];
-    snprintf(delete_query, sizeof(delete_query),
-             "DELETE FROM timetable_tasks WHERE task = '%s' AND day = '%s' AND time_slot = '%s';",
-             task, day, time_slot);
-    if (sqlite3_exec(app_data->db, delete_query, NULL, NULL, NULL) != SQLITE_OK) {
-         g_printerr("Failed to delete task from timetable_tasks: %s\n", sqlite3_errmsg(app_data->db));
+    gint32 today = day_number_today();
+    g_hash_table_iter_init(&iter, habits_by_id);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&habit)) {
+        habit_strength_recompute(habit, today);
+        habit_quota_recompute(habit, today);
     }
+}
 
-    char task_display[512];
-    snprintf(task_display, sizeof(task_display), "%s (%s, %s)", task, day, time_slot);
-    GtkWidget *completed_task_label = gtk_label_new(task_display);
-    gtk_widget_set_halign(completed_task_label, GTK_ALIGN_START);
-    gtk_box_append(GTK_BOX(app_data->completed_tasks_box), completed_task_label);
+// Analytics. Per habit, completion rates by weekday and by calendar month
+// come from the history bitmaps; per time slot they are summed over the
+// habits in that slot. Habits are split into ANALYTICS_HABITS_PER_JOB
+// batches for a GThreadPool with one thread per core, and each job only
+// writes its own HabitStats. Counting is popcount over 64-day words, with
+// one of seven precomputed masks picking out a weekday from a word. The
+// pool is driven from a GTask worker that gets a copy of the histories,
+// and the page is built when it returns. The result stays cached in
+// app_data->analytics until analytics_invalidate().
+#define ANALYTICS_HABITS_PER_JOB 64
 
-    g_free((char *)task);
-    g_free((char *)day);
-    g_free((char *)time_slot);
-}
+typedef struct {
+    HistoryBitmap *histories;
+    guint habit_count;
+    AnalyticsResult *result;
+    gint32 today;
+} AnalyticsInput;
 
 typedef struct {
-    AppData *app_data;
-    const char *day;
-    const char *time_slot;
-    GtkWidget *task_box_in_grid;
-    GtkWidget *dialog;
-    GtkWidget *entry;
-} TaskDialogData;
+    const HistoryBitmap *histories;
+    HabitStats *stats;
+    guint count;
+    gint32 today;
+    GCancellable *cancellable;
+} AnalyticsJob;
+
+// analytics_weekday_masks[phase][weekday] selects the bits of a word whose
+// first day falls on weekday phase that land on weekday.
+static guint64 analytics_weekday_masks[7][7];
+
+static void analytics_masks_init(void) {
+    if (analytics_weekday_masks[0][0]) return;
+    for (int phase = 0; phase < 7; phase++) {
+        for (int bit = 0; bit < 64; bit++) {
+            analytics_weekday_masks[phase][(phase + bit) % 7] |= (guint64)1 << bit;
+        }
+    }
+}
 
+static void habit_stats_compute(const HistoryBitmap *history, gint32 today, HabitStats *stats) {
+    if (!history || !history->bits) return;
+    gint32 start = history_first_completed_day(history);
+    if (start > today) return;
+    gint32 end = today + 1;
+
+    // Bits before start are clear by definition, only the last word is cut.
+    for (guint w = (start - history->first_day) / 64; w < history->words; w++) {
+        gint32 word_first = history->first_day + (gint32)w * 64;
+        if (word_first >= end) break;
+        guint64 word = history->bits[w];
+        if (word_first + 64 > end) word &= ~(guint64)0 >> (64 - (end - word_first));
+        const guint64 *masks = analytics_weekday_masks[day_number_weekday(word_first)];
+        for (int weekday = 0; weekday < 7; weekday++) {
+            stats->weekday_done[weekday] += bit_count64(word & masks[weekday]);
+        }
+    }
 
-static void on_add_task_ok_clicked(GtkButton *button, gpointer data) {
-    TaskDialogData *task_data = data;
+    gint32 span = end - start;
+    int start_weekday = day_number_weekday(start);
+    for (int weekday = 0; weekday < 7; weekday++) {
+        stats->weekday_days[weekday] = span / 7 + ((weekday - start_weekday + 7) % 7 < span % 7);
+    }
 
-    const char *task_text = gtk_editable_get_text(GTK_EDITABLE(task_data->entry));
-    if (task_text && strlen(task_text) > 0) {
-        char query[512];
-        snprintf(query, sizeof(query),
-                 "INSERT INTO timetable_tasks (day, time_slot, task) VALUES ('%s', '%s', '%s');",
-                 task_data->day, task_data->time_slot, task_text);
-        if (sqlite3_exec(task_data->app_data->db, query, NULL, NULL, NULL) == SQLITE_OK) {
+    static const guint8 month_lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int year, month, day;
+    day_number_to_ymd(start, &year, &month, &day);
+    for (gint32 month_first = start - (day - 1); month_first < end;) {
+        gboolean leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        gint32 month_end = month_first + month_lengths[month - 1] + (month == 2 && leap);
+        gint32 segment_first = MAX(month_first, start);
+        gint32 segment_end = MIN(month_end, end);
+        stats->month_done[month - 1] += history_count_span(history, segment_first, segment_end);
+        stats->month_days[month - 1] += segment_end - segment_first;
+        month_first = month_end;
+        if (++month > 12) {
+            month = 1;
+            year++;
+        }
+    }
+}
 
-            GtkWidget *task_label_timetable = gtk_label_new(task_text);
-            gtk_widget_set_halign(task_label_timetable, GTK_ALIGN_START);
-            gtk_box_append(GTK_BOX(task_data->task_box_in_grid), task_label_timetable);
+static void analytics_job_run(gpointer data, gpointer user_data) {
+    AnalyticsJob *job = data;
+    for (guint i = 0; i < job->count && !g_cancellable_is_cancelled(job->cancellable); i++) {
+        habit_stats_compute(&job->histories[i], job->today, &job->stats[i]);
+    }
+}
 
-            char task_display[512];
-            snprintf(task_display, sizeof(task_display), "%s (%s, %s)", task_text, task_data->day, task_data->time_slot);
-            GtkWidget *task_row_pending = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-            GtkWidget *pending_task_label_widget = gtk_label_new(task_display);
-            gtk_widget_set_halign(pending_task_label_widget, GTK_ALIGN_START);
-            gtk_box_append(GTK_BOX(task_row_pending), pending_task_label_widget);
+static void analytics_result_free(gpointer data) {
+    AnalyticsResult *result = data;
+    g_free(result->habits);
+    g_free(result);
+}
 
-            GtkWidget *done_button = gtk_button_new_with_label("Mark as Done");
-            g_object_set_data(G_OBJECT(done_button), "task", g_strdup(task_text));
-            g_object_set_data(G_OBJECT(done_button), "day", g_strdup(task_data->day));
-            g_object_set_data(G_OBJECT(done_button), "time_slot", g_strdup(task_data->time_slot));
-            g_object_set_data(G_OBJECT(done_button), "task_row", task_row_pending);
-            g_object_set_data(G_OBJECT(done_button), "task_label_timetable", task_label_timetable);
-            g_signal_connect(done_button, "clicked", G_CALLBACK(on_mark_task_done), task_data->app_data);
-            gtk_box_append(GTK_BOX(task_row_pending), done_button);
+static void analytics_input_free(gpointer data) {
+    AnalyticsInput *input = data;
+    for (guint i = 0; i < input->habit_count; i++) {
+        g_free(input->histories[i].bits);
+    }
+    g_free(input->histories);
+    if (input->result) analytics_result_free(input->result);
+    g_free(input);
+}
 
-            gtk_box_append(GTK_BOX(task_data->app_data->pending_tasks_box), task_row_pending);
-        } else {
-            g_printerr("Failed to add task to database: %s\n", sqlite3_errmsg(task_data->app_data->db));
-        }
+static void analytics_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    AnalyticsInput *input = task_data;
+    AnalyticsResult *result = input->result;
+    gint64 start_us = g_get_monotonic_time();
+    guint job_count = (result->habit_count + ANALYTICS_HABITS_PER_JOB - 1) / ANALYTICS_HABITS_PER_JOB;
+    AnalyticsJob *jobs = g_new0(AnalyticsJob, MAX(job_count, 1));
+    GThreadPool *pool = g_thread_pool_new(analytics_job_run, NULL, g_get_num_processors(), FALSE, NULL);
+    for (guint j = 0; j < job_count; j++) {
+        guint first = j * ANALYTICS_HABITS_PER_JOB;
+        jobs[j].histories = input->histories + first;
+        jobs[j].stats = result->habits + first;
+        jobs[j].count = MIN(ANALYTICS_HABITS_PER_JOB, result->habit_count - first);
+        jobs[j].today = input->today;
+        jobs[j].cancellable = cancellable;
+        g_thread_pool_push(pool, &jobs[j], NULL);
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_free(jobs);
+    if (g_cancellable_is_cancelled(cancellable)) {
+        g_task_return_pointer(task, NULL, NULL);
+        return;
     }
 
-    gtk_window_destroy(GTK_WINDOW(task_data->dialog));
-    g_free(task_data);
+    for (guint i = 0; i < result->habit_count; i++) {
+        const HabitStats *stats = &result->habits[i];
+        if (stats->time_slot == 0) continue;
+        for (int weekday = 0; weekday < 7; weekday++) {
+            result->slot_done[stats->time_slot - 1] += stats->weekday_done[weekday];
+            result->slot_days[stats->time_slot - 1] += stats->weekday_days[weekday];
+        }
+    }
+    result->compute_us = g_get_monotonic_time() - start_us;
+    input->result = NULL;
+    g_task_return_pointer(task, result, analytics_result_free);
 }
 
-static void on_add_task_cancel_clicked(GtkButton *button, gpointer data) {
-    TaskDialogData *task_data = data;
-    gtk_window_destroy(GTK_WINDOW(task_data->dialog));
-    g_free(task_data);
-}
+static void analytics_page_refresh(AppData *app_data);
 
-typedef struct {
-    AppData *app_data;
-    char *day;
-    char *time_slot;
-    GtkWidget *task_box_in_grid;
-} TimetableCellData;
+static void on_analytics_done(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    AnalyticsResult *analytics = g_task_propagate_pointer(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        if (analytics) analytics_result_free(analytics);
+        return;
+    }
 
+    AppData *app_data = data;
+    g_clear_object(&app_data->analytics_cancellable);
+    app_data->analytics = analytics;
+    app_data->stats_page_current = FALSE;
+    analytics_page_refresh(app_data);
+}
 
-static void on_timetable_cell_clicked(GtkGestureClick *gesture, gint n_press, gdouble x, gdouble y, gpointer data) {
-    TimetableCellData *cell_data = data;
+// Copies the histories on the main thread, where they are mutated, and
+// hands the copies to the worker.
+static void analytics_start(AppData *app_data) {
+    analytics_masks_init();
+    AnalyticsInput *input = g_new0(AnalyticsInput, 1);
+    AnalyticsResult *result = g_new0(AnalyticsResult, 1);
+    result->habit_count = g_list_length(app_data->habits);
+    result->habits = g_new0(HabitStats, result->habit_count);
+    input->result = result;
+    input->habit_count = result->habit_count;
+    input->histories = g_new0(HistoryBitmap, MAX(result->habit_count, 1));
+    input->today = day_number_today();
+    guint i = 0;
+    for (GList *iter = app_data->habits; iter; iter = iter->next, i++) {
+        const Habit *habit = iter->data;
+        result->habits[i].habit_id = habit->id;
+        result->habits[i].time_slot = time_slot_index(habit->time_slot);
+        if (!habit->history || !habit->history->bits) continue;
+        HistoryBitmap *copy = &input->histories[i];
+        copy->first_day = habit->history->first_day;
+        copy->words = copy->capacity = habit->history->words;
+        copy->bits = g_new(guint64, copy->words);
+        memcpy(copy->bits, habit->history->bits, copy->words * sizeof(guint64));
+    }
 
-    GtkWidget *dialog = gtk_window_new();
-    gtk_window_set_title(GTK_WINDOW(dialog), "Add Task");
-    gtk_window_set_default_size(GTK_WINDOW(dialog), 350, 200);
-    gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(cell_data->app_data->main_window));
-    gtk_window_set_modal(GTK_WINDOW(dialog), TRUE);
-    gtk_window_set_resizable(GTK_WINDOW(dialog), FALSE);
+    app_data->analytics_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->analytics_cancellable, on_analytics_done, app_data);
+    g_task_set_task_data(task, input, analytics_input_free);
+    g_task_run_in_thread(task, analytics_thread);
+    g_object_unref(task);
+}
 
+static void analytics_stop(AppData *app_data) {
+    if (app_data->analytics_cancellable) {
+        g_cancellable_cancel(app_data->analytics_cancellable);
+        g_clear_object(&app_data->analytics_cancellable);
+    }
+}
 
-    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_widget_set_margin_start(vbox, 15);
-    gtk_widget_set_margin_end(vbox, 15);
-    gtk_widget_set_margin_top(vbox, 15);
-    gtk_widget_set_margin_bottom(vbox, 15);
-    gtk_window_set_child(GTK_WINDOW(dialog), vbox);
+// History bitmaps are read by a worker on its own connection, for all
+// habits at once, the first time the Statistics page needs them.
+static void history_load_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    GHashTable *histories = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, history_free);
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(HABIT_DB_PATH, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        g_printerr("History loader cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_task_return_pointer(task, histories, (GDestroyNotify)g_hash_table_unref);
+        return;
+    }
 
-    char label_text[128];
-    snprintf(label_text, sizeof(label_text), "Add task for %s at %s", cell_data->day, cell_data->time_slot);
-    GtkWidget *label = gtk_label_new(label_text);
-    gtk_widget_add_css_class(label,"heading");
-    gtk_box_append(GTK_BOX(vbox), label);
+    char query[160];
+    snprintf(query, sizeof(query), "SELECT habit_id, day FROM %s WHERE completed = 1 ORDER BY habit_id, day;",
+             archive_attach(db) ? "all_completions" : "main.habit_completions");
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, query, -1, &stmt, NULL) == SQLITE_OK) {
+        gint64 current_id = 0;
+        HistoryBitmap *history = NULL;
+        while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+            gint64 habit_id = sqlite3_column_int64(stmt, 0);
+            if (!history || habit_id != current_id) {
+                gint64 *key = g_new(gint64, 1);
+                *key = current_id = habit_id;
+                history = history_new();
+                g_hash_table_insert(histories, key, history);
+            }
+            history_set(history, sqlite3_column_int(stmt, 1), TRUE);
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    g_task_return_pointer(task, histories, (GDestroyNotify)g_hash_table_unref);
+}
 
-    GtkWidget *entry = gtk_entry_new();
-    gtk_entry_set_placeholder_text(GTK_ENTRY(entry), "Enter task description...");
-    gtk_box_append(GTK_BOX(vbox), entry);
+static void analytics_page_refresh(AppData *app_data);
+static void heatmap_page_refresh(AppData *app_data);
+static void correlation_page_refresh(AppData *app_data);
+static void history_load_start(AppData *app_data);
+static void values_load_start(AppData *app_data);
+static void values_load_stop(AppData *app_data);
+
+static void on_history_loaded(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    GHashTable *histories = g_task_propagate_pointer(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        if (histories) g_hash_table_unref(histories);
+        return;
+    }
 
-    GtkWidget *button_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-    gtk_widget_set_halign(button_box, GTK_ALIGN_CENTER);
-    gtk_box_append(GTK_BOX(vbox), button_box);
+    AppData *app_data = data;
+    g_clear_object(&app_data->history_cancellable);
+    if (app_data->history_stale) {
+        // A day was toggled while the rows were read; they may not have it.
+        app_data->history_stale = FALSE;
+        g_hash_table_unref(histories);
+        history_load_start(app_data);
+        return;
+    }
 
-    TaskDialogData *task_dialog_data = g_new0(TaskDialogData, 1);
-    task_dialog_data->app_data = cell_data->app_data;
-    task_dialog_data->day = cell_data->day;
-    task_dialog_data->time_slot = cell_data->time_slot;
-    task_dialog_data->task_box_in_grid = cell_data->task_box_in_grid;
-    task_dialog_data->dialog = dialog;
-    task_dialog_data->entry = entry;
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        Habit *habit = iter->data;
+        if (habit->history) continue;
+        gpointer key, history;
+        if (g_hash_table_steal_extended(histories, &habit->id, &key, &history)) {
+            g_free(key);
+            habit->history = history;
+        } else {
+            habit->history = history_new();
+        }
+    }
+    g_hash_table_unref(histories);
+    app_data->stats_page_current = FALSE;
+    analytics_page_refresh(app_data);
+    app_data->heatmap_page_current = FALSE;
+    heatmap_page_refresh(app_data);
+    app_data->correlation_page_current = FALSE;
+    correlation_page_refresh(app_data);
+}
 
-    GtkWidget *ok_button = gtk_button_new_with_label("OK");
-    g_signal_connect(ok_button, "clicked", G_CALLBACK(on_add_task_ok_clicked), task_dialog_data);
-    gtk_box_append(GTK_BOX(button_box), ok_button);
+static void history_load_start(AppData *app_data) {
+    if (app_data->history_cancellable) return;
+    app_data->history_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->history_cancellable, on_history_loaded, app_data);
+    g_task_run_in_thread(task, history_load_thread);
+    g_object_unref(task);
+}
 
-    GtkWidget *cancel_button = gtk_button_new_with_label("Cancel");
-    g_signal_connect(cancel_button, "clicked", G_CALLBACK(on_add_task_cancel_clicked), task_dialog_data);
-    gtk_box_append(GTK_BOX(button_box), cancel_button);
+static void history_load_stop(AppData *app_data) {
+    if (app_data->history_cancellable) {
+        g_cancellable_cancel(app_data->history_cancellable);
+        g_clear_object(&app_data->history_cancellable);
+    }
+}
 
-    gtk_window_present(GTK_WINDOW(dialog));
+static void format_rate(char *buffer, gsize size, guint32 done, guint32 days) {
+    if (days == 0) {
+        snprintf(buffer, size, "–");
+    } else {
+        snprintf(buffer, size, "%u%%", (guint)((done * 100 + days / 2) / days));
+    }
 }
 
-static void free_timetable_cell_data(gpointer data) {
-    TimetableCellData *cell_data = data;
-    g_free(cell_data->day);
-    g_free(cell_data->time_slot);
-    g_free(cell_data);
+static void stats_grid_attach_text(GtkWidget *grid, const char *text, int column, int row) {
+    GtkWidget *label = gtk_label_new(text);
+    gtk_widget_set_halign(label, column == 0 ? GTK_ALIGN_START : GTK_ALIGN_END);
+    gtk_grid_attach(GTK_GRID(grid), label, column, row, 1, 1);
 }
 
+// Adherence: completed scheduled days over scheduled days. Within each
+// schedule version the history is read a word at a time and masked with
+// the version's weekdays, using the same phase masks as the weekday
+// statistics; scheduled days are counted arithmetically.
+static guint schedule_days_count(gint32 first_day, gint32 end_day, guint8 days_mask) {
+    if (end_day <= first_day) return 0;
+    gint32 span = end_day - first_day;
+    guint count = (span / 7) * bit_count64(days_mask);
+    int weekday = day_number_weekday(first_day);
+    for (int i = 0; i < span % 7; i++) {
+        count += (days_mask >> ((weekday + i) % 7)) & 1;
+    }
+    return count;
+}
 
-static void on_remove_task(GtkButton *button, AppData *app_data) {
-    const char *task = (const char *)g_object_get_data(G_OBJECT(button), "task");
-    const char *day = (const char *)g_object_get_data(G_OBJECT(button), "day");
-    const char *time_slot = (const char *)g_object_get_data(G_OBJECT(button), "time_slot");
-    GtkWidget *row_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "row");
+static guint history_count_scheduled(const HistoryBitmap *history, gint32 first_day, gint32 end_day, guint8 days_mask) {
+    if (!history->bits || !days_mask) return 0;
+    first_day = MAX(first_day, history->first_day);
+    end_day = MIN(end_day, history->first_day + (gint32)history->words * 64);
+    if (end_day <= first_day) return 0;
+
+    guint first_word = (first_day - history->first_day) / 64;
+    guint end_word = (end_day - history->first_day + 63) / 64;
+    int phase = day_number_weekday(history->first_day + (gint32)first_word * 64);
+    guint64 phase_masks[7] = {0};
+    for (int p = 0; p < 7; p++) {
+        for (int weekday = 0; weekday < 7; weekday++) {
+            if (days_mask & (1 << weekday)) phase_masks[p] |= analytics_weekday_masks[p][weekday];
+        }
+    }
 
-    char query[512];
-    snprintf(query, sizeof(query),
-             "DELETE FROM timetable_tasks WHERE task = '%s' AND day = '%s' AND time_slot = '%s';",
-             task, day, time_slot);
-    if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
-        g_printerr("Failed to delete task from timetable_tasks: %s\n", sqlite3_errmsg(app_data->db));
+    guint count = 0;
+    for (guint w = first_word; w < end_word; w++) {
+        gint32 word_first = history->first_day + (gint32)w * 64;
+        guint64 word = history->bits[w] & phase_masks[phase];
+        if (word_first < first_day) word &= ~(guint64)0 << (first_day - word_first);
+        if (word_first + 64 > end_day) word &= ~(guint64)0 >> (word_first + 64 - end_day);
+        count += bit_count64(word);
+        phase = (phase + 1) % 7;  // 64 days is nine weeks and one day
     }
+    return count;
+}
 
+// Adherence over [first_day, last_day], starting no earlier than the
+// habit's first schedule, or its first completion for a habit whose
+// schedule predates versioning.
+static void habit_adherence(const Habit *habit, gint32 first_day, gint32 last_day, guint *done, guint *scheduled) {
+    *done = *scheduled = 0;
+    if (!habit->history || habit->schedule_count == 0) return;
+    analytics_masks_init();
+    gint32 start = habit->schedule[0].from_day;
+    if (start == G_MININT32) start = history_first_completed_day(habit->history);
+    first_day = MAX(first_day, start);
+    for (guint i = 0; i < habit->schedule_count; i++) {
+        gint32 version_first = MAX(first_day, habit->schedule[i].from_day);
+        gint32 version_end = i + 1 < habit->schedule_count ? habit->schedule[i + 1].from_day : last_day + 1;
+        version_end = MIN(version_end, last_day + 1);
+        if (version_end <= version_first) continue;
+        *scheduled += schedule_days_count(version_first, version_end, habit->schedule[i].days_mask);
+        *done += history_count_scheduled(habit->history, version_first, version_end, habit->schedule[i].days_mask);
+    }
+}
 
-    GtkWidget *child = gtk_widget_get_first_child(app_data->pending_tasks_box);
-    while (child) {
-        GtkWidget *next = gtk_widget_get_next_sibling(child);
-        GtkWidget *label_widget = gtk_widget_get_first_child(child);
-        if (label_widget && GTK_IS_LABEL(label_widget)) {
-            const char *label_text_pending = gtk_label_get_text(GTK_LABEL(label_widget));
-            char task_display_pending[512];
-            snprintf(task_display_pending, sizeof(task_display_pending), "%s (%s, %s)", task, day, time_slot);
-            if (strcmp(label_text_pending, task_display_pending) == 0) {
-                gtk_box_remove(GTK_BOX(app_data->pending_tasks_box), child);
-                break;
-            }
+static void analytics_page_build(AppData *app_data) {
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        const Habit *habit = iter->data;
+        if (!habit->history) {
+            history_load_start(app_data);
+            gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->stats_page),
+                                          gtk_label_new("Loading completion history…"));
+            return;
         }
-        child = next;
     }
 
-    const char *days_map[] = {"", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
-    const char *times_map[] = {
-        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
-        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
-        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
-    };
-    int day_idx_map = 0, time_idx_map = 0;
-    for (int i = 1; i <= 7; i++) {
-        if (strcmp(days_map[i], day) == 0) {
-            day_idx_map = i;
-            break;
+    const AnalyticsResult *result = app_data->analytics;
+    if (!result) {
+        if (!app_data->analytics_cancellable) analytics_start(app_data);
+        gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->stats_page),
+                                      gtk_label_new("Computing statistics…"));
+        return;
+    }
+    char rate[16];
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 15);
+    gtk_widget_set_margin_start(vbox, 10);
+    gtk_widget_set_margin_end(vbox, 10);
+    gtk_widget_set_margin_top(vbox, 10);
+    gtk_widget_set_margin_bottom(vbox, 10);
+
+    gtk_box_append(GTK_BOX(vbox), gtk_label_new("Completion rate by time slot"));
+    GtkWidget *slot_grid = gtk_grid_new();
+    gtk_grid_set_column_spacing(GTK_GRID(slot_grid), 20);
+    gtk_widget_set_halign(slot_grid, GTK_ALIGN_CENTER);
+    for (int slot = 0; slot < 12; slot++) {
+        format_rate(rate, sizeof(rate), result->slot_done[slot], result->slot_days[slot]);
+        stats_grid_attach_text(slot_grid, time_slot_names[slot], 0, slot);
+        stats_grid_attach_text(slot_grid, rate, 1, slot);
+    }
+    gtk_box_append(GTK_BOX(vbox), slot_grid);
+
+    gtk_box_append(GTK_BOX(vbox), gtk_label_new("Completion rate by weekday and month"));
+    GtkWidget *habit_grid = gtk_grid_new();
+    gtk_grid_set_column_spacing(GTK_GRID(habit_grid), 8);
+    gtk_grid_set_row_spacing(GTK_GRID(habit_grid), 4);
+    gtk_widget_set_halign(habit_grid, GTK_ALIGN_CENTER);
+    stats_grid_attach_text(habit_grid, "Habit", 0, 0);
+    for (int weekday = 0; weekday < 7; weekday++) {
+        stats_grid_attach_text(habit_grid, weekday_names[weekday], 1 + weekday, 0);
+    }
+    for (int month = 0; month < 12; month++) {
+        stats_grid_attach_text(habit_grid, month_names[month], 8 + month, 0);
+    }
+    for (guint i = 0; i < result->habit_count; i++) {
+        const HabitStats *stats = &result->habits[i];
+        const Habit *habit = habit_find(app_data, stats->habit_id);
+        stats_grid_attach_text(habit_grid, habit ? habit->name : "", 0, i + 1);
+        for (int weekday = 0; weekday < 7; weekday++) {
+            format_rate(rate, sizeof(rate), stats->weekday_done[weekday], stats->weekday_days[weekday]);
+            stats_grid_attach_text(habit_grid, rate, 1 + weekday, i + 1);
+        }
+        for (int month = 0; month < 12; month++) {
+            format_rate(rate, sizeof(rate), stats->month_done[month], stats->month_days[month]);
+            stats_grid_attach_text(habit_grid, rate, 8 + month, i + 1);
         }
     }
-    for (int i = 0; i < 12; i++) {
-        if (strcmp(times_map[i], time_slot) == 0) {
-            time_idx_map = i + 1;
-            break;
+    gtk_box_append(GTK_BOX(vbox), habit_grid);
+
+    gtk_box_append(GTK_BOX(vbox), gtk_label_new("Adherence on scheduled days"));
+    static const char *adherence_headers[] = {"Habit", "Last 30 days", "Last 90 days", "Last 365 days", "All time"};
+    static const int adherence_days[] = {30, 90, 365, 0};
+    GtkWidget *adherence_grid = gtk_grid_new();
+    gtk_grid_set_column_spacing(GTK_GRID(adherence_grid), 12);
+    gtk_grid_set_row_spacing(GTK_GRID(adherence_grid), 4);
+    gtk_widget_set_halign(adherence_grid, GTK_ALIGN_CENTER);
+    for (int column = 0; column < 5; column++) {
+        stats_grid_attach_text(adherence_grid, adherence_headers[column], column, 0);
+    }
+    gint32 adherence_today = day_number_today();
+    int adherence_row = 0;
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        const Habit *habit = iter->data;
+        adherence_row++;
+        stats_grid_attach_text(adherence_grid, habit->name, 0, adherence_row);
+        for (int column = 0; column < 4; column++) {
+            guint done, scheduled;
+            gint32 first_day = adherence_days[column] ? adherence_today - adherence_days[column] + 1 : G_MININT32;
+            habit_adherence(habit, first_day, adherence_today, &done, &scheduled);
+            format_rate(rate, sizeof(rate), done, scheduled);
+            stats_grid_attach_text(adherence_grid, rate, 1 + column, adherence_row);
         }
     }
-    if (app_data->timetable_grid && day_idx_map > 0 && time_idx_map > 0) {
-        GtkWidget *task_box_grid = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_idx_map, time_idx_map);
-        if (task_box_grid) {
-            GtkWidget *grid_child_label = gtk_widget_get_first_child(task_box_grid);
-            while (grid_child_label) {
-                 GtkWidget *next_grid_child = gtk_widget_get_next_sibling(grid_child_label);
-                if (GTK_IS_LABEL(grid_child_label)){
-                    const char *label_text_grid = gtk_label_get_text(GTK_LABEL(grid_child_label));
-                    if (strcmp(label_text_grid, task) == 0) {
-                        gtk_box_remove(GTK_BOX(task_box_grid), grid_child_label);
-                        break;
-                    }
-                }
-                grid_child_label = next_grid_child;
+    gtk_box_append(GTK_BOX(vbox), adherence_grid);
+
+    static const char *quantity_headers[] = {"Habit", "Last 7 days", "30-day avg/day", "30-day median", "30-day p90", "Last 365 days"};
+    GtkWidget *quantity_grid = NULL;
+    gint32 today = day_number_today();
+    int row = 0;
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        const Habit *habit = iter->data;
+        if (habit->target <= 0 || !habit->values) continue;
+        if (!quantity_grid) {
+            gtk_box_append(GTK_BOX(vbox), gtk_label_new("Quantities"));
+            quantity_grid = gtk_grid_new();
+            gtk_grid_set_column_spacing(GTK_GRID(quantity_grid), 12);
+            gtk_grid_set_row_spacing(GTK_GRID(quantity_grid), 4);
+            gtk_widget_set_halign(quantity_grid, GTK_ALIGN_CENTER);
+            for (int column = 0; column < 6; column++) {
+                stats_grid_attach_text(quantity_grid, quantity_headers[column], column, 0);
+            }
+            gtk_box_append(GTK_BOX(vbox), quantity_grid);
+        }
+        double figures[5] = {
+            habit_values_sum(habit->values, today - 6, today),
+            habit_values_sum(habit->values, today - 29, today) / 30.0,
+            habit_values_percentile(habit->values, today - 29, today, 0.5),
+            habit_values_percentile(habit->values, today - 29, today, 0.9),
+            habit_values_sum(habit->values, today - 364, today),
+        };
+        row++;
+        stats_grid_attach_text(quantity_grid, habit->name, 0, row);
+        for (int column = 0; column < 5; column++) {
+            char figure[48];
+            if (isnan(figures[column])) {
+                snprintf(figure, sizeof(figure), "–");
+            } else {
+                snprintf(figure, sizeof(figure), "%.1f %s", figures[column], habit->unit);
             }
+            stats_grid_attach_text(quantity_grid, figure, 1 + column, row);
         }
     }
 
-    if (row_widget && gtk_widget_get_parent(row_widget)) {
-        gtk_grid_remove(GTK_GRID(gtk_widget_get_parent(row_widget)), row_widget);
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->stats_page), vbox);
+    app_data->stats_page_current = TRUE;
+}
+
+// Rebuilt only while the Statistics page is shown; otherwise it stays
+// marked stale until on_notebook_switch_page builds it.
+static void analytics_page_refresh(AppData *app_data) {
+    if (!app_data->stats_page || app_data->stats_page_current ||
+        gtk_notebook_get_current_page(GTK_NOTEBOOK(app_data->notebook)) !=
+        gtk_notebook_page_num(GTK_NOTEBOOK(app_data->notebook), app_data->stats_page)) {
+        return;
     }
+    analytics_page_build(app_data);
+}
 
+// Co-completion correlations. For a chosen date range every habit's
+// history is packed into a range-aligned run of 64-day words, then for
+// every pair of habits the days done together are popcount(a & b) summed
+// over the run, and phi follows from that and the two totals. The habit x
+// habit triangle is cut into CORRELATION_TILE square tiles so both sides
+// of a tile stay in cache while its pairs are counted; the tiles run on a
+// thread pool owned by a worker, and each keeps only its best pairs for
+// every sort order before they are merged. Toggles restart the run only
+// after CORRELATION_DEBOUNCE_MS without another change.
+#define CORRELATION_TILE 64
+#define CORRELATION_DEBOUNCE_MS 750
 
-    g_free((char *)task);
-    g_free((char *)day);
-    g_free((char *)time_slot);
+typedef struct {
+    const CorrelationResult *input;
+    GCancellable *cancellable;
+    guint first_a;
+    guint first_b;
+    CorrelationPair top[CORRELATION_SORT_COUNT][CORRELATION_TOP_PAIRS];
+    guint top_count[CORRELATION_SORT_COUNT];
+} CorrelationJob;
+
+static const char *correlation_range_names[] = {"Last 90 days", "Last year", "Last 5 years", "All time", NULL};
+static const int correlation_range_days[] = {90, 365, 5 * 365 + 1, 0};
+static const char *correlation_sort_names[] = {"Strongest positive", "Strongest negative", "Most days together", NULL};
+
+// Ties fall back to habit order so every tile agrees on the same top pairs.
+static int correlation_compare_habits(const CorrelationPair *x, const CorrelationPair *y) {
+    if (x->first != y->first) return x->first > y->first ? 1 : -1;
+    return (x->second > y->second) - (x->second < y->second);
 }
 
+static int correlation_compare_positive(const void *a, const void *b) {
+    const CorrelationPair *x = a, *y = b;
+    if (x->phi != y->phi) return x->phi < y->phi ? 1 : -1;
+    if (x->together != y->together) return x->together < y->together ? 1 : -1;
+    return correlation_compare_habits(x, y);
+}
 
-static void on_add_task_in_edit(GtkButton *button, gpointer data) {
-    AppData *app_data = (AppData *)g_object_get_data(G_OBJECT(button), "app_data");
-    GtkWidget *entry_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "entry");
-    GtkWidget *calendar_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "calendar");
-    GtkWidget *hour_dropdown_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "hour_dropdown");
-    GtkWidget *tasks_grid_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "tasks_grid");
+static int correlation_compare_negative(const void *a, const void *b) {
+    const CorrelationPair *x = a, *y = b;
+    if (x->phi != y->phi) return x->phi > y->phi ? 1 : -1;
+    if (x->together != y->together) return x->together < y->together ? 1 : -1;
+    return correlation_compare_habits(x, y);
+}
 
+static int correlation_compare_together(const void *a, const void *b) {
+    const CorrelationPair *x = a, *y = b;
+    if (x->together != y->together) return x->together < y->together ? 1 : -1;
+    if (x->phi != y->phi) return x->phi < y->phi ? 1 : -1;
+    return correlation_compare_habits(x, y);
+}
 
-    const char *task_text = gtk_editable_get_text(GTK_EDITABLE(entry_widget));
-    if (task_text && strlen(task_text) > 0) {
-        GDateTime *calendar_date = gtk_calendar_get_date(GTK_CALENDAR(calendar_widget));
-        if (!calendar_date) return;
+static int (*const correlation_comparators[CORRELATION_SORT_COUNT])(const void *, const void *) = {
+    correlation_compare_positive, correlation_compare_negative, correlation_compare_together};
+
+// Sorts pairs by every order and keeps the first CORRELATION_TOP_PAIRS of
+// each; pairs is clobbered.
+static void correlation_keep_top(CorrelationPair *pairs, guint count,
+                                 CorrelationPair top[][CORRELATION_TOP_PAIRS], guint *top_count) {
+    for (int sort = 0; sort < CORRELATION_SORT_COUNT; sort++) {
+        qsort(pairs, count, sizeof(CorrelationPair), correlation_comparators[sort]);
+        top_count[sort] = MIN(count, CORRELATION_TOP_PAIRS);
+        memcpy(top[sort], pairs, top_count[sort] * sizeof(CorrelationPair));
+    }
+}
 
-        guint year_val = g_date_time_get_year(calendar_date);
-        guint month_val = g_date_time_get_month(calendar_date);
-        guint day_val = g_date_time_get_day_of_month(calendar_date);
-        g_date_time_unref(calendar_date);
+static void correlation_job_run(gpointer data, gpointer user_data) {
+    CorrelationJob *job = data;
+    if (g_cancellable_is_cancelled(job->cancellable)) return;
+    const CorrelationResult *input = job->input;
+    guint end_a = MIN(job->first_a + CORRELATION_TILE, input->habit_count);
+    guint end_b = MIN(job->first_b + CORRELATION_TILE, input->habit_count);
+    double days = input->days;
+    guint count = 0;
+    CorrelationPair *scratch = g_new(CorrelationPair, CORRELATION_TILE * CORRELATION_TILE);
+    for (guint a = job->first_a; a < end_a; a++) {
+        const guint64 *vector_a = input->vectors + (gsize)a * input->words;
+        double total_a = input->totals[a];
+        for (guint b = MAX(job->first_b, a + 1); b < end_b; b++) {
+            const guint64 *vector_b = input->vectors + (gsize)b * input->words;
+            guint32 together = 0;
+            for (guint w = 0; w < input->words; w++) {
+                together += bit_count64(vector_a[w] & vector_b[w]);
+            }
+            double total_b = input->totals[b];
+            double spread = total_a * (days - total_a) * total_b * (days - total_b);
+            CorrelationPair *pair = &scratch[count++];
+            pair->first = a;
+            pair->second = b;
+            pair->together = together;
+            pair->phi = spread > 0 ? (float)((days * together - total_a * total_b) / sqrt(spread)) : 0.0f;
+        }
+    }
+    correlation_keep_top(scratch, count, job->top, job->top_count);
+    g_free(scratch);
+}
 
-        guint selected_hour_val = gtk_drop_down_get_selected(GTK_DROP_DOWN(hour_dropdown_widget));
-        int hour_int = (int)selected_hour_val;
+static void correlation_result_free(gpointer data) {
+    CorrelationResult *result = data;
+    g_free(result->habit_ids);
+    g_free(result->vectors);
+    g_free(result->totals);
+    g_free(result);
+}
 
-        GDateTime *due_date_time = g_date_time_new_local(year_val, month_val, day_val, hour_int, 0, 0);
-        if (!due_date_time) return;
+static void correlation_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    CorrelationResult *result = task_data;
+    gint64 start_us = g_get_monotonic_time();
+    guint tiles = (result->habit_count + CORRELATION_TILE - 1) / CORRELATION_TILE;
+    guint job_count = tiles * (tiles + 1) / 2;
+    CorrelationJob *jobs = g_new0(CorrelationJob, MAX(job_count, 1));
+    GThreadPool *pool = g_thread_pool_new(correlation_job_run, NULL, g_get_num_processors(), FALSE, NULL);
+    guint j = 0;
+    for (guint tile_a = 0; tile_a < tiles; tile_a++) {
+        for (guint tile_b = tile_a; tile_b < tiles; tile_b++, j++) {
+            jobs[j].input = result;
+            jobs[j].cancellable = cancellable;
+            jobs[j].first_a = tile_a * CORRELATION_TILE;
+            jobs[j].first_b = tile_b * CORRELATION_TILE;
+            g_thread_pool_push(pool, &jobs[j], NULL);
+        }
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+    if (g_cancellable_is_cancelled(cancellable)) {
+        g_free(jobs);
+        g_task_return_pointer(task, result, correlation_result_free);
+        return;
+    }
 
+    CorrelationPair *merged = g_new(CorrelationPair, MAX(job_count, 1) * CORRELATION_TOP_PAIRS);
+    for (int sort = 0; sort < CORRELATION_SORT_COUNT; sort++) {
+        guint count = 0;
+        for (j = 0; j < job_count; j++) {
+            memcpy(merged + count, jobs[j].top[sort], jobs[j].top_count[sort] * sizeof(CorrelationPair));
+            count += jobs[j].top_count[sort];
+        }
+        qsort(merged, count, sizeof(CorrelationPair), correlation_comparators[sort]);
+        result->top_count[sort] = MIN(count, CORRELATION_TOP_PAIRS);
+        memcpy(result->top[sort], merged, result->top_count[sort] * sizeof(CorrelationPair));
+    }
+    g_free(merged);
+    g_free(jobs);
+    g_clear_pointer(&result->vectors, g_free);
 
-        const char *days_of_week_map[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"}; //GTK is 1-7 Mon-Sun
-        int day_of_week_idx = g_date_time_get_day_of_week(due_date_time); // 1=Mon, ..., 7=Sun
-        const char *day_str_val = days_of_week_map[day_of_week_idx -1];
+    result->compute_us = g_get_monotonic_time() - start_us;
+    g_task_return_pointer(task, result, correlation_result_free);
+}
 
+static void on_correlation_done(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    CorrelationResult *correlation = g_task_propagate_pointer(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        if (correlation) correlation_result_free(correlation);
+        return;
+    }
 
-        const char *time_slots_map[] = {
-            "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
-            "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
-            "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
+    AppData *app_data = data;
+    g_clear_object(&app_data->correlation_cancellable);
+    app_data->correlation = correlation;
+    app_data->correlation_page_current = FALSE;
+    correlation_page_refresh(app_data);
+}
+
+// Packs the histories on the main thread, where they are mutated, and
+// hands the packed copy to the worker.
+static void correlation_start(AppData *app_data) {
+    gint32 today = day_number_today();
+    gint32 first_day = today - correlation_range_days[app_data->correlation_range] + 1;
+    if (correlation_range_days[app_data->correlation_range] == 0) {
+        first_day = today;
+        for (GList *iter = app_data->habits; iter; iter = iter->next) {
+            const Habit *habit = iter->data;
+            first_day = MIN(first_day, history_first_completed_day(habit->history));
+        }
+    }
+
+    CorrelationResult *input = g_new0(CorrelationResult, 1);
+    input->first_day = first_day;
+    input->days = today - first_day + 1;
+    input->words = (input->days + 63) / 64;
+    input->habit_count = g_list_length(app_data->habits);
+    input->habit_ids = g_new(gint64, MAX(input->habit_count, 1));
+    input->vectors = g_new(guint64, MAX((gsize)input->habit_count * input->words, 1));
+    input->totals = g_new(guint32, MAX(input->habit_count, 1));
+    guint64 last_mask = input->days % 64 ? ((guint64)1 << (input->days % 64)) - 1 : ~(guint64)0;
+    guint i = 0;
+    for (GList *iter = app_data->habits; iter; iter = iter->next, i++) {
+        const Habit *habit = iter->data;
+        guint64 *vector = input->vectors + (gsize)i * input->words;
+        input->habit_ids[i] = habit->id;
+        input->totals[i] = 0;
+        for (guint w = 0; w < input->words; w++) {
+            vector[w] = history_window64(habit->history, first_day + (gint32)w * 64);
+            if (w + 1 == input->words) vector[w] &= last_mask;
+            input->totals[i] += bit_count64(vector[w]);
+        }
+    }
+
+    app_data->correlation_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->correlation_cancellable, on_correlation_done, app_data);
+    g_task_set_task_data(task, input, NULL);
+    g_task_run_in_thread(task, correlation_thread);
+    g_object_unref(task);
+}
+
+static void correlation_stop(AppData *app_data) {
+    if (app_data->correlation_debounce_source) {
+        g_source_remove(app_data->correlation_debounce_source);
+        app_data->correlation_debounce_source = 0;
+    }
+    if (app_data->correlation_cancellable) {
+        g_cancellable_cancel(app_data->correlation_cancellable);
+        g_clear_object(&app_data->correlation_cancellable);
+    }
+}
+
+static gboolean on_correlation_debounce(gpointer data) {
+    AppData *app_data = data;
+    app_data->correlation_debounce_source = 0;
+    correlation_page_refresh(app_data);
+    return G_SOURCE_REMOVE;
+}
+
+// The shown list stays until the debounced rebuild replaces it.
+static void correlation_invalidate(AppData *app_data) {
+    correlation_stop(app_data);
+    g_clear_pointer(&app_data->correlation, correlation_result_free);
+    app_data->correlation_page_current = FALSE;
+    app_data->correlation_debounce_source = g_timeout_add(CORRELATION_DEBOUNCE_MS, on_correlation_debounce, app_data);
+}
+
+static void on_correlation_range_changed(GObject *dropdown, GParamSpec *pspec, AppData *app_data) {
+    app_data->correlation_range = gtk_drop_down_get_selected(GTK_DROP_DOWN(dropdown));
+    correlation_invalidate(app_data);
+}
+
+static void on_correlation_sort_changed(GObject *dropdown, GParamSpec *pspec, AppData *app_data) {
+    app_data->correlation_sort = gtk_drop_down_get_selected(GTK_DROP_DOWN(dropdown));
+    app_data->correlation_page_current = FALSE;
+    correlation_page_refresh(app_data);
+}
+
+// The range and sort controls stay put; only the list below is rebuilt.
+static void correlation_page_build(AppData *app_data) {
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        const Habit *habit = iter->data;
+        if (!habit->history) {
+            history_load_start(app_data);
+            gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->correlation_results),
+                                          gtk_label_new("Loading completion history…"));
+            return;
+        }
+    }
+
+    const CorrelationResult *result = app_data->correlation;
+    if (!result) {
+        if (!app_data->correlation_cancellable) correlation_start(app_data);
+        gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->correlation_results),
+                                      gtk_label_new("Computing correlations…"));
+        return;
+    }
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 15);
+    gtk_widget_set_margin_start(vbox, 10);
+    gtk_widget_set_margin_end(vbox, 10);
+    gtk_widget_set_margin_bottom(vbox, 10);
+
+    char text[96];
+    snprintf(text, sizeof(text), "%u habits over %u days, computed in %.0f ms", result->habit_count, result->days,
+             result->compute_us / 1000.0);
+    gtk_box_append(GTK_BOX(vbox), gtk_label_new(text));
+
+    GtkWidget *pair_grid = gtk_grid_new();
+    gtk_grid_set_column_spacing(GTK_GRID(pair_grid), 20);
+    gtk_grid_set_row_spacing(GTK_GRID(pair_grid), 4);
+    gtk_widget_set_halign(pair_grid, GTK_ALIGN_CENTER);
+    stats_grid_attach_text(pair_grid, "Habit", 0, 0);
+    stats_grid_attach_text(pair_grid, "Habit", 1, 0);
+    stats_grid_attach_text(pair_grid, "Days together", 2, 0);
+    stats_grid_attach_text(pair_grid, "Phi", 3, 0);
+    for (guint i = 0; i < result->top_count[app_data->correlation_sort]; i++) {
+        const CorrelationPair *pair = &result->top[app_data->correlation_sort][i];
+        const Habit *first = habit_find(app_data, result->habit_ids[pair->first]);
+        const Habit *second = habit_find(app_data, result->habit_ids[pair->second]);
+        stats_grid_attach_text(pair_grid, first ? first->name : "", 0, i + 1);
+        gtk_widget_set_halign(gtk_grid_get_child_at(GTK_GRID(pair_grid), 0, i + 1), GTK_ALIGN_START);
+        stats_grid_attach_text(pair_grid, second ? second->name : "", 1, i + 1);
+        gtk_widget_set_halign(gtk_grid_get_child_at(GTK_GRID(pair_grid), 1, i + 1), GTK_ALIGN_START);
+        snprintf(text, sizeof(text), "%u", pair->together);
+        stats_grid_attach_text(pair_grid, text, 2, i + 1);
+        snprintf(text, sizeof(text), "%+.2f", pair->phi);
+        stats_grid_attach_text(pair_grid, text, 3, i + 1);
+    }
+    gtk_box_append(GTK_BOX(vbox), pair_grid);
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->correlation_results), vbox);
+    app_data->correlation_page_current = TRUE;
+}
+
+static void correlation_page_refresh(AppData *app_data) {
+    if (!app_data->correlation_page || app_data->correlation_page_current ||
+        gtk_notebook_get_current_page(GTK_NOTEBOOK(app_data->notebook)) !=
+        gtk_notebook_page_num(GTK_NOTEBOOK(app_data->notebook), app_data->correlation_page)) {
+        return;
+    }
+    correlation_page_build(app_data);
+}
+
+// Called after every change to habits or their completions.
+static void analytics_invalidate(AppData *app_data) {
+    analytics_stop(app_data);
+    g_clear_pointer(&app_data->analytics, analytics_result_free);
+    app_data->stats_page_current = FALSE;
+    analytics_page_refresh(app_data);
+    correlation_invalidate(app_data);
+}
+
+// Year heatmaps. Every habit-year on the Heatmap page is a drawing area
+// of HEATMAP_WEEKS Monday-first columns by 7 days. Its pixels are rendered
+// once from the history bitmap into an image surface kept in
+// app_data->heatmap_tiles, and later draws only paint that surface. A
+// toggled day drops the tile of its own habit-year and nothing else. At
+// most HEATMAP_TILE_CACHE_SIZE tiles are kept; the least recently drawn
+// one is dropped first. Each habit has its own section box on the page,
+// so adding, renaming or removing a habit only touches that section.
+// Clicking a cell toggles that day through habit_toggle_day, the same
+// path Done Today takes.
+#define HEATMAP_TILE_CACHE_SIZE 48
+#define HEATMAP_WEEKS 54
+#define HEATMAP_CELL 11
+#define HEATMAP_PITCH 13
+#define HEATMAP_TOP 14
+#define HEATMAP_WIDTH (HEATMAP_WEEKS * HEATMAP_PITCH)
+#define HEATMAP_HEIGHT (HEATMAP_TOP + 7 * HEATMAP_PITCH)
+#define HEATMAP_TILE_KEY(habit_id, year) (((habit_id) << 16) | (year))
+
+typedef struct {
+    gint64 key;
+    cairo_surface_t *surface;
+    int scale;
+    GList lru_link;
+    GQueue *lru;
+} HeatmapTile;
+
+static gboolean habit_toggle_day(AppData *app_data, gint64 habit_id, gint32 day);
+static void habit_amount_set(AppData *app_data, gint64 habit_id, gint32 day, double amount);
+
+static void heatmap_tile_free(gpointer data) {
+    HeatmapTile *tile = data;
+    g_queue_unlink(tile->lru, &tile->lru_link);
+    if (tile->surface) cairo_surface_destroy(tile->surface);
+    g_free(tile);
+}
+
+static gint32 heatmap_origin(int year) {
+    gint32 first_day = day_number_from_ymd(year, 1, 1);
+    return first_day - day_number_weekday(first_day);
+}
+
+static cairo_surface_t *heatmap_tile_render(const Habit *habit, int year, int scale) {
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, HEATMAP_WIDTH * scale, HEATMAP_HEIGHT * scale);
+    cairo_surface_set_device_scale(surface, scale, scale);
+    cairo_t *cr = cairo_create(surface);
+
+    gint32 origin = heatmap_origin(year);
+    cairo_set_source_rgb(cr, 0.4, 0.4, 0.4);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 9);
+    for (int month = 1; month <= 12; month++) {
+        cairo_move_to(cr, (day_number_from_ymd(year, month, 1) - origin) / 7 * HEATMAP_PITCH, HEATMAP_TOP - 4);
+        cairo_show_text(cr, month_names[month - 1]);
+    }
+
+    gint32 today = day_number_today();
+    gint32 last_day = MIN(day_number_from_ymd(year + 1, 1, 1) - 1, today);
+    for (gint32 day = day_number_from_ymd(year, 1, 1); day <= last_day; day++) {
+        if (habit->history && history_count_span(habit->history, day, day + 1)) {
+            cairo_set_source_rgb(cr, 0.25, 0.65, 0.25);
+        } else {
+            cairo_set_source_rgb(cr, 0.9, 0.91, 0.92);
+        }
+        cairo_rectangle(cr, (day - origin) / 7 * HEATMAP_PITCH,
+                        HEATMAP_TOP + day_number_weekday(day) * HEATMAP_PITCH, HEATMAP_CELL, HEATMAP_CELL);
+        cairo_fill(cr);
+    }
+    cairo_destroy(cr);
+    return surface;
+}
+
+static void draw_heatmap(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer data) {
+    AppData *app_data = data;
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(area), "habit_id"));
+    int year = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(area), "year"));
+    const Habit *habit = habit_find(app_data, habit_id);
+    if (!habit) return;
+
+    gint64 key = HEATMAP_TILE_KEY(habit_id, year);
+    HeatmapTile *tile = g_hash_table_lookup(app_data->heatmap_tiles, &key);
+    if (tile) {
+        g_queue_unlink(&app_data->heatmap_tile_lru, &tile->lru_link);
+    } else {
+        tile = g_new0(HeatmapTile, 1);
+        tile->key = key;
+        tile->lru_link.data = tile;
+        tile->lru = &app_data->heatmap_tile_lru;
+        g_hash_table_insert(app_data->heatmap_tiles, &tile->key, tile);
+        if (app_data->heatmap_tile_lru.length >= HEATMAP_TILE_CACHE_SIZE) {
+            HeatmapTile *oldest = app_data->heatmap_tile_lru.tail->data;
+            g_hash_table_remove(app_data->heatmap_tiles, &oldest->key);
+        }
+    }
+    g_queue_push_head_link(&app_data->heatmap_tile_lru, &tile->lru_link);
+    int scale = gtk_widget_get_scale_factor(GTK_WIDGET(area));
+    if (!tile->surface || tile->scale != scale) {
+        if (tile->surface) cairo_surface_destroy(tile->surface);
+        tile->surface = heatmap_tile_render(habit, year, scale);
+        tile->scale = scale;
+    }
+    cairo_set_source_surface(cr, tile->surface, 0, 0);
+    cairo_paint(cr);
+}
+
+static void on_heatmap_pressed(GtkGestureClick *gesture, gint n_press, gdouble x, gdouble y, gpointer data) {
+    AppData *app_data = data;
+    GtkWidget *area = gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(gesture));
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(area), "habit_id"));
+    int year = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(area), "year"));
+    if (y < HEATMAP_TOP) return;
+
+    int column = (int)x / HEATMAP_PITCH;
+    int row = ((int)y - HEATMAP_TOP) / HEATMAP_PITCH;
+    gint32 day = heatmap_origin(year) + column * 7 + row;
+    if (row > 6 || day < day_number_from_ymd(year, 1, 1) ||
+        day >= day_number_from_ymd(year + 1, 1, 1) || day > day_number_today()) {
+        return;
+    }
+    // A quantitative habit's completion follows its logged amount, so the
+    // click logs the target or clears the amount instead.
+    const Habit *habit = habit_find(app_data, habit_id);
+    if (habit && habit->target > 0) {
+        habit_amount_set(app_data, habit_id, day, habit_counter_range(habit, day, day) > 0 ? 0 : habit->target);
+        return;
+    }
+    habit_toggle_day(app_data, habit_id, day);
+}
+
+// The box holding one section per habit, or NULL while the page is not
+// built.
+static GtkWidget *heatmap_page_content(AppData *app_data) {
+    if (!app_data->heatmap_page || !app_data->heatmap_page_current) return NULL;
+    GtkWidget *content = gtk_scrolled_window_get_child(GTK_SCROLLED_WINDOW(app_data->heatmap_page));
+    if (GTK_IS_VIEWPORT(content)) content = gtk_viewport_get_child(GTK_VIEWPORT(content));
+    return content;
+}
+
+static GtkWidget *heatmap_section_find(AppData *app_data, gint64 habit_id) {
+    GtkWidget *content = heatmap_page_content(app_data);
+    for (GtkWidget *child = content ? gtk_widget_get_first_child(content) : NULL; child; child = gtk_widget_get_next_sibling(child)) {
+        if (HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(child), "habit_id")) == habit_id) return child;
+    }
+    return NULL;
+}
+
+// Drops the cached tile holding day and redraws its area if it is shown.
+static void heatmap_day_changed(AppData *app_data, gint64 habit_id, gint32 day) {
+    int year, month, month_day;
+    day_number_to_ymd(day, &year, &month, &month_day);
+    gint64 key = HEATMAP_TILE_KEY(habit_id, year);
+    g_hash_table_remove(app_data->heatmap_tiles, &key);
+
+    GtkWidget *section = heatmap_section_find(app_data, habit_id);
+    for (GtkWidget *child = section ? gtk_widget_get_first_child(section) : NULL; child; child = gtk_widget_get_next_sibling(child)) {
+        if (GTK_IS_DRAWING_AREA(child) && GPOINTER_TO_INT(g_object_get_data(G_OBJECT(child), "year")) == year) {
+            gtk_widget_queue_draw(child);
+        }
+    }
+}
+
+static void heatmap_tiles_drop_habit(AppData *app_data, gint64 habit_id) {
+    GHashTableIter iter;
+    gint64 *key;
+    g_hash_table_iter_init(&iter, app_data->heatmap_tiles);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&key, NULL)) {
+        if (*key >> 16 == habit_id) g_hash_table_iter_remove(&iter);
+    }
+}
+
+static GtkWidget *heatmap_section_new(AppData *app_data, const Habit *habit) {
+    GtkWidget *section = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    g_object_set_data(G_OBJECT(section), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+    GtkWidget *name_label = gtk_label_new(habit->name);
+    gtk_widget_set_halign(name_label, GTK_ALIGN_START);
+    gtk_widget_set_margin_top(name_label, 8);
+    gtk_box_append(GTK_BOX(section), name_label);
+
+    int this_year, first_year, month, day;
+    day_number_to_ymd(day_number_today(), &this_year, &month, &day);
+    first_year = this_year;
+    gint32 first_day = history_first_completed_day(habit->history);
+    if (first_day != G_MAXINT32) day_number_to_ymd(first_day, &first_year, &month, &day);
+    for (int year = this_year; year >= first_year; year--) {
+        char year_str[8];
+        snprintf(year_str, sizeof(year_str), "%d", year);
+        GtkWidget *year_label = gtk_label_new(year_str);
+        gtk_widget_set_halign(year_label, GTK_ALIGN_START);
+        gtk_box_append(GTK_BOX(section), year_label);
+
+        GtkWidget *area = gtk_drawing_area_new();
+        gtk_widget_set_size_request(area, HEATMAP_WIDTH, HEATMAP_HEIGHT);
+        gtk_widget_set_halign(area, GTK_ALIGN_START);
+        g_object_set_data(G_OBJECT(area), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+        g_object_set_data(G_OBJECT(area), "year", GINT_TO_POINTER(year));
+        gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(area), draw_heatmap, app_data, NULL);
+        GtkGesture *click = gtk_gesture_click_new();
+        g_signal_connect(click, "pressed", G_CALLBACK(on_heatmap_pressed), app_data);
+        gtk_widget_add_controller(area, GTK_EVENT_CONTROLLER(click));
+        gtk_box_append(GTK_BOX(section), area);
+    }
+    return section;
+}
+
+static void heatmap_page_build(AppData *app_data) {
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        const Habit *habit = iter->data;
+        if (!habit->history) {
+            history_load_start(app_data);
+            gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->heatmap_page),
+                                          gtk_label_new("Loading completion history…"));
+            return;
+        }
+    }
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    gtk_widget_set_margin_start(vbox, 10);
+    gtk_widget_set_margin_end(vbox, 10);
+    gtk_widget_set_margin_top(vbox, 10);
+    gtk_widget_set_margin_bottom(vbox, 10);
+
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        gtk_box_append(GTK_BOX(vbox), heatmap_section_new(app_data, iter->data));
+    }
+
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->heatmap_page), vbox);
+    app_data->heatmap_page_current = TRUE;
+}
+
+static void heatmap_page_refresh(AppData *app_data) {
+    if (!app_data->heatmap_page || app_data->heatmap_page_current ||
+        gtk_notebook_get_current_page(GTK_NOTEBOOK(app_data->notebook)) !=
+        gtk_notebook_page_num(GTK_NOTEBOOK(app_data->notebook), app_data->heatmap_page)) {
+        return;
+    }
+    heatmap_page_build(app_data);
+}
+
+static void heatmap_page_invalidate(AppData *app_data) {
+    app_data->heatmap_page_current = FALSE;
+    heatmap_page_refresh(app_data);
+}
+
+// habit was appended to app_data->habits. Its section goes at the end of a
+// built page; without its history the page has to load it first.
+static void heatmap_habit_added(AppData *app_data, const Habit *habit) {
+    GtkWidget *content = heatmap_page_content(app_data);
+    if (!content) return;
+    if (!habit->history) {
+        heatmap_page_invalidate(app_data);
+        return;
+    }
+    gtk_box_append(GTK_BOX(content), heatmap_section_new(app_data, habit));
+}
+
+static void heatmap_habit_renamed(AppData *app_data, const Habit *habit) {
+    GtkWidget *section = heatmap_section_find(app_data, habit->id);
+    if (section) gtk_label_set_text(GTK_LABEL(gtk_widget_get_first_child(section)), habit->name);
+}
+
+static void heatmap_habit_removed(AppData *app_data, gint64 habit_id) {
+    heatmap_tiles_drop_habit(app_data, habit_id);
+    GtkWidget *section = heatmap_section_find(app_data, habit_id);
+    if (section) gtk_box_remove(GTK_BOX(gtk_widget_get_parent(section)), section);
+}
+
+// Month overview on the dashboard. For every day of a month it shows how
+// many active habits were completed, as a share of all active habits. A
+// month is read with one grouped query over both completion files; the
+// shown month and its two neighbours are fetched together on a worker, so
+// stepping to the previous or next month draws from memory and only then
+// queues the following one. Toggles update the cached counts in place.
+#define MONTH_CELL_WIDTH 44
+#define MONTH_CELL_HEIGHT 34
+#define MONTH_HEADER_HEIGHT 20
+
+typedef struct {
+    int month_key; // year * 12 + month - 1
+    gint32 first_day;
+    int days;
+    guint32 done[31];
+} MonthOverview;
+
+typedef struct {
+    int first_key;
+    int last_key;
+} MonthRequest;
+
+static gint32 month_key_first_day(int month_key) {
+    return day_number_from_ymd(month_key / 12, month_key % 12 + 1, 1);
+}
+
+static int month_key_for_day(gint32 day) {
+    int year, month, month_day;
+    day_number_to_ymd(day, &year, &month, &month_day);
+    return year * 12 + month - 1;
+}
+
+static void month_overview_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    const MonthRequest *request = task_data;
+    GPtrArray *overviews = g_ptr_array_new_with_free_func(g_free);
+    for (int key = request->first_key; key <= request->last_key; key++) {
+        MonthOverview *overview = g_new0(MonthOverview, 1);
+        overview->month_key = key;
+        overview->first_day = month_key_first_day(key);
+        overview->days = month_key_first_day(key + 1) - overview->first_day;
+        g_ptr_array_add(overviews, overview);
+    }
+
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(HABIT_DB_PATH, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        g_printerr("Month overview cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_ptr_array_unref(overviews);
+        g_task_return_pointer(task, NULL, NULL);
+        return;
+    }
+
+    gint32 first_day = month_key_first_day(request->first_key);
+    char query[384];
+    snprintf(query, sizeof(query),
+             "SELECT c.day, COUNT(*) FROM %s AS c JOIN habits AS h ON h.id = c.habit_id AND h.archived = 0 "
+             "WHERE c.completed = 1 AND c.day >= %d AND c.day < %d GROUP BY c.day ORDER BY c.day;",
+             archive_attach(db) ? "all_completions" : "main.habit_completions",
+             first_day, month_key_first_day(request->last_key + 1));
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, query, -1, &stmt, NULL) == SQLITE_OK) {
+        guint index = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+            gint32 day = sqlite3_column_int(stmt, 0);
+            MonthOverview *overview = g_ptr_array_index(overviews, index);
+            while (day >= overview->first_day + overview->days) {
+                overview = g_ptr_array_index(overviews, ++index);
+            }
+            overview->done[day - overview->first_day] = sqlite3_column_int(stmt, 1);
+        }
+    } else {
+        g_printerr("Month overview query failed: %s\n", sqlite3_errmsg(db));
+        g_clear_pointer(&overviews, g_ptr_array_unref);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    g_task_return_pointer(task, overviews, overviews ? (GDestroyNotify)g_ptr_array_unref : NULL);
+}
+
+static void month_overview_prefetch(AppData *app_data);
+
+static void on_month_overview_loaded(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    GPtrArray *overviews = g_task_propagate_pointer(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        if (overviews) g_ptr_array_unref(overviews);
+        return;
+    }
+
+    AppData *app_data = data;
+    g_clear_object(&app_data->month_cancellable);
+    if (!overviews) return;
+    if (app_data->month_stale) {
+        // A day was toggled while the rows were read; they may not have it.
+        app_data->month_stale = FALSE;
+        g_ptr_array_unref(overviews);
+        month_overview_prefetch(app_data);
+        return;
+    }
+
+    g_ptr_array_set_free_func(overviews, NULL);
+    for (guint i = 0; i < overviews->len; i++) {
+        MonthOverview *overview = g_ptr_array_index(overviews, i);
+        g_hash_table_replace(app_data->month_overviews, &overview->month_key, overview);
+    }
+    g_ptr_array_unref(overviews);
+    gtk_widget_queue_draw(app_data->month_area);
+    // The user may have stepped on while this batch was read.
+    month_overview_prefetch(app_data);
+}
+
+// Reads whichever of the shown month and its neighbours are not cached.
+// Nothing is read before startup has finished migrating the database.
+static void month_overview_prefetch(AppData *app_data) {
+    if (!app_data->month_area || !app_data->loaded_us || app_data->month_cancellable) return;
+    int first_key = G_MAXINT, last_key = G_MININT;
+    for (int key = app_data->month_shown - 1; key <= app_data->month_shown + 1; key++) {
+        if (g_hash_table_contains(app_data->month_overviews, &key)) continue;
+        first_key = MIN(first_key, key);
+        last_key = MAX(last_key, key);
+    }
+    if (first_key > last_key) return;
+
+    MonthRequest *request = g_new(MonthRequest, 1);
+    request->first_key = first_key;
+    request->last_key = last_key;
+    app_data->month_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->month_cancellable, on_month_overview_loaded, app_data);
+    g_task_set_task_data(task, request, g_free);
+    g_task_run_in_thread(task, month_overview_thread);
+    g_object_unref(task);
+}
+
+static void month_overview_stop(AppData *app_data) {
+    if (app_data->month_cancellable) {
+        g_cancellable_cancel(app_data->month_cancellable);
+        g_clear_object(&app_data->month_cancellable);
+    }
+}
+
+// The set of active habits changed, so every cached count may be off.
+static void month_overview_reset(AppData *app_data) {
+    if (!app_data->month_overviews) return;
+    month_overview_stop(app_data);
+    app_data->month_stale = FALSE;
+    g_hash_table_remove_all(app_data->month_overviews);
+    gtk_widget_queue_draw(app_data->month_area);
+    month_overview_prefetch(app_data);
+}
+
+static void month_overview_day_changed(AppData *app_data, gint32 day, gboolean completed) {
+    if (!app_data->month_overviews) return;
+    if (app_data->month_cancellable) app_data->month_stale = TRUE;
+    int key = month_key_for_day(day);
+    MonthOverview *overview = g_hash_table_lookup(app_data->month_overviews, &key);
+    if (!overview) return;
+    if (completed) {
+        overview->done[day - overview->first_day]++;
+    } else if (overview->done[day - overview->first_day] > 0) {
+        overview->done[day - overview->first_day]--;
+    }
+    if (key == app_data->month_shown) gtk_widget_queue_draw(app_data->month_area);
+}
+
+static void draw_month_overview(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer data) {
+    AppData *app_data = data;
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 10);
+    cairo_set_source_rgb(cr, 0.4, 0.4, 0.4);
+    for (int weekday = 0; weekday < 7; weekday++) {
+        cairo_move_to(cr, weekday * MONTH_CELL_WIDTH + 4, MONTH_HEADER_HEIGHT - 6);
+        cairo_show_text(cr, weekday_names[weekday]);
+    }
+
+    int key = app_data->month_shown;
+    const MonthOverview *overview = g_hash_table_lookup(app_data->month_overviews, &key);
+    gint32 first_day = month_key_first_day(key);
+    int days = month_key_first_day(key + 1) - first_day;
+    int lead = day_number_weekday(first_day);
+    guint habit_count = g_list_length(app_data->habits);
+    gint32 today = day_number_today();
+    for (int i = 0; i < days; i++) {
+        double x = (lead + i) % 7 * MONTH_CELL_WIDTH;
+        double y = MONTH_HEADER_HEIGHT + (lead + i) / 7 * MONTH_CELL_HEIGHT;
+        double ratio = overview && habit_count ? MIN(1.0, (double)overview->done[i] / habit_count) : 0.0;
+        cairo_set_source_rgb(cr, 0.9 - 0.65 * ratio, 0.91 - 0.26 * ratio, 0.92 - 0.67 * ratio);
+        if (first_day + i > today) cairo_set_source_rgb(cr, 0.97, 0.97, 0.97);
+        cairo_rectangle(cr, x + 1, y + 1, MONTH_CELL_WIDTH - 2, MONTH_CELL_HEIGHT - 2);
+        cairo_fill(cr);
+        if (first_day + i == today) {
+            cairo_set_source_rgb(cr, 0.2, 0.2, 0.2);
+            cairo_set_line_width(cr, 1.5);
+            cairo_rectangle(cr, x + 1.75, y + 1.75, MONTH_CELL_WIDTH - 3.5, MONTH_CELL_HEIGHT - 3.5);
+            cairo_stroke(cr);
+        }
+
+        char text[24];
+        snprintf(text, sizeof(text), "%d", i + 1);
+        cairo_set_source_rgb(cr, ratio > 0.6 ? 1.0 : 0.2, ratio > 0.6 ? 1.0 : 0.2, ratio > 0.6 ? 1.0 : 0.2);
+        cairo_move_to(cr, x + 5, y + 14);
+        cairo_show_text(cr, text);
+        if (overview && habit_count && first_day + i <= today) {
+            snprintf(text, sizeof(text), "%u/%u", overview->done[i], habit_count);
+            cairo_move_to(cr, x + 5, y + MONTH_CELL_HEIGHT - 6);
+            cairo_show_text(cr, text);
+        }
+    }
+}
+
+static void month_overview_show(AppData *app_data, int month_key) {
+    app_data->month_shown = month_key;
+    char title[32];
+    snprintf(title, sizeof(title), "%s %d", month_names[month_key % 12], month_key / 12);
+    gtk_label_set_text(GTK_LABEL(app_data->month_label), title);
+    gtk_widget_queue_draw(app_data->month_area);
+    month_overview_prefetch(app_data);
+}
+
+static void on_month_previous(GtkButton *button, AppData *app_data) {
+    month_overview_show(app_data, app_data->month_shown - 1);
+}
+
+static void on_month_next(GtkButton *button, AppData *app_data) {
+    month_overview_show(app_data, app_data->month_shown + 1);
+}
+
+// Forecasting. Each habit gets a logistic regression model predicting
+// whether it is done on a given day. The features are the weekday (one-hot,
+// doubling as per-weekday intercepts), the share of the previous 7 and 30
+// days done and the current streak capped at FORECAST_STREAK_CAP. After
+// startup a worker reads the last year of completions on its own
+// connection and fits every habit with a few epochs of SGD, in batches on
+// a thread pool it owns. Back on the main thread the models are attached
+// to the habits and every badge is scored in one pass. A check-in takes
+// one more SGD step for that habit and rescores it. Features at inference
+// come from the rolling counter, so scoring never touches the database.
+#define FORECAST_FEATURES 10
+#define FORECAST_TRAIN_DAYS 365
+#define FORECAST_MIN_DAYS 28
+#define FORECAST_EPOCHS 30
+#define FORECAST_LEARNING_RATE 0.05f
+#define FORECAST_L2 0.001f
+#define FORECAST_STREAK_CAP 30
+#define FORECAST_RISK_THRESHOLD 0.5f
+#define FORECAST_HABITS_PER_JOB 64
+
+typedef struct {
+    gint32 today;
+    guint habit_count;
+    gint64 *habit_ids;
+    HistoryBitmap **histories;
+    float *weights;     // habit_count x FORECAST_FEATURES
+    gboolean *trained;
+} ForecastBatch;
+
+typedef struct {
+    ForecastBatch *batch;
+    guint first;
+    guint count;
+} ForecastJob;
+
+static void forecast_features_fill(float *features, int weekday, int window7, int window30, int streak) {
+    for (int i = 0; i < 7; i++) {
+        features[i] = i == weekday;
+    }
+    features[7] = window7 / 7.0f;
+    features[8] = window30 / 30.0f;
+    features[9] = (float)streak / FORECAST_STREAK_CAP;
+}
+
+static float forecast_probability(const float *weights, const float *features) {
+    float z = 0.0f;
+    for (int i = 0; i < FORECAST_FEATURES; i++) {
+        z += weights[i] * features[i];
+    }
+    return 1.0f / (1.0f + expf(-z));
+}
+
+static void forecast_sgd_step(float *weights, const float *features, gboolean done) {
+    float gradient = forecast_probability(weights, features) - (done ? 1.0f : 0.0f);
+    for (int i = 0; i < FORECAST_FEATURES; i++) {
+        weights[i] -= FORECAST_LEARNING_RATE * (gradient * features[i] + FORECAST_L2 * weights[i]);
+    }
+}
+
+// Features for weekday as things stand at the start of day.
+static void habit_forecast_features(const Habit *habit, gint32 day, int weekday, float *features) {
+    int streak = 0;
+    while (streak < FORECAST_STREAK_CAP && habit_counter_range(habit, day - 1 - streak, day - 1 - streak)) {
+        streak++;
+    }
+    forecast_features_fill(features, weekday, habit_counter_range(habit, day - 7, day - 1),
+                           habit_counter_range(habit, day - 30, day - 1), streak);
+}
+
+// Fits one habit over the days from its first completion in the window up
+// to yesterday; the rolling features are slid along instead of recounted.
+static gboolean forecast_train(const HistoryBitmap *history, gint32 today, float *weights) {
+    gint32 first_day = MAX(history_first_completed_day(history), today - FORECAST_TRAIN_DAYS);
+    if (first_day == G_MAXINT32 || today - first_day < FORECAST_MIN_DAYS) return FALSE;
+
+    guint samples = today - first_day;
+    float *features = g_new(float, (gsize)samples * FORECAST_FEATURES);
+    gboolean *labels = g_new(gboolean, samples);
+    int window7 = history_count_span(history, first_day - 7, first_day);
+    int window30 = history_count_span(history, first_day - 30, first_day);
+    int streak = 0;
+    while (streak < FORECAST_STREAK_CAP && history_count_span(history, first_day - 1 - streak, first_day - streak)) {
+        streak++;
+    }
+    for (guint i = 0; i < samples; i++) {
+        gint32 day = first_day + (gint32)i;
+        forecast_features_fill(features + (gsize)i * FORECAST_FEATURES, day_number_weekday(day), window7, window30, streak);
+        labels[i] = history_count_span(history, day, day + 1);
+        window7 += labels[i] - (int)history_count_span(history, day - 7, day - 6);
+        window30 += labels[i] - (int)history_count_span(history, day - 30, day - 29);
+        streak = labels[i] ? MIN(streak + 1, FORECAST_STREAK_CAP) : 0;
+    }
+
+    memset(weights, 0, FORECAST_FEATURES * sizeof(float));
+    for (int epoch = 0; epoch < FORECAST_EPOCHS; epoch++) {
+        for (guint i = 0; i < samples; i++) {
+            forecast_sgd_step(weights, features + (gsize)i * FORECAST_FEATURES, labels[i]);
+        }
+    }
+    g_free(features);
+    g_free(labels);
+    return TRUE;
+}
+
+static void forecast_job_run(gpointer data, gpointer user_data) {
+    ForecastJob *job = data;
+    ForecastBatch *batch = job->batch;
+    for (guint i = job->first; i < job->first + job->count; i++) {
+        batch->trained[i] = batch->histories[i] &&
+            forecast_train(batch->histories[i], batch->today, batch->weights + (gsize)i * FORECAST_FEATURES);
+    }
+}
+
+static void forecast_batch_free(gpointer data) {
+    ForecastBatch *batch = data;
+    for (guint i = 0; i < batch->habit_count; i++) {
+        history_free(batch->histories[i]);
+    }
+    g_free(batch->habit_ids);
+    g_free(batch->histories);
+    g_free(batch->weights);
+    g_free(batch->trained);
+    g_free(batch);
+}
+
+static void forecast_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    ForecastBatch *batch = task_data;
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(HABIT_DB_PATH, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        g_printerr("Forecast cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_task_return_pointer(task, batch, forecast_batch_free);
+        return;
+    }
+
+    GHashTable *index_by_id = g_hash_table_new(g_int64_hash, g_int64_equal);
+    for (guint i = 0; i < batch->habit_count; i++) {
+        g_hash_table_insert(index_by_id, &batch->habit_ids[i], GUINT_TO_POINTER(i + 1));
+    }
+    char query[192];
+    snprintf(query, sizeof(query), "SELECT habit_id, day FROM %s WHERE completed = 1 AND day >= %d AND day < %d;",
+             archive_attach(db) ? "all_completions" : "main.habit_completions",
+             batch->today - FORECAST_TRAIN_DAYS - 31, batch->today);
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, query, -1, &stmt, NULL) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+            gint64 habit_id = sqlite3_column_int64(stmt, 0);
+            guint index = GPOINTER_TO_UINT(g_hash_table_lookup(index_by_id, &habit_id));
+            if (index == 0) continue;
+            if (!batch->histories[index - 1]) batch->histories[index - 1] = history_new();
+            history_set(batch->histories[index - 1], sqlite3_column_int(stmt, 1), TRUE);
+        }
+    } else {
+        g_printerr("Forecast query failed: %s\n", sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    g_hash_table_destroy(index_by_id);
+
+    guint job_count = (batch->habit_count + FORECAST_HABITS_PER_JOB - 1) / FORECAST_HABITS_PER_JOB;
+    ForecastJob *jobs = g_new(ForecastJob, MAX(job_count, 1));
+    GThreadPool *pool = g_thread_pool_new(forecast_job_run, NULL, g_get_num_processors(), FALSE, NULL);
+    for (guint j = 0; j < job_count && !g_cancellable_is_cancelled(cancellable); j++) {
+        jobs[j].batch = batch;
+        jobs[j].first = j * FORECAST_HABITS_PER_JOB;
+        jobs[j].count = MIN(FORECAST_HABITS_PER_JOB, batch->habit_count - jobs[j].first);
+        g_thread_pool_push(pool, &jobs[j], NULL);
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_free(jobs);
+    g_task_return_pointer(task, batch, forecast_batch_free);
+}
+
+// Shows or hides the habit's warning: the lowest predicted chance among its
+// scheduled days left this week, today included unless already done. A quota
+// habit can be done on any day, so every remaining day counts until its
+// quota is met.
+static void forecast_flag_habit(GtkWidget *habit_box, const Habit *habit, gint32 today) {
+    GtkWidget *forecast_label = g_object_get_data(G_OBJECT(habit_box), "forecast_label");
+    if (!forecast_label) return;
+    guint8 days_mask = 0;
+    if (habit->quota > 0) {
+        if (habit_quota_done_at(habit, today) < habit->quota) days_mask = 0x7f;
+    } else if (habit->schedule_count > 0) {
+        days_mask = habit->schedule[habit->schedule_count - 1].days_mask;
+    }
+    float lowest = 1.0f;
+    int lowest_weekday = -1;
+    for (int weekday = day_number_weekday(today); habit->forecast_weights && weekday < 7; weekday++) {
+        if (!(days_mask & (1 << weekday))) continue;
+        if (weekday == day_number_weekday(today) && habit_counter_range(habit, today, today)) continue;
+        float features[FORECAST_FEATURES];
+        habit_forecast_features(habit, today, weekday, features);
+        float probability = forecast_probability(habit->forecast_weights, features);
+        if (probability < lowest) {
+            lowest = probability;
+            lowest_weekday = weekday;
+        }
+    }
+    if (lowest_weekday < 0 || lowest >= FORECAST_RISK_THRESHOLD) {
+        gtk_widget_set_visible(forecast_label, FALSE);
+        return;
+    }
+    char text[48];
+    snprintf(text, sizeof(text), "Likely to slip %s (%d%%)", weekday_names[lowest_weekday], (int)(lowest * 100 + 0.5f));
+    gtk_label_set_text(GTK_LABEL(forecast_label), text);
+    gtk_widget_set_visible(forecast_label, TRUE);
+}
+
+static void forecast_flag_habits(AppData *app_data, gint64 habit_id) {
+    gint32 today = day_number_today();
+    for (GList *iter = app_data->habit_widgets; iter; iter = iter->next) {
+        GtkWidget *habit_box = iter->data;
+        gint64 box_habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(habit_box), "habit_id"));
+        if (habit_id && box_habit_id != habit_id) continue;
+        const Habit *habit = habit_find(app_data, box_habit_id);
+        if (habit) forecast_flag_habit(habit_box, habit, today);
+    }
+}
+
+static void on_forecast_trained(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    ForecastBatch *batch = g_task_propagate_pointer(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        if (batch) forecast_batch_free(batch);
+        return;
+    }
+
+    AppData *app_data = data;
+    g_clear_object(&app_data->forecast_cancellable);
+    for (guint i = 0; i < batch->habit_count; i++) {
+        Habit *habit = habit_find(app_data, batch->habit_ids[i]);
+        if (!habit || !batch->trained[i]) continue;
+        if (!habit->forecast_weights) habit->forecast_weights = mem_alloc(MEM_MODEL, FORECAST_FEATURES * sizeof(float));
+        memcpy(habit->forecast_weights, batch->weights + (gsize)i * FORECAST_FEATURES, FORECAST_FEATURES * sizeof(float));
+    }
+    forecast_batch_free(batch);
+    forecast_flag_habits(app_data, 0);
+}
+
+static void forecast_start(AppData *app_data) {
+    if (app_data->forecast_cancellable) return;
+    ForecastBatch *batch = g_new0(ForecastBatch, 1);
+    batch->today = day_number_today();
+    batch->habit_count = g_list_length(app_data->habits);
+    batch->habit_ids = g_new(gint64, MAX(batch->habit_count, 1));
+    batch->histories = g_new0(HistoryBitmap *, MAX(batch->habit_count, 1));
+    batch->weights = g_new0(float, MAX((gsize)batch->habit_count * FORECAST_FEATURES, 1));
+    batch->trained = g_new0(gboolean, MAX(batch->habit_count, 1));
+    guint i = 0;
+    for (GList *iter = app_data->habits; iter; iter = iter->next, i++) {
+        batch->habit_ids[i] = ((const Habit *)iter->data)->id;
+    }
+
+    app_data->forecast_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->forecast_cancellable, on_forecast_trained, app_data);
+    g_task_set_task_data(task, batch, NULL);
+    g_task_run_in_thread(task, forecast_thread);
+    g_object_unref(task);
+}
+
+static void forecast_stop(AppData *app_data) {
+    if (app_data->forecast_cancellable) {
+        g_cancellable_cancel(app_data->forecast_cancellable);
+        g_clear_object(&app_data->forecast_cancellable);
+    }
+}
+
+// A check-in is one more labelled sample for the habit's model.
+static void forecast_check_in(AppData *app_data, Habit *habit, gint32 day, gboolean done) {
+    if (habit->forecast_weights) {
+        float features[FORECAST_FEATURES];
+        habit_forecast_features(habit, day, day_number_weekday(day), features);
+        forecast_sgd_step(habit->forecast_weights, features, done);
+    }
+    forecast_flag_habits(app_data, habit->id);
+}
+
+// Habit removal. on_remove_habit drops the habit's row from habits and
+// records a tombstone in one small transaction; the completion history is
+// deleted afterwards by a worker thread on its own connection, PURGE_CHUNK_ROWS
+// rows per transaction. Tombstones stay until their habit has no
+// completions left, so a purge interrupted by quitting resumes on the next start.
+#define PURGE_CHUNK_ROWS 500
+
+static void purge_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(HABIT_DB_PATH, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK) {
+        g_printerr("Purge cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_task_return_int(task, 0);
+        return;
+    }
+    sqlite3_busy_timeout(db, 1000);
+    if (!archive_attach(db)) {
+        g_printerr("Purge cannot attach archive: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_task_return_int(task, 0);
+        return;
+    }
+
+    // habits.id is AUTOINCREMENT, so a tombstoned id is never handed to a
+    // new habit and the job cannot touch rows that are still in use.
+    // The hot rows go first, then the archived ones and their total.
+    sqlite3_stmt *next_stmt = NULL, *chunk_stmt[2] = {NULL, NULL}, *totals_stmt = NULL, *values_stmt = NULL, *schedules_stmt = NULL, *done_stmt = NULL;
+    const char *schemas[] = {"main", "archive"};
+    gboolean prepared = sqlite3_prepare_v2(db, "SELECT habit_id FROM habit_tombstones LIMIT 1;", -1, &next_stmt, NULL) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, "DELETE FROM archive.habit_totals WHERE habit_id = ?1;", -1, &totals_stmt, NULL) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, "DELETE FROM main.habit_values WHERE habit_id = ?1;", -1, &values_stmt, NULL) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, "DELETE FROM main.habit_schedules WHERE habit_id = ?1;", -1, &schedules_stmt, NULL) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, "DELETE FROM habit_tombstones WHERE habit_id = ?1;", -1, &done_stmt, NULL) == SQLITE_OK;
+    for (int i = 0; prepared && i < 2; i++) {
+        char chunk_sql[256];
+        snprintf(chunk_sql, sizeof(chunk_sql),
+                 "DELETE FROM %s.habit_completions WHERE habit_id = ?1 AND day IN "
+                 "(SELECT day FROM %s.habit_completions WHERE habit_id = ?1 LIMIT %d);",
+                 schemas[i], schemas[i], PURGE_CHUNK_ROWS);
+        prepared = sqlite3_prepare_v2(db, chunk_sql, -1, &chunk_stmt[i], NULL) == SQLITE_OK;
+    }
+    gssize purged = 0;
+    if (!prepared) {
+        g_printerr("Purge cannot prepare statements: %s\n", sqlite3_errmsg(db));
+    } else {
+        gboolean failed = FALSE;
+        while (!failed && !g_cancellable_is_cancelled(cancellable) && sqlite3_step(next_stmt) == SQLITE_ROW) {
+            gint64 habit_id = sqlite3_column_int64(next_stmt, 0);
+            sqlite3_reset(next_stmt);
+
+            int changes = 0;
+            for (int i = 0; !failed && changes == 0 && i < 2; i++) {
+                do {
+                    sqlite3_bind_int64(chunk_stmt[i], 1, habit_id);
+                    failed = sqlite3_step(chunk_stmt[i]) != SQLITE_DONE;
+                    changes = sqlite3_changes(db);
+                    sqlite3_reset(chunk_stmt[i]);
+                    purged += failed ? 0 : changes;
+                } while (!failed && changes > 0 && !g_cancellable_is_cancelled(cancellable));
+            }
+
+            if (!failed && changes == 0) {
+                sqlite3_bind_int64(totals_stmt, 1, habit_id);
+                failed = sqlite3_step(totals_stmt) != SQLITE_DONE;
+                sqlite3_reset(totals_stmt);
+            }
+            if (!failed && changes == 0) {
+                sqlite3_bind_int64(values_stmt, 1, habit_id);
+                failed = sqlite3_step(values_stmt) != SQLITE_DONE;
+                sqlite3_reset(values_stmt);
+            }
+            if (!failed && changes == 0) {
+                sqlite3_bind_int64(schedules_stmt, 1, habit_id);
+                failed = sqlite3_step(schedules_stmt) != SQLITE_DONE;
+                sqlite3_reset(schedules_stmt);
+            }
+            if (!failed && changes == 0) {
+                sqlite3_bind_int64(done_stmt, 1, habit_id);
+                failed = sqlite3_step(done_stmt) != SQLITE_DONE;
+                sqlite3_reset(done_stmt);
+            }
+            if (failed) {
+                g_printerr("Purge of habit %" G_GINT64_FORMAT " stopped: %s\n", habit_id, sqlite3_errmsg(db));
+            }
+        }
+        sqlite3_reset(next_stmt);
+    }
+    sqlite3_finalize(next_stmt);
+    sqlite3_finalize(chunk_stmt[0]);
+    sqlite3_finalize(chunk_stmt[1]);
+    sqlite3_finalize(totals_stmt);
+    sqlite3_finalize(values_stmt);
+    sqlite3_finalize(schedules_stmt);
+    sqlite3_finalize(done_stmt);
+    sqlite3_close(db);
+    g_task_return_int(task, purged);
+}
+
+static void purge_start(AppData *app_data);
+
+static void on_purge_done(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    g_task_propagate_int(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) return;
+
+    AppData *app_data = data;
+    g_clear_object(&app_data->purge_cancellable);
+    if (app_data->purge_pending) {
+        app_data->purge_pending = FALSE;
+        purge_start(app_data);
+    }
+}
+
+static void purge_start(AppData *app_data) {
+    if (app_data->purge_cancellable) {
+        // The running job may already have passed its last tombstone query.
+        app_data->purge_pending = TRUE;
+        return;
+    }
+    app_data->purge_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->purge_cancellable, on_purge_done, app_data);
+    g_task_run_in_thread(task, purge_thread);
+    g_object_unref(task);
+}
+
+static void purge_stop(AppData *app_data) {
+    if (app_data->purge_cancellable) {
+        g_cancellable_cancel(app_data->purge_cancellable);
+        g_clear_object(&app_data->purge_cancellable);
+    }
+}
+
+// Moves hot completions dated before the cutoff day number (task_data)
+// into the archive, ARCHIVE_CHUNK_ROWS at a time. Copy and delete share one
+// transaction, but in WAL mode a transaction is only atomic per attached
+// file: a crash during its commit can still leave a chunk in both places.
+// all_completions reads such days from the hot file only, and the next run
+// copies them again idempotently and deletes them.
+static void archive_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    gint32 cutoff = GPOINTER_TO_INT(task_data);
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(HABIT_DB_PATH, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK || !archive_attach(db)) {
+        g_printerr("Archiver cannot open databases: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_task_return_int(task, 0);
+        return;
+    }
+    sqlite3_busy_timeout(db, 1000);
+
+    char batch_sql[256];
+    snprintf(batch_sql, sizeof(batch_sql),
+             "INSERT INTO temp.archive_batch SELECT habit_id, day, completed FROM main.habit_completions "
+             "WHERE day < ?1 LIMIT %d;", ARCHIVE_CHUNK_ROWS);
+    const char *copy_sql =
+        "BEGIN IMMEDIATE;"
+        "INSERT OR REPLACE INTO archive.habit_completions SELECT habit_id, day, completed FROM temp.archive_batch;"
+        "INSERT OR REPLACE INTO archive.habit_totals (habit_id, completed_days, first_day, last_day) "
+        "SELECT habit_id, SUM(completed = 1), MIN(day), MAX(day) FROM archive.habit_completions "
+        "WHERE habit_id IN (SELECT DISTINCT habit_id FROM temp.archive_batch) GROUP BY habit_id;"
+        "DELETE FROM main.habit_completions WHERE (habit_id, day) IN (SELECT habit_id, day FROM temp.archive_batch);"
+        "COMMIT;"
+        "DELETE FROM temp.archive_batch;";
+
+    sqlite3_stmt *batch_stmt = NULL;
+    gssize moved = 0;
+    if (sqlite3_exec(db, "CREATE TEMP TABLE archive_batch (" COMPLETIONS_TABLE_COLUMNS ") WITHOUT ROWID;",
+                     NULL, NULL, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, batch_sql, -1, &batch_stmt, NULL) != SQLITE_OK) {
+        g_printerr("Archiver cannot prepare statements: %s\n", sqlite3_errmsg(db));
+    } else {
+        sqlite3_bind_int(batch_stmt, 1, cutoff);
+        while (!g_cancellable_is_cancelled(cancellable)) {
+            gboolean failed = sqlite3_step(batch_stmt) != SQLITE_DONE;
+            int changes = sqlite3_changes(db);
+            sqlite3_reset(batch_stmt);
+            if (failed || changes == 0) break;
+            if (sqlite3_exec(db, copy_sql, NULL, NULL, NULL) != SQLITE_OK) {
+                g_printerr("Archiving stopped: %s\n", sqlite3_errmsg(db));
+                sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+                break;
+            }
+            moved += changes;
+        }
+    }
+    sqlite3_finalize(batch_stmt);
+    sqlite3_close(db);
+    g_task_return_int(task, moved);
+}
+
+static void on_archive_done(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    g_task_propagate_int(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) return;
+
+    AppData *app_data = data;
+    g_clear_object(&app_data->archive_cancellable);
+}
+
+static void archive_start(AppData *app_data) {
+    if (app_data->archive_cancellable) return;
+
+    const char *hot_days_env = g_getenv("HABIT_TRACKER_HOT_DAYS");
+    guint hot_days = hot_days_env ? (guint)g_ascii_strtoull(hot_days_env, NULL, 10) : 0;
+    if (hot_days == 0) hot_days = ARCHIVE_HOT_DAYS_DEFAULT;
+
+    app_data->archive_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->archive_cancellable, on_archive_done, app_data);
+    g_task_set_task_data(task, GINT_TO_POINTER(day_number_today() - (gint32)hot_days), NULL);
+    g_task_run_in_thread(task, archive_thread);
+    g_object_unref(task);
+}
+
+static void archive_stop(AppData *app_data) {
+    if (app_data->archive_cancellable) {
+        g_cancellable_cancel(app_data->archive_cancellable);
+        g_clear_object(&app_data->archive_cancellable);
+    }
+}
+
+// Brings a quota habit's dashboard entry up to date: the week's progress
+// and whether "Done Today" is still offered.
+static void habit_quota_widgets_refresh(AppData *app_data, const Habit *habit) {
+    if (habit->quota <= 0) return;
+    GtkWidget *habit_box = habit_box_find(app_data, habit->id);
+    if (!habit_box) return;
+    gint32 today = day_number_today();
+    GtkWidget *quota_label = g_object_get_data(G_OBJECT(habit_box), "quota_label");
+    GtkWidget *done_button = g_object_get_data(G_OBJECT(habit_box), "done_button");
+    GtkWidget *amount_box = g_object_get_data(G_OBJECT(habit_box), "amount_box");
+    if (quota_label) {
+        char text[64];
+        snprintf(text, sizeof(text), "%d of %d %s", habit_quota_done_at(habit, today), habit->quota,
+                 habit->quota_rolling ? "in 7 days" : "this week");
+        gtk_label_set_text(GTK_LABEL(quota_label), text);
+    }
+    gboolean due = habit_due_today(habit, today, NULL);
+    if (done_button) gtk_widget_set_visible(done_button, due);
+    // An amount below the target does not complete the day, so a partly
+    // logged day keeps its spin even once the quota is met.
+    if (amount_box) {
+        gtk_widget_set_visible(amount_box, due || (habit->values && habit_values_get(habit->values, today) > 0));
+    }
+}
+
+static void day_rollover_schedule(AppData *app_data);
+
+// Fires just after local midnight: quota windows slide by a day, which
+// can bring "Done Today" back, and every badge redraws for the new day.
+static gboolean on_day_rollover(gpointer data) {
+    AppData *app_data = data;
+    app_data->day_rollover_source = 0;
+    gint32 today = day_number_today();
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        Habit *habit = iter->data;
+        habit_quota_advance(habit, today);
+        habit_quota_widgets_refresh(app_data, habit);
+        // The spin still shows yesterday's amount and would save it as today's.
+        GtkWidget *habit_box = habit_box_find(app_data, habit->id);
+        GtkWidget *amount_spin = habit_box ? g_object_get_data(G_OBJECT(habit_box), "amount_spin") : NULL;
+        if (amount_spin) {
+            g_signal_handlers_block_by_func(amount_spin, on_habit_amount_changed, app_data);
+            gtk_spin_button_set_value(GTK_SPIN_BUTTON(amount_spin), habit->values ? habit_values_get(habit->values, today) : 0);
+            g_signal_handlers_unblock_by_func(amount_spin, on_habit_amount_changed, app_data);
+        }
+    }
+    for (GList *iter = app_data->habit_widgets; iter; iter = iter->next) {
+        gtk_widget_queue_draw(gtk_widget_get_first_child(iter->data));
+    }
+    day_rollover_schedule(app_data);
+    return G_SOURCE_REMOVE;
+}
+
+static void day_rollover_schedule(AppData *app_data) {
+    if (app_data->day_rollover_source) g_source_remove(app_data->day_rollover_source);
+    GDateTime *now = g_date_time_new_now_local();
+    int seconds_today = g_date_time_get_hour(now) * 3600 + g_date_time_get_minute(now) * 60 + g_date_time_get_second(now);
+    g_date_time_unref(now);
+    app_data->day_rollover_source = g_timeout_add_seconds(24 * 3600 - seconds_today + 1, on_day_rollover, app_data);
+}
+
+// Timed sessions against a habit or a timetable task. Each Monday-first
+// week keeps its sessions in one session_log row as a delta-encoded blob:
+// per entry the zigzag varint gap from the previous start in microseconds,
+// the varint duration, then the owner (habit id << 1, or 1 followed by the
+// task text). Decoding a week also sums its time per weekday and two-hour
+// slot; those totals are kept up to date as sessions end, so the timetable
+// reads 84 numbers however many sessions were logged.
+#define SESSION_OWNER_TASK 1
+#define SESSION_SLOT_US ((gint64)2 * 3600 * G_USEC_PER_SEC)
+
+typedef struct {
+    gint32 week;
+    GByteArray *log;
+    gint64 last_start_us;
+    guint count;
+    gint64 slot_us[7][12];
+    gint64 total_us;
+} SessionWeek;
+
+static void session_week_free(gpointer data) {
+    SessionWeek *week = data;
+    g_byte_array_unref(week->log);
+    g_free(week);
+}
+
+static void session_append_varint(GByteArray *log, guint64 value) {
+    guint8 bytes[10];
+    guint length = 0;
+    do {
+        bytes[length] = value & 0x7f;
+        value >>= 7;
+        if (value) bytes[length] |= 0x80;
+        length++;
+    } while (value);
+    g_byte_array_append(log, bytes, length);
+}
+
+static gboolean session_read_varint(const guint8 **pos, const guint8 *end, guint64 *value) {
+    *value = 0;
+    for (int shift = 0; *pos < end && shift < 64; shift += 7) {
+        guint8 byte = *(*pos)++;
+        *value |= (guint64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return TRUE;
+    }
+    return FALSE;
+}
+
+static gint32 session_week_at(gint64 time_us) {
+    GDateTime *local = g_date_time_new_from_unix_local(time_us / G_USEC_PER_SEC);
+    gint32 day = day_number_from_ymd(g_date_time_get_year(local), g_date_time_get_month(local),
+                                     g_date_time_get_day_of_month(local));
+    g_date_time_unref(local);
+    return day_number_week(day);
+}
+
+// Local midnight starting the week's Monday.
+static gint64 session_week_start_us(gint32 week) {
+    int year, month, day;
+    day_number_to_ymd(week * 7 - 3, &year, &month, &day);
+    GDateTime *monday = g_date_time_new_local(year, month, day, 0, 0, 0);
+    gint64 start_us = g_date_time_to_unix(monday) * G_USEC_PER_SEC;
+    g_date_time_unref(monday);
+    return start_us;
+}
+
+// Spreads [start_us, end_us) over the local two-hour slots it covers.
+static void session_slots_add(SessionWeek *week, gint64 start_us, gint64 end_us) {
+    for (gint64 time_us = start_us; time_us < end_us;) {
+        GDateTime *local = g_date_time_new_from_unix_local(time_us / G_USEC_PER_SEC);
+        int weekday = g_date_time_get_day_of_week(local) - 1;
+        int hour = g_date_time_get_hour(local);
+        gint64 into_slot_us = ((gint64)(hour % 2) * 3600 + g_date_time_get_minute(local) * 60 +
+                               g_date_time_get_second(local)) * G_USEC_PER_SEC + time_us % G_USEC_PER_SEC;
+        g_date_time_unref(local);
+        gint64 slot_end_us = MIN(end_us, time_us - into_slot_us + SESSION_SLOT_US);
+        week->slot_us[weekday][hour / 2] += slot_end_us - time_us;
+        week->total_us += slot_end_us - time_us;
+        time_us = slot_end_us;
+    }
+}
+
+// Rebuilds the slot totals from the log; FALSE if the blob is malformed.
+// A damaged log is cut back to its last whole entry so that new entries
+// are appended, and their gaps taken, after that one.
+static gboolean session_week_decode(SessionWeek *week) {
+    const guint8 *pos = week->log->data, *end = pos + week->log->len;
+    gint64 start_us = 0;
+    gboolean intact = TRUE;
+    week->count = 0;
+    while (pos < end) {
+        const guint8 *entry = pos;
+        guint64 gap, duration, owner, length = 0;
+        if (!session_read_varint(&pos, end, &gap) || !session_read_varint(&pos, end, &duration) ||
+            !session_read_varint(&pos, end, &owner) ||
+            (owner == SESSION_OWNER_TASK &&
+             (!session_read_varint(&pos, end, &length) || length > (guint64)(end - pos)))) {
+            g_byte_array_set_size(week->log, entry - week->log->data);
+            intact = FALSE;
+            break;
+        }
+        pos += length;
+        start_us += (gint64)(gap >> 1) ^ -(gint64)(gap & 1);
+        session_slots_add(week, start_us, start_us + (gint64)duration);
+        week->count++;
+    }
+    week->last_start_us = start_us;
+    return intact;
+}
+
+// The week's log and totals, read from session_log the first time it is
+// asked for. Only the current week and the one a session ends in are read.
+static SessionWeek *session_week_get(AppData *app_data, gint32 week_number) {
+    SessionWeek *week = g_hash_table_lookup(app_data->session_weeks, &week_number);
+    if (week) return week;
+
+    week = g_new0(SessionWeek, 1);
+    week->week = week_number;
+    week->log = g_byte_array_new();
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app_data->db, "SELECT entries FROM session_log WHERE week = ?1;", -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, week_number);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            g_byte_array_append(week->log, sqlite3_column_blob(stmt, 0), sqlite3_column_bytes(stmt, 0));
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (!session_week_decode(week)) {
+        g_printerr("Session log for week %d is damaged; dropped the entries after the last readable one.\n", week_number);
+    }
+    g_hash_table_insert(app_data->session_weeks, &week->week, week);
+    return week;
+}
+
+static void session_format_duration(char *buffer, gsize size, gint64 duration_us) {
+    gint64 minutes = duration_us / (60 * G_USEC_PER_SEC);
+    if (minutes >= 60) {
+        snprintf(buffer, size, "%" G_GINT64_FORMAT "h %02dm", minutes / 60, (int)(minutes % 60));
+    } else {
+        snprintf(buffer, size, "%dm", (int)minutes);
+    }
+}
+
+static void session_format_elapsed(char *buffer, gsize size, gint64 elapsed_us) {
+    gint64 seconds = MAX(elapsed_us, 0) / G_USEC_PER_SEC;
+    if (seconds >= 3600) {
+        snprintf(buffer, size, "%d:%02d:%02d", (int)(seconds / 3600), (int)(seconds / 60 % 60), (int)(seconds % 60));
+    } else {
+        snprintf(buffer, size, "%02d:%02d", (int)(seconds / 60), (int)(seconds % 60));
+    }
+}
+
+// Shows this week's tracked time in each timetable cell and the week total
+// in the grid's corner.
+static void timetable_sessions_refresh(AppData *app_data) {
+    if (!app_data->timetable_grid) return;
+    const SessionWeek *week = session_week_get(app_data, session_week_at(g_get_real_time()));
+    char text[32];
+    for (int day_col = 1; day_col <= 7; day_col++) {
+        for (int time_row = 1; time_row <= 12; time_row++) {
+            GtkWidget *task_box = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_col, time_row);
+            GtkWidget *session_label = task_box ? g_object_get_data(G_OBJECT(task_box), "session_label") : NULL;
+            if (!session_label) continue;
+            gint64 slot_us = week->slot_us[day_col - 1][time_row - 1];
+            session_format_duration(text, sizeof(text), slot_us);
+            gtk_label_set_text(GTK_LABEL(session_label), text);
+            gtk_widget_set_visible(session_label, slot_us >= 60 * G_USEC_PER_SEC);
+        }
+    }
+    if (app_data->session_week_label) {
+        session_format_duration(text, sizeof(text), week->total_us);
+        gtk_label_set_text(GTK_LABEL(app_data->session_week_label), text);
+    }
+}
+
+// Logs one finished session, split at week boundaries, and rewrites the
+// touched week rows. Totals change only once the row is stored.
+static void session_record(AppData *app_data, gint64 habit_id, const char *task, gint64 start_us, gint64 end_us) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app_data->db, "INSERT OR REPLACE INTO session_log (week, entries) VALUES (?1, ?2);",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        g_printerr("Failed to log session: %s\n", sqlite3_errmsg(app_data->db));
+        return;
+    }
+    while (start_us < end_us) {
+        SessionWeek *week = session_week_get(app_data, session_week_at(start_us));
+        gint64 piece_end_us = MIN(end_us, session_week_start_us(week->week + 1));
+        guint previous_length = week->log->len;
+        gint64 gap = start_us - week->last_start_us;
+        session_append_varint(week->log, ((guint64)gap << 1) ^ (guint64)(gap >> 63));
+        session_append_varint(week->log, piece_end_us - start_us);
+        if (task) {
+            session_append_varint(week->log, SESSION_OWNER_TASK);
+            session_append_varint(week->log, strlen(task));
+            g_byte_array_append(week->log, (const guint8 *)task, strlen(task));
+        } else {
+            session_append_varint(week->log, (guint64)habit_id << 1);
+        }
+
+        sqlite3_bind_int(stmt, 1, week->week);
+        sqlite3_bind_blob(stmt, 2, week->log->data, week->log->len, SQLITE_STATIC);
+        gboolean stored = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+        if (!stored) {
+            g_printerr("Failed to log session: %s\n", sqlite3_errmsg(app_data->db));
+            g_byte_array_set_size(week->log, previous_length);
+            break;
+        }
+        week->last_start_us = start_us;
+        week->count++;
+        session_slots_add(week, start_us, piece_end_us);
+        start_us = piece_end_us;
+    }
+    sqlite3_finalize(stmt);
+    timetable_sessions_refresh(app_data);
+}
+
+static gboolean on_session_tick(gpointer data) {
+    AppData *app_data = data;
+    if (app_data->session_badge) {
+        gtk_widget_queue_draw(app_data->session_badge);
+    } else if (app_data->session_button) {
+        char label[32], elapsed[16];
+        session_format_elapsed(elapsed, sizeof(elapsed), g_get_real_time() - app_data->session_start_us);
+        snprintf(label, sizeof(label), "Stop %s", elapsed);
+        gtk_button_set_label(GTK_BUTTON(app_data->session_button), label);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Ends the running session, if any, and logs it. Called when its button is
+// pressed again, when another timer starts, when the button goes away
+// with its habit or task, and at shutdown.
+static void session_stop(AppData *app_data) {
+    if (!app_data->session_source) return;
+    g_source_remove(app_data->session_source);
+    app_data->session_source = 0;
+    session_record(app_data, app_data->session_habit_id, app_data->session_task,
+                   app_data->session_start_us, g_get_real_time());
+
+    if (app_data->session_button) {
+        g_signal_handler_disconnect(app_data->session_button, app_data->session_destroy_handler);
+        gtk_button_set_label(GTK_BUTTON(app_data->session_button), "Start Timer");
+        g_object_remove_weak_pointer(G_OBJECT(app_data->session_button), (gpointer *)&app_data->session_button);
+        app_data->session_button = NULL;
+    }
+    if (app_data->session_badge) {
+        g_object_remove_weak_pointer(G_OBJECT(app_data->session_badge), (gpointer *)&app_data->session_badge);
+        gtk_widget_queue_draw(app_data->session_badge);
+        app_data->session_badge = NULL;
+    }
+    app_data->session_habit_id = 0;
+    g_clear_pointer(&app_data->session_task, g_free);
+}
+
+static void on_session_button_destroy(GtkWidget *button, AppData *app_data) {
+    session_stop(app_data);
+}
+
+static void on_session_button_clicked(GtkButton *button, AppData *app_data) {
+    gboolean running_here = app_data->session_source && app_data->session_button == GTK_WIDGET(button);
+    session_stop(app_data);
+    if (running_here) return;
+
+    app_data->session_habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(button), "habit_id"));
+    app_data->session_task = g_strdup(g_object_get_data(G_OBJECT(button), "task"));
+    app_data->session_start_us = g_get_real_time();
+    app_data->session_button = GTK_WIDGET(button);
+    g_object_add_weak_pointer(G_OBJECT(button), (gpointer *)&app_data->session_button);
+    app_data->session_destroy_handler = g_signal_connect(button, "destroy", G_CALLBACK(on_session_button_destroy), app_data);
+    app_data->session_badge = g_object_get_data(G_OBJECT(button), "drawing_area");
+    if (app_data->session_badge) {
+        g_object_add_weak_pointer(G_OBJECT(app_data->session_badge), (gpointer *)&app_data->session_badge);
+        gtk_button_set_label(button, "Stop Timer");
+    }
+    // One source for the one running timer; each tick touches only its badge.
+    app_data->session_source = g_timeout_add_seconds(1, on_session_tick, app_data);
+    on_session_tick(app_data);
+}
+
+// Start/stop button for a habit (with its badge) or a timetable task.
+static GtkWidget *session_button_new(AppData *app_data, gint64 habit_id, const char *task, GtkWidget *drawing_area) {
+    GtkWidget *button = gtk_button_new_with_label("Start Timer");
+    if (task) {
+        g_object_set_data_full(G_OBJECT(button), "task", mem_strdup(MEM_DASHBOARD_UI, task), mem_free);
+    } else {
+        g_object_set_data(G_OBJECT(button), "habit_id", HABIT_ID_TO_POINTER(habit_id));
+        g_object_set_data(G_OBJECT(button), "drawing_area", drawing_area);
+    }
+    g_signal_connect(button, "clicked", G_CALLBACK(on_session_button_clicked), app_data);
+    return button;
+}
+
+// Completed-day counts and strength live on the Habit model: loaded once at
+// startup (or from the snapshot) and adjusted by habit_toggle_day, so
+// drawing a badge never touches the database.
+static void draw_habit_logo(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer data) {
+    AppData *app_data = g_object_get_data(G_OBJECT(area), "app_data");
+    app_data->frame_draw_calls++;
+    Habit *habit = habit_find(app_data, HABIT_ID_FROM_POINTER(data));
+    int days = habit ? habit->days_completed : 0;
+
+    int radius = MIN(width, height) / 2 - 5;
+
+    cairo_arc(cr, width / 2, height / 2, radius, 0, 2 * G_PI);
+    cairo_set_source_rgb(cr, 0.25, 0.65, 0.25);
+    cairo_fill(cr);
+
+    // Strength as a ring along the rim, clockwise from the top.
+    double strength = habit ? habit_strength_at(habit, day_number_today()) : 0.0;
+    cairo_set_line_width(cr, 4);
+    cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 0.25);
+    cairo_arc(cr, width / 2, height / 2, radius - 4, 0, 2 * G_PI);
+    cairo_stroke(cr);
+    if (strength > 0.0) {
+        cairo_set_source_rgb(cr, 1.0, 0.85, 0.3);
+        cairo_arc(cr, width / 2, height / 2, radius - 4, -G_PI / 2, -G_PI / 2 + strength * 2 * G_PI);
+        cairo_stroke(cr);
+    }
+
+    if (habit && app_data->session_source && !app_data->session_task && app_data->session_habit_id == habit->id) {
+        char elapsed[16];
+        session_format_elapsed(elapsed, sizeof(elapsed), g_get_real_time() - app_data->session_start_us);
+        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, 9);
+        cairo_text_extents_t elapsed_extents;
+        cairo_text_extents(cr, elapsed, &elapsed_extents);
+        cairo_move_to(cr, width / 2 - elapsed_extents.width / 2, height / 2 - radius + 17);
+        cairo_show_text(cr, elapsed);
+    }
+
+    if (habit && habit->target > 0) {
+        // Today's amount against the target, as an inner arc and a fraction.
+        double amount = habit->values ? habit_values_get(habit->values, day_number_today()) : 0.0;
+        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+        cairo_set_line_width(cr, 3);
+        if (amount > 0) {
+            cairo_arc(cr, width / 2, height / 2, radius - 10, -G_PI / 2,
+                      -G_PI / 2 + MIN(amount / habit->target, 1.0) * 2 * G_PI);
+            cairo_stroke(cr);
+        }
+        char amount_str[32];
+        snprintf(amount_str, sizeof(amount_str), "%g/%g", amount, habit->target);
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+        cairo_set_font_size(cr, 13);
+        cairo_text_extents_t amount_extents;
+        cairo_text_extents(cr, amount_str, &amount_extents);
+        cairo_move_to(cr, width / 2 - amount_extents.width / 2, height / 2);
+        cairo_show_text(cr, amount_str);
+        cairo_set_font_size(cr, 10);
+        cairo_text_extents(cr, habit->unit, &amount_extents);
+        cairo_move_to(cr, width / 2 - amount_extents.width / 2, height / 2 + 6 + amount_extents.height);
+        cairo_show_text(cr, habit->unit);
+        return;
+    }
+
+    char days_str[16];
+    snprintf(days_str, sizeof(days_str), "%d", days);
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 20);
+    cairo_text_extents_t extents;
+    cairo_text_extents(cr, days_str, &extents);
+    if (!habit) {
+        cairo_move_to(cr, width / 2 - extents.width / 2, height / 2 + extents.height / 2);
+        cairo_show_text(cr, days_str);
+        return;
+    }
+    if (!app_data->show_rolling_counts) {
+        // Lifetime count on top, strength percentage under it.
+        cairo_move_to(cr, width / 2 - extents.width / 2, height / 2);
+        cairo_show_text(cr, days_str);
+        char strength_str[16];
+        snprintf(strength_str, sizeof(strength_str), "%d%%", (int)(strength * 100 + 0.5));
+        cairo_set_font_size(cr, 11);
+        cairo_text_extents(cr, strength_str, &extents);
+        cairo_move_to(cr, width / 2 - extents.width / 2, height / 2 + 6 + extents.height);
+        cairo_show_text(cr, strength_str);
+        return;
+    }
+
+    // Lifetime count on top, then completions in the last 7 / 30 / 365 days.
+    cairo_move_to(cr, width / 2 - extents.width / 2, height / 2);
+    cairo_show_text(cr, days_str);
+    gint32 today = day_number_today();
+    char windows_str[32];
+    snprintf(windows_str, sizeof(windows_str), "%d·%d·%d",
+             habit_counter_range(habit, today - 6, today),
+             habit_counter_range(habit, today - 29, today),
+             habit_counter_range(habit, today - 364, today));
+    cairo_set_font_size(cr, 9);
+    cairo_text_extents(cr, windows_str, &extents);
+    cairo_move_to(cr, width / 2 - extents.width / 2, height / 2 + 6 + extents.height);
+    cairo_show_text(cr, windows_str);
+}
+
+static void add_habit_widget(AppData *app_data, const Habit *habit, const char *current_day_name);
+static void add_habit_to_timetable(AppData *app_data, const Habit *habit);
+static const char *current_weekday_name(void);
+
+static void set_habit_label_text(GtkWidget *label, gint64 habit_id, const Habit *habit) {
+    if (!label || HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(label), "habit_id")) != habit_id) return;
+    if (GTK_IS_LABEL(label)) {
+        gtk_label_set_text(GTK_LABEL(label), habit->name);
+    } else if (strcmp(gtk_editable_get_text(GTK_EDITABLE(label)), habit->name) != 0) {
+        gtk_editable_set_text(GTK_EDITABLE(label), habit->name);
+    }
+}
+
+// Single notification for a changed habit name: every widget that shows it
+// carries "habit_id" data and is refreshed from the model here.
+static void habit_name_changed(AppData *app_data, const Habit *habit) {
+    GtkWidget *habit_box = habit_box_find(app_data, habit->id);
+    if (habit_box) set_habit_label_text(g_object_get_data(G_OBJECT(habit_box), "name_label"), habit->id, habit);
+    heatmap_habit_renamed(app_data, habit);
+
+    if (app_data->timetable_grid) {
+        for (int day_col = 1; day_col <= 7; day_col++) {
+            for (int time_row = 1; time_row <= 12; time_row++) {
+                GtkWidget *task_box = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_col, time_row);
+                for (GtkWidget *child = task_box ? gtk_widget_get_first_child(task_box) : NULL; child; child = gtk_widget_get_next_sibling(child)) {
+                    set_habit_label_text(child, habit->id, habit);
+                }
+            }
+        }
+    }
+
+    if (app_data->edit_habits_grid) {
+        for (GtkWidget *row = gtk_widget_get_first_child(app_data->edit_habits_grid); row; row = gtk_widget_get_next_sibling(row)) {
+            set_habit_label_text(g_object_get_data(G_OBJECT(row), "name_label"), habit->id, habit);
+        }
+    }
+}
+
+// Renaming updates the single habits row; completions reference the id,
+// so the cost does not depend on how much history the habit has.
+static gboolean habit_rename(AppData *app_data, Habit *habit, const char *new_name) {
+    if (!new_name || strlen(new_name) == 0) return FALSE;
+    if (strcmp(habit->name, new_name) == 0) return TRUE;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app_data->db, "UPDATE habits SET name = ?1 WHERE id = ?2;", -1, &stmt, NULL) != SQLITE_OK) {
+        g_printerr("Failed to prepare habit rename: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+    sqlite3_bind_text(stmt, 1, new_name, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, habit->id);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        g_printerr("Failed to rename habit %s: %s\n", habit->name, sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+
+    mem_free(habit->name);
+    habit->name = mem_strdup(MEM_MODEL, new_name);
+    habit_name_changed(app_data, habit);
+    return TRUE;
+}
+
+static void on_habit_name_editing(GtkEditableLabel *label, GParamSpec *pspec, AppData *app_data) {
+    if (gtk_editable_label_get_editing(label)) return;
+
+    Habit *habit = habit_find(app_data, HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(label), "habit_id")));
+    if (!habit) return;
+    if (!habit_rename(app_data, habit, gtk_editable_get_text(GTK_EDITABLE(label)))) {
+        gtk_editable_set_text(GTK_EDITABLE(label), habit->name);
+    }
+}
+
+static GtkWidget *habit_name_editor_new(AppData *app_data, const Habit *habit) {
+    GtkWidget *label = gtk_editable_label_new(habit->name);
+    g_object_set_data(G_OBJECT(label), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+    g_signal_connect(label, "notify::editing", G_CALLBACK(on_habit_name_editing), app_data);
+    return label;
+}
+
+static void timetable_remove_habit_labels(AppData *app_data, gint64 habit_id) {
+    if (!app_data->timetable_grid) return;
+    for (int day_col = 1; day_col <= 7; day_col++) {
+        for (int time_row = 1; time_row <= 12; time_row++) {
+            GtkWidget *task_box = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_col, time_row);
+            if (!task_box) continue;
+            GtkWidget *child = gtk_widget_get_first_child(task_box);
+            while (child) {
+                GtkWidget *next_child = gtk_widget_get_next_sibling(child);
+                if (GTK_IS_LABEL(child) && HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(child), "habit_id")) == habit_id) {
+                    gtk_box_remove(GTK_BOX(task_box), child);
+                }
+                child = next_child;
+            }
+        }
+    }
+}
+
+// Takes an active habit out of the model, the dashboard and the timetable.
+static void habit_detach(AppData *app_data, gint64 habit_id) {
+    Habit *habit = habit_find(app_data, habit_id);
+    if (habit) {
+        habits_remove(app_data, habit);
+        habit_free(habit);
+    } else {
+        g_printerr("Error: Habit %" G_GINT64_FORMAT " not found in habits list\n", habit_id);
+    }
+
+    GtkWidget *habit_box = habit_box_find(app_data, habit_id);
+    if (habit_box) {
+        app_data->habit_widgets = g_list_remove(app_data->habit_widgets, habit_box);
+        g_hash_table_remove(app_data->habit_boxes, &habit_id);
+        gtk_box_remove(GTK_BOX(app_data->habits_box), habit_box);
+        gtk_widget_queue_draw(app_data->habits_box);
+    } else {
+        g_printerr("Error: Habit widget %" G_GINT64_FORMAT " not found in habits_box\n", habit_id);
+    }
+
+    timetable_remove_habit_labels(app_data, habit_id);
+    analytics_invalidate(app_data);
+    heatmap_habit_removed(app_data, habit_id);
+    month_overview_reset(app_data);
+}
+
+static void on_remove_habit(GtkButton *button, AppData *app_data) {
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(button), "habit_id"));
+    GtkWidget *row = (GtkWidget *)g_object_get_data(G_OBJECT(button), "row");
+
+    if (!habit_id || !row) {
+        g_printerr("Error: Invalid habit_id or row in on_remove_habit\n");
+        return;
+    }
+
+    gtk_grid_remove(GTK_GRID(gtk_widget_get_parent(row)), row);
+    habit_detach(app_data, habit_id);
+
+    char remove_query[256];
+    snprintf(remove_query, sizeof(remove_query),
+             "BEGIN; DELETE FROM habits WHERE id = %" G_GINT64_FORMAT "; "
+             "INSERT OR REPLACE INTO habit_tombstones (habit_id) VALUES (%" G_GINT64_FORMAT "); COMMIT;",
+             habit_id, habit_id);
+    if (sqlite3_exec(app_data->db, remove_query, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to remove habit: %s\n", sqlite3_errmsg(app_data->db));
+        sqlite3_exec(app_data->db, "ROLLBACK;", NULL, NULL, NULL);
+        return;
+    }
+    purge_start(app_data);
+}
+
+// Archived habits keep their row and full history but are left out of
+// everything built at startup; they are listed on demand by
+// on_show_archived_habits.
+static void on_archive_habit(GtkButton *button, AppData *app_data) {
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(button), "habit_id"));
+    GtkWidget *row = (GtkWidget *)g_object_get_data(G_OBJECT(button), "row");
+    if (!habit_id || !row) return;
+
+    char query[128];
+    snprintf(query, sizeof(query), "UPDATE habits SET archived = 1 WHERE id = %" G_GINT64_FORMAT ";", habit_id);
+    if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to archive habit: %s\n", sqlite3_errmsg(app_data->db));
+        return;
+    }
+
+    gtk_grid_remove(GTK_GRID(gtk_widget_get_parent(row)), row);
+    habit_detach(app_data, habit_id);
+}
+
+static void on_day_toggled(GtkToggleButton *toggle_button, gpointer data) {
+    AppData *app_data = (AppData *)g_object_get_data(G_OBJECT(toggle_button), "app_data");
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(toggle_button), "habit_id"));
+    Habit *habit = habit_find(app_data, habit_id);
+    if (!habit) return;
+    GtkWidget *hour_dropdown_generic = (GtkWidget *)g_object_get_data(G_OBJECT(toggle_button), "hour_dropdown");
+
+    GtkDropDown* hour_dropdown = GTK_DROP_DOWN(hour_dropdown_generic);
+
+
+    GString *days = g_string_new("");
+    const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+
+    GtkWidget *parent_box = gtk_widget_get_parent(GTK_WIDGET(toggle_button));
+    if (!GTK_IS_BOX(parent_box)) {
+         parent_box = gtk_widget_get_parent(gtk_widget_get_parent(GTK_WIDGET(toggle_button)));
+    }
+
+
+    GtkWidget *child = gtk_widget_get_first_child(parent_box);
+    int current_button_idx = 0;
+    while(child) {
+        if(GTK_IS_TOGGLE_BUTTON(child)) {
+             if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(child))) {
+                if (days->len > 0) g_string_append(days, ",");
+                g_string_append(days, day_names[current_button_idx % 7]);
+            }
+            current_button_idx++;
+        }
+        if(child == GTK_WIDGET(toggle_button) && hour_dropdown == NULL){
+
+            GtkWidget* next_sibling = gtk_widget_get_next_sibling(child);
+            while(next_sibling && !GTK_IS_DROP_DOWN(next_sibling)){
+                 next_sibling = gtk_widget_get_next_sibling(next_sibling);
+            }
+            if(GTK_IS_DROP_DOWN(next_sibling)){
+                hour_dropdown = GTK_DROP_DOWN(next_sibling);
+            }
+        }
+         child = gtk_widget_get_next_sibling(child);
+         if(current_button_idx >=7 && hour_dropdown != NULL) break;
+    }
+
+
+    const char *times[] = {
+        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
+        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
+        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
+    };
+    guint selected_time = 0;
+    if(hour_dropdown){
+        selected_time = gtk_drop_down_get_selected(hour_dropdown);
+    }
+    const char *time_slot = times[selected_time];
+
+    mem_free(habit->days);
+    mem_free(habit->time_slot);
+    habit->days = mem_strdup(MEM_MODEL, days->str);
+    habit->time_slot = mem_strdup(MEM_MODEL, time_slot);
+
+    // The new days apply from today on; earlier versions keep the past.
+    gint32 today = day_number_today();
+    habit_schedule_ensure(habit);
+    ScheduleVersion base = habit->schedule[0];
+    habit_schedule_set(habit, today, schedule_mask_from_days(habit->days));
+    const ScheduleVersion *latest = &habit->schedule[habit->schedule_count - 1];
+
+    timetable_remove_habit_labels(app_data, habit_id);
+    add_habit_to_timetable(app_data, habit);
+    analytics_invalidate(app_data);
+
+    char query[768];
+    int length = snprintf(query, sizeof(query),
+                          "BEGIN; UPDATE habits SET days = '%s', time_slot = '%s' WHERE id = %" G_GINT64_FORMAT ";"
+                          "INSERT OR REPLACE INTO habit_schedules (habit_id, from_day, days_mask) VALUES (%" G_GINT64_FORMAT ", %d, %d);"
+                          "DELETE FROM habit_schedules WHERE habit_id = %" G_GINT64_FORMAT " AND from_day >= %d;",
+                          days->str, time_slot, habit_id, habit_id, base.from_day, base.days_mask, habit_id, today);
+    if (latest->from_day == today) {
+        length += snprintf(query + length, sizeof(query) - length,
+                           "INSERT INTO habit_schedules (habit_id, from_day, days_mask) VALUES (%" G_GINT64_FORMAT ", %d, %d);",
+                           habit_id, latest->from_day, latest->days_mask);
+    }
+    snprintf(query + length, sizeof(query) - length, "COMMIT;");
+    if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to update days and time for habit %s: %s\n", habit->name, sqlite3_errmsg(app_data->db));
+        sqlite3_exec(app_data->db, "ROLLBACK;", NULL, NULL, NULL);
+    }
+
+    g_string_free(days, TRUE);
+}
+
+
+static GtkWidget *edit_habits_row_new(AppData *app_data, const Habit *habit) {
+    const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+    const char *times[] = {
+        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
+        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
+        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
+    };
+    GtkWidget *row_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+
+    GtkWidget *label = habit_name_editor_new(app_data, habit);
+    gtk_widget_set_hexpand(label, TRUE);
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(row_box), label);
+    g_object_set_data(G_OBJECT(row_box), "name_label", label);
+
+
+    const char *days_str = habit->days;
+    const char *time_slot_str = habit->time_slot;
+
+    GtkWidget* day_buttons_in_row[7];
+
+    for (int i = 0; i < 7; i++) {
+        GtkWidget *day_button = gtk_toggle_button_new_with_label(day_names[i]);
+        if (strstr(days_str, day_names[i])) {
+            gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(day_button), TRUE);
+        }
+        g_object_set_data(G_OBJECT(day_button), "app_data", app_data);
+        g_object_set_data(G_OBJECT(day_button), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+        day_buttons_in_row[i] = day_button;
+        gtk_box_append(GTK_BOX(row_box), day_button);
+    }
+
+    GtkStringList *times_list = gtk_string_list_new(NULL);
+    int selected_time = 0;
+    for (int i = 0; i < 12; i++) {
+        gtk_string_list_append(times_list, times[i]);
+        if (strcmp(time_slot_str, times[i]) == 0) {
+            selected_time = i;
+        }
+    }
+    GtkWidget *hour_dropdown = gtk_drop_down_new(G_LIST_MODEL(times_list), NULL);
+    gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown), selected_time);
+    g_object_set_data(G_OBJECT(hour_dropdown), "app_data", app_data);
+    g_object_set_data(G_OBJECT(hour_dropdown), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+
+    for(int i=0; i<7; ++i){
+        g_object_set_data(G_OBJECT(day_buttons_in_row[i]), "hour_dropdown", hour_dropdown);
+        g_signal_connect(day_buttons_in_row[i], "toggled", G_CALLBACK(on_day_toggled), app_data);
+    }
+    g_signal_connect(hour_dropdown, "notify::selected", G_CALLBACK(on_day_toggled), app_data);
+
+    gtk_box_append(GTK_BOX(row_box), hour_dropdown);
+
+    GtkWidget *archive_button = gtk_button_new_with_label("Archive");
+    g_object_set_data(G_OBJECT(archive_button), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+    g_object_set_data(G_OBJECT(archive_button), "row", row_box);
+    g_signal_connect(archive_button, "clicked", G_CALLBACK(on_archive_habit), app_data);
+    gtk_box_append(GTK_BOX(row_box), archive_button);
+
+    GtkWidget *remove_button = gtk_button_new_with_label("Remove");
+    g_object_set_data(G_OBJECT(remove_button), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+    g_object_set_data(G_OBJECT(remove_button), "row", row_box);
+    g_signal_connect(remove_button, "clicked", G_CALLBACK(on_remove_habit), app_data);
+    gtk_box_append(GTK_BOX(row_box), remove_button);
+
+    g_object_unref(times_list);
+    return row_box;
+}
+
+static Habit *habit_restore(AppData *app_data, gint64 habit_id);
+
+static void on_habit_name_prompt_close(GtkButton *button, GtkWidget *dialog) {
+    gtk_window_destroy(GTK_WINDOW(dialog));
+}
+
+static void on_habit_name_prompt_restore(GtkButton *button, AppData *app_data) {
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(button), "habit_id"));
+    GtkWidget *dialog = (GtkWidget *)g_object_get_data(G_OBJECT(button), "dialog");
+    GtkWidget *entry = (GtkWidget *)g_object_get_data(G_OBJECT(button), "entry");
+
+    Habit *habit = habit_restore(app_data, habit_id);
+    if (habit) {
+        if (app_data->edit_habits_grid) {
+            int next_row = 0;
+            for (GtkWidget *child = gtk_widget_get_first_child(app_data->edit_habits_grid); child; child = gtk_widget_get_next_sibling(child)) {
+                next_row++;
+            }
+            gtk_grid_attach(GTK_GRID(app_data->edit_habits_grid), edit_habits_row_new(app_data, habit), 0, next_row, 10, 1);
+        }
+        gtk_editable_set_text(GTK_EDITABLE(entry), "");
+    }
+    gtk_window_destroy(GTK_WINDOW(dialog));
+}
+
+// habits.name is UNIQUE across archived habits too, so a name can be taken by
+// a habit the user no longer sees. Say so, and offer the archived one back.
+static void habit_name_taken_prompt(AppData *app_data, GtkWidget *entry, const char *habit_name) {
+    gint64 archived_id = 0;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app_data->db, "SELECT id FROM habits WHERE name = ?1 AND archived = 1;", -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, habit_name, -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW) archived_id = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    GtkWidget *dialog = gtk_window_new();
+    gtk_window_set_title(GTK_WINDOW(dialog), archived_id ? "Archived Habit" : "Habit Exists");
+    gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(gtk_widget_get_root(entry)));
+    gtk_window_set_modal(GTK_WINDOW(dialog), TRUE);
+    gtk_window_set_destroy_with_parent(GTK_WINDOW(dialog), TRUE);
+    gtk_window_set_resizable(GTK_WINDOW(dialog), FALSE);
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(vbox, 15);
+    gtk_widget_set_margin_end(vbox, 15);
+    gtk_widget_set_margin_top(vbox, 15);
+    gtk_widget_set_margin_bottom(vbox, 15);
+    gtk_window_set_child(GTK_WINDOW(dialog), vbox);
+
+    char message[384];
+    if (archived_id) {
+        snprintf(message, sizeof(message), "\"%s\" is an archived habit. Restore it with its history?", habit_name);
+    } else {
+        snprintf(message, sizeof(message), "A habit named \"%s\" already exists.", habit_name);
+    }
+    GtkWidget *label = gtk_label_new(message);
+    gtk_label_set_wrap(GTK_LABEL(label), TRUE);
+    gtk_box_append(GTK_BOX(vbox), label);
+
+    GtkWidget *button_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_halign(button_box, GTK_ALIGN_CENTER);
+    gtk_box_append(GTK_BOX(vbox), button_box);
+
+    if (archived_id) {
+        GtkWidget *restore_button = gtk_button_new_with_label("Restore");
+        g_object_set_data(G_OBJECT(restore_button), "habit_id", HABIT_ID_TO_POINTER(archived_id));
+        g_object_set_data(G_OBJECT(restore_button), "dialog", dialog);
+        g_object_set_data(G_OBJECT(restore_button), "entry", entry);
+        g_signal_connect(restore_button, "clicked", G_CALLBACK(on_habit_name_prompt_restore), app_data);
+        gtk_box_append(GTK_BOX(button_box), restore_button);
+    }
+
+    GtkWidget *close_button = gtk_button_new_with_label(archived_id ? "Cancel" : "OK");
+    g_signal_connect(close_button, "clicked", G_CALLBACK(on_habit_name_prompt_close), dialog);
+    gtk_box_append(GTK_BOX(button_box), close_button);
+
+    gtk_window_present(GTK_WINDOW(dialog));
+}
+
+static void on_add_habit_in_edit(GtkButton *button, gpointer data) {
+    AppData *app_data = (AppData *)g_object_get_data(G_OBJECT(button), "app_data");
+    GtkWidget *entry = (GtkWidget *)g_object_get_data(G_OBJECT(button), "entry");
+    GtkWidget *habits_grid = (GtkWidget *)g_object_get_data(G_OBJECT(button), "habits_grid");
+    GtkWidget *days_box_container = (GtkWidget *)g_object_get_data(G_OBJECT(button), "days_box");
+    GtkWidget *hour_dropdown_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "hour_dropdown");
+    GtkWidget *target_spin = (GtkWidget *)g_object_get_data(G_OBJECT(button), "target_spin");
+    GtkWidget *unit_entry = (GtkWidget *)g_object_get_data(G_OBJECT(button), "unit_entry");
+    GtkWidget *quota_spin = (GtkWidget *)g_object_get_data(G_OBJECT(button), "quota_spin");
+    GtkWidget *quota_window = (GtkWidget *)g_object_get_data(G_OBJECT(button), "quota_window");
+
+    const char *times[] = {
+        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
+        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
+        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
+    };
+
+    const char *habit_name = gtk_editable_get_text(GTK_EDITABLE(entry));
+    if (habit_name && strlen(habit_name) > 0) {
+        GString *days_str_g = g_string_new("");
+        const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+        GtkWidget *child_day_button = gtk_widget_get_first_child(days_box_container);
+        int day_idx_loop = 0;
+        while(child_day_button && day_idx_loop < 7){
+            if(GTK_IS_TOGGLE_BUTTON(child_day_button)){
+                if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(child_day_button))) {
+                    if (days_str_g->len > 0) g_string_append(days_str_g, ",");
+                    g_string_append(days_str_g, day_names[day_idx_loop]);
+                }
+                day_idx_loop++;
+            }
+            child_day_button = gtk_widget_get_next_sibling(child_day_button);
+        }
+
+
+        guint selected_time = gtk_drop_down_get_selected(GTK_DROP_DOWN(hour_dropdown_widget));
+        const char *time_slot = times[selected_time];
+
+        double target = gtk_spin_button_get_value(GTK_SPIN_BUTTON(target_spin));
+        const char *unit = gtk_editable_get_text(GTK_EDITABLE(unit_entry));
+        int quota = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(quota_spin));
+        gboolean quota_rolling = gtk_drop_down_get_selected(GTK_DROP_DOWN(quota_window)) == 1;
+        sqlite3_stmt *insert_stmt;
+        int rc = sqlite3_prepare_v2(app_data->db,
+                                    "INSERT INTO habits (name, days, time_slot, target, unit, quota, quota_rolling) "
+                                    "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7);", -1, &insert_stmt, NULL);
+        if (rc == SQLITE_OK) {
+            sqlite3_bind_text(insert_stmt, 1, habit_name, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(insert_stmt, 2, days_str_g->str, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(insert_stmt, 3, time_slot, -1, SQLITE_STATIC);
+            sqlite3_bind_double(insert_stmt, 4, target);
+            sqlite3_bind_text(insert_stmt, 5, unit, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(insert_stmt, 6, quota);
+            sqlite3_bind_int(insert_stmt, 7, quota_rolling);
+            rc = sqlite3_step(insert_stmt);
+        }
+        sqlite3_finalize(insert_stmt);
+        if (rc == SQLITE_CONSTRAINT) {
+            habit_name_taken_prompt(app_data, entry, habit_name);
+            g_string_free(days_str_g, TRUE);
+            return;
+        }
+        if (rc != SQLITE_DONE) {
+            g_printerr("Failed to add habit to database: %s\n", sqlite3_errmsg(app_data->db));
+            g_string_free(days_str_g, TRUE);
+            return;
+        }
+
+        char query[256];
+        Habit *habit = habit_new(sqlite3_last_insert_rowid(app_data->db), habit_name, days_str_g->str, time_slot);
+        habit_set_target(habit, target, unit);
+        if (habit->target > 0) habit->values = habit_values_new();
+        habit->quota = quota;
+        habit->quota_rolling = quota_rolling;
+        habit_quota_recompute(habit, day_number_today());
+        habit_schedule_set(habit, day_number_today(), schedule_mask_from_days(habit->days));
+        snprintf(query, sizeof(query),
+                 "INSERT OR REPLACE INTO habit_schedules (habit_id, from_day, days_mask) VALUES (%" G_GINT64_FORMAT ", %d, %d);",
+                 habit->id, habit->schedule[0].from_day, habit->schedule[0].days_mask);
+        if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
+            g_printerr("Failed to store schedule for habit %s: %s\n", habit->name, sqlite3_errmsg(app_data->db));
+        }
+        // A new habit has no completions, so its history is known.
+        habit->history = history_new();
+        habits_append(app_data, habit);
+        add_habit_widget(app_data, habit, current_weekday_name());
+        add_habit_to_timetable(app_data, habit);
+        analytics_invalidate(app_data);
+        heatmap_habit_added(app_data, habit);
+        month_overview_reset(app_data);
+
+        int next_row_grid = 0;
+        GtkWidget *grid_child = gtk_widget_get_first_child(habits_grid);
+        while(grid_child){
+            next_row_grid++;
+            grid_child = gtk_widget_get_next_sibling(grid_child);
+        }
+        if(next_row_grid == 0) next_row_grid = 1;
+
+        gtk_grid_attach(GTK_GRID(habits_grid), edit_habits_row_new(app_data, habit), 0, next_row_grid, 10, 1);
+
+
+        gtk_editable_set_text(GTK_EDITABLE(entry), "");
+        child_day_button = gtk_widget_get_first_child(days_box_container);
+        day_idx_loop = 0;
+         while(child_day_button && day_idx_loop < 7){
+            if(GTK_IS_TOGGLE_BUTTON(child_day_button)){
+                gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(child_day_button), FALSE);
+                day_idx_loop++;
+            }
+            child_day_button = gtk_widget_get_next_sibling(child_day_button);
+        }
+        gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_widget), 0);
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(target_spin), 0);
+        gtk_editable_set_text(GTK_EDITABLE(unit_entry), "");
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(quota_spin), 0);
+        gtk_drop_down_set_selected(GTK_DROP_DOWN(quota_window), 0);
+
+        g_string_free(days_str_g, TRUE);
+    }
+}
+
+static void on_edit_habits_destroy(GtkWidget *edit_window, AppData *app_data) {
+    app_data->edit_habits_window = NULL;
+    app_data->edit_habits_grid = NULL;
+}
+
+static void on_edit_habits(GtkButton *button, AppData *app_data) {
+    GtkWidget *edit_window = gtk_window_new();
+    app_data->edit_habits_window = edit_window;
+    g_signal_connect(edit_window, "destroy", G_CALLBACK(on_edit_habits_destroy), app_data);
+    gtk_window_set_title(GTK_WINDOW(edit_window), "Edit Habits");
+    gtk_window_set_default_size(GTK_WINDOW(edit_window), 900, 600);
+    gtk_window_set_transient_for(GTK_WINDOW(edit_window), GTK_WINDOW(app_data->main_window));
+    gtk_window_set_modal(GTK_WINDOW(edit_window), TRUE);
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(vbox, 10);
+    gtk_widget_set_margin_end(vbox, 10);
+    gtk_widget_set_margin_top(vbox, 10);
+    gtk_widget_set_margin_bottom(vbox, 10);
+    gtk_window_set_child(GTK_WINDOW(edit_window), vbox);
+
+    GtkWidget *habits_grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(habits_grid), 10);
+    gtk_grid_set_column_spacing(GTK_GRID(habits_grid), 5);
+    gtk_grid_set_column_homogeneous(GTK_GRID(habits_grid), TRUE);
+    app_data->edit_habits_grid = habits_grid;
+
+
+    const char *labels[] = {"Habit", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun", "Time Slot", "Action"};
+    for (int i = 0; i < 10; i++) {
+        GtkWidget *label = gtk_label_new(labels[i]);
+        gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
+        gtk_grid_attach(GTK_GRID(habits_grid), label, i, 0, 1, 1);
+    }
+
+    int current_row_idx = 1;
+    const char *day_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+    const char *times[] = {
+        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
+        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
+        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
+    };
+
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        gtk_grid_attach(GTK_GRID(habits_grid), edit_habits_row_new(app_data, iter->data), 0, current_row_idx++, 10, 1);
+    }
+
+
+    GtkWidget *scrolled_window = gtk_scrolled_window_new();
+    gtk_widget_set_vexpand(scrolled_window, TRUE);
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scrolled_window), habits_grid);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window),
+                                   GTK_POLICY_AUTOMATIC,
+                                   GTK_POLICY_AUTOMATIC);
+    gtk_box_append(GTK_BOX(vbox), scrolled_window);
+
+    GtkWidget *separator = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
+    gtk_box_append(GTK_BOX(vbox), separator);
+
+    GtkWidget *add_box_outer = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_box_append(GTK_BOX(vbox), add_box_outer);
+
+    GtkWidget *add_habit_heading = gtk_label_new("Add New Habit");
+    gtk_widget_add_css_class(add_habit_heading, "heading");
+    gtk_widget_set_halign(add_habit_heading, GTK_ALIGN_CENTER);
+    gtk_box_append(GTK_BOX(add_box_outer), add_habit_heading);
+
+    GtkWidget *add_box_fields = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_append(GTK_BOX(add_box_outer), add_box_fields);
+
+
+    GtkWidget *habit_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(habit_entry), "Enter new habit name...");
+    gtk_widget_set_hexpand(habit_entry, TRUE);
+    gtk_box_append(GTK_BOX(add_box_fields), habit_entry);
+
+    GtkWidget *days_box_new = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    for (int i = 0; i < 7; i++) {
+        GtkWidget *day_button = gtk_toggle_button_new_with_label(day_names[i]);
+        gtk_box_append(GTK_BOX(days_box_new), day_button);
+    }
+    gtk_box_append(GTK_BOX(add_box_fields), days_box_new);
+
+    GtkStringList *times_list_new = gtk_string_list_new(NULL);
+    for (int i = 0; i < 12; i++) {
+        gtk_string_list_append(times_list_new, times[i]);
+    }
+    GtkWidget *hour_dropdown_new = gtk_drop_down_new(G_LIST_MODEL(times_list_new), NULL);
+    gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_new), 0);
+    gtk_box_append(GTK_BOX(add_box_fields), hour_dropdown_new);
+
+    // A target above 0 makes a quantitative habit logged in unit per day.
+    GtkWidget *target_spin_new = gtk_spin_button_new_with_range(0, 100000, 1);
+    gtk_widget_set_tooltip_text(target_spin_new, "Daily target (0 for a done/not-done habit)");
+    gtk_box_append(GTK_BOX(add_box_fields), target_spin_new);
+    GtkWidget *unit_entry_new = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(unit_entry_new), "unit");
+    gtk_editable_set_width_chars(GTK_EDITABLE(unit_entry_new), 8);
+    gtk_box_append(GTK_BOX(add_box_fields), unit_entry_new);
+
+    // A quota above 0 asks for that many completions a week on any days.
+    GtkWidget *quota_spin_new = gtk_spin_button_new_with_range(0, 7, 1);
+    gtk_widget_set_tooltip_text(quota_spin_new, "Times per week (0 to follow the selected days)");
+    gtk_box_append(GTK_BOX(add_box_fields), quota_spin_new);
+    const char *quota_windows[] = {"Calendar week", "Rolling 7 days", NULL};
+    GtkWidget *quota_window_new = gtk_drop_down_new_from_strings(quota_windows);
+    gtk_box_append(GTK_BOX(add_box_fields), quota_window_new);
+
+    GtkWidget *add_button_bottom = gtk_button_new_with_label("Add Habit");
+    g_object_set_data(G_OBJECT(add_button_bottom), "app_data", app_data);
+    g_object_set_data(G_OBJECT(add_button_bottom), "entry", habit_entry);
+    g_object_set_data(G_OBJECT(add_button_bottom), "habits_grid", habits_grid);
+    g_object_set_data(G_OBJECT(add_button_bottom), "days_box", days_box_new);
+    g_object_set_data(G_OBJECT(add_button_bottom), "hour_dropdown", hour_dropdown_new);
+    g_object_set_data(G_OBJECT(add_button_bottom), "target_spin", target_spin_new);
+    g_object_set_data(G_OBJECT(add_button_bottom), "unit_entry", unit_entry_new);
+    g_object_set_data(G_OBJECT(add_button_bottom), "quota_spin", quota_spin_new);
+    g_object_set_data(G_OBJECT(add_button_bottom), "quota_window", quota_window_new);
+    g_signal_connect(add_button_bottom, "clicked", G_CALLBACK(on_add_habit_in_edit), app_data);
+    gtk_box_append(GTK_BOX(add_box_outer), add_button_bottom);
+    gtk_widget_set_halign(add_button_bottom, GTK_ALIGN_CENTER);
+
+
+    GtkWidget *separator2 = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
+    gtk_box_append(GTK_BOX(vbox), separator2);
+
+    GtkWidget *save_button = gtk_button_new_with_label("Close");
+    gtk_widget_set_halign(save_button, GTK_ALIGN_END);
+    g_signal_connect_swapped(save_button, "clicked", G_CALLBACK(gtk_window_destroy), edit_window);
+    gtk_box_append(GTK_BOX(vbox), save_button);
+
+    gtk_window_present(GTK_WINDOW(edit_window));
+    g_object_unref(times_list_new);
+}
+
+
+static Habit *habit_restore(AppData *app_data, gint64 habit_id) {
+    char query[384];
+    snprintf(query, sizeof(query),
+             "SELECT name, days, time_slot, (SELECT COUNT(*) FROM main.habit_completions WHERE habit_id = habits.id AND completed = 1) + "
+             "IFNULL((SELECT completed_days FROM archive.habit_totals WHERE habit_id = habits.id), 0), target, unit, quota, quota_rolling "
+             "FROM habits WHERE id = %" G_GINT64_FORMAT " AND archived = 1;", habit_id);
+    sqlite3_stmt *stmt;
+    Habit *habit = NULL;
+    if (sqlite3_prepare_v2(app_data->db, query, -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            habit = habit_new(habit_id, (const char *)sqlite3_column_text(stmt, 0),
+                              (const char *)sqlite3_column_text(stmt, 1),
+                              (const char *)sqlite3_column_text(stmt, 2));
+            habit->days_completed = sqlite3_column_int(stmt, 3);
+            habit_set_target(habit, sqlite3_column_double(stmt, 4), (const char *)sqlite3_column_text(stmt, 5));
+            habit->quota = sqlite3_column_int(stmt, 6);
+            habit->quota_rolling = sqlite3_column_int(stmt, 7);
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (!habit) return NULL;
+
+    GHashTable *habits_by_id = g_hash_table_new(g_int64_hash, g_int64_equal);
+    g_hash_table_insert(habits_by_id, &habit->id, habit);
+    habit_counters_load(app_data->db, "all_completions", habits_by_id, habit_id);
+    habit_schedules_load(app_data->db, habits_by_id, habit_id);
+    g_hash_table_destroy(habits_by_id);
+
+    snprintf(query, sizeof(query), "UPDATE habits SET archived = 0 WHERE id = %" G_GINT64_FORMAT ";", habit_id);
+    if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to restore habit %s: %s\n", habit->name, sqlite3_errmsg(app_data->db));
+        habit_free(habit);
+        return NULL;
+    }
+
+    habits_append(app_data, habit);
+    add_habit_widget(app_data, habit, current_weekday_name());
+    add_habit_to_timetable(app_data, habit);
+    analytics_invalidate(app_data);
+    heatmap_habit_added(app_data, habit);
+    month_overview_reset(app_data);
+    if (habit->target > 0) {
+        if (app_data->values_cancellable) app_data->values_stale = TRUE;
+        values_load_start(app_data);
+    }
+    return habit;
+}
+
+static void on_restore_habit(GtkButton *button, AppData *app_data) {
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(button), "habit_id"));
+    GtkWidget *row = (GtkWidget *)g_object_get_data(G_OBJECT(button), "row");
+
+    if (habit_restore(app_data, habit_id)) {
+        gtk_box_remove(GTK_BOX(gtk_widget_get_parent(row)), row);
+    }
+}
+
+static void on_archive_window_destroy(GtkWidget *window, AppData *app_data) {
+    app_data->archive_window = NULL;
+}
+
+static void on_show_archived_habits(GtkButton *button, AppData *app_data) {
+    GtkWidget *archive_window = gtk_window_new();
+    app_data->archive_window = archive_window;
+    g_signal_connect(archive_window, "destroy", G_CALLBACK(on_archive_window_destroy), app_data);
+    gtk_window_set_title(GTK_WINDOW(archive_window), "Archived Habits");
+    gtk_window_set_default_size(GTK_WINDOW(archive_window), 600, 500);
+    gtk_window_set_transient_for(GTK_WINDOW(archive_window), GTK_WINDOW(app_data->main_window));
+    gtk_window_set_modal(GTK_WINDOW(archive_window), TRUE);
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(vbox, 10);
+    gtk_widget_set_margin_end(vbox, 10);
+    gtk_widget_set_margin_top(vbox, 10);
+    gtk_widget_set_margin_bottom(vbox, 10);
+
+    GtkWidget *scrolled_window = gtk_scrolled_window_new();
+    gtk_widget_set_vexpand(scrolled_window, TRUE);
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scrolled_window), vbox);
+    gtk_window_set_child(GTK_WINDOW(archive_window), scrolled_window);
+
+    // Only read when the view is opened; the habits_archived partial index
+    // covers this query and nothing at startup touches archived rows.
+    sqlite3_stmt *stmt;
+    int archived_count = 0;
+    const char *archived_sql =
+        "SELECT id, name, days, time_slot, (SELECT COUNT(*) FROM main.habit_completions WHERE habit_id = habits.id AND completed = 1) + "
+        "IFNULL((SELECT completed_days FROM archive.habit_totals WHERE habit_id = habits.id), 0) "
+        "FROM habits WHERE archived = 1 ORDER BY name;";
+    if (sqlite3_prepare_v2(app_data->db, archived_sql, -1, &stmt, NULL) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            char row_text[512];
+            snprintf(row_text, sizeof(row_text), "%s (%s, %s) — %d days completed",
+                     (const char *)sqlite3_column_text(stmt, 1), (const char *)sqlite3_column_text(stmt, 2),
+                     (const char *)sqlite3_column_text(stmt, 3), sqlite3_column_int(stmt, 4));
+
+            GtkWidget *row_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+            GtkWidget *row_label = gtk_label_new(row_text);
+            gtk_widget_set_hexpand(row_label, TRUE);
+            gtk_widget_set_halign(row_label, GTK_ALIGN_START);
+            gtk_box_append(GTK_BOX(row_box), row_label);
+
+            GtkWidget *restore_button = gtk_button_new_with_label("Restore");
+            g_object_set_data(G_OBJECT(restore_button), "habit_id", HABIT_ID_TO_POINTER(sqlite3_column_int64(stmt, 0)));
+            g_object_set_data(G_OBJECT(restore_button), "row", row_box);
+            g_signal_connect(restore_button, "clicked", G_CALLBACK(on_restore_habit), app_data);
+            gtk_box_append(GTK_BOX(row_box), restore_button);
+
+            gtk_box_append(GTK_BOX(vbox), row_box);
+            archived_count++;
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    if (archived_count == 0) {
+        gtk_box_append(GTK_BOX(vbox), gtk_label_new("No archived habits."));
+    }
+
+    gtk_window_present(GTK_WINDOW(archive_window));
+}
+
+static void on_mark_task_done(GtkButton *button, AppData *app_data) {
+    gint64 click_us = g_get_monotonic_time();
+    const char *task = (const char *)g_object_get_data(G_OBJECT(button), "task");
+    const char *day = (const char *)g_object_get_data(G_OBJECT(button), "day");
+    const char *time_slot = (const char *)g_object_get_data(G_OBJECT(button), "time_slot");
+    GtkWidget *task_row = (GtkWidget *)g_object_get_data(G_OBJECT(button), "task_row");
+    GtkWidget *task_label_timetable = (GtkWidget *)g_object_get_data(G_OBJECT(button), "task_label_timetable");
+
+
+    if (task_label_timetable && gtk_widget_get_parent(task_label_timetable)) {
+        gtk_box_remove(GTK_BOX(gtk_widget_get_parent(task_label_timetable)), task_label_timetable);
+    } else {
+        // The timetable page was built after this row, so the label is not linked.
+        remove_task_from_timetable(app_data, task, day, time_slot);
+    }
+
+
+    if (task_row && gtk_widget_get_parent(task_row)){
+        gtk_box_remove(GTK_BOX(app_data->pending_tasks_box), task_row);
+    }
+
+
+    char insert_query[512];
+    snprintf(insert_query, sizeof(insert_query),
+             "INSERT INTO completed_tasks (task, day, time_slot) VALUES ('%s', '%s', '%s');",
+             task, day, time_slot);
+    if (sqlite3_exec(app_data->db, insert_query, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to insert task into completed_tasks: %s\n", sqlite3_errmsg(app_data->db));
+    }
+
+    char delete_query[512];
+    snprintf(delete_query, sizeof(delete_query),
+             "DELETE FROM timetable_tasks WHERE task = '%s' AND day = '%s' AND time_slot = '%s';",
+             task, day, time_slot);
+    if (sqlite3_exec(app_data->db, delete_query, NULL, NULL, NULL) != SQLITE_OK) {
+         g_printerr("Failed to delete task from timetable_tasks: %s\n", sqlite3_errmsg(app_data->db));
+    }
+    latency_probe_committed(app_data, LATENCY_ACTION_MARK_TASK_DONE, click_us, app_data->completed_tasks_box);
+
+    char task_display[512];
+    snprintf(task_display, sizeof(task_display), "%s (%s, %s)", task, day, time_slot);
+    GtkWidget *completed_task_label = gtk_label_new(task_display);
+    gtk_widget_set_halign(completed_task_label, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(app_data->completed_tasks_box), completed_task_label);
+    app_data->completed_tasks = g_list_append(app_data->completed_tasks, task_entry_new(task, day, time_slot));
+    tasks_model_remove(app_data, task, day, time_slot);
+}
+
+typedef struct {
+    AppData *app_data;
+    const char *day;
+    const char *time_slot;
+    GtkWidget *task_box_in_grid;
+    GtkWidget *dialog;
+    GtkWidget *entry;
+} TaskDialogData;
+
+
+static void on_add_task_ok_clicked(GtkButton *button, gpointer data) {
+    TaskDialogData *task_data = data;
+
+    const char *task_text = gtk_editable_get_text(GTK_EDITABLE(task_data->entry));
+    if (task_text && strlen(task_text) > 0) {
+        char query[512];
+        snprintf(query, sizeof(query),
+                 "INSERT INTO timetable_tasks (day, time_slot, task) VALUES ('%s', '%s', '%s');",
+                 task_data->day, task_data->time_slot, task_text);
+        if (sqlite3_exec(task_data->app_data->db, query, NULL, NULL, NULL) == SQLITE_OK) {
+
+            GtkWidget *task_label_timetable = gtk_label_new(task_text);
+            gtk_widget_set_halign(task_label_timetable, GTK_ALIGN_START);
+            gtk_box_append(GTK_BOX(task_data->task_box_in_grid), task_label_timetable);
+
+            char task_display[512];
+            snprintf(task_display, sizeof(task_display), "%s (%s, %s)", task_text, task_data->day, task_data->time_slot);
+            GtkWidget *task_row_pending = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+            GtkWidget *pending_task_label_widget = gtk_label_new(task_display);
+            gtk_widget_set_halign(pending_task_label_widget, GTK_ALIGN_START);
+            gtk_box_append(GTK_BOX(task_row_pending), pending_task_label_widget);
+
+            GtkWidget *done_button = gtk_button_new_with_label("Mark as Done");
+            g_object_set_data_full(G_OBJECT(done_button), "task", mem_strdup(MEM_DASHBOARD_UI, task_text), mem_free);
+            g_object_set_data_full(G_OBJECT(done_button), "day", mem_strdup(MEM_DASHBOARD_UI, task_data->day), mem_free);
+            g_object_set_data_full(G_OBJECT(done_button), "time_slot", mem_strdup(MEM_DASHBOARD_UI, task_data->time_slot), mem_free);
+            g_object_set_data(G_OBJECT(done_button), "task_row", task_row_pending);
+            g_object_set_data(G_OBJECT(done_button), "task_label_timetable", task_label_timetable);
+            g_signal_connect(done_button, "clicked", G_CALLBACK(on_mark_task_done), task_data->app_data);
+            gtk_box_append(GTK_BOX(task_row_pending), session_button_new(task_data->app_data, 0, task_text, NULL));
+            gtk_box_append(GTK_BOX(task_row_pending), done_button);
+
+            gtk_box_append(GTK_BOX(task_data->app_data->pending_tasks_box), task_row_pending);
+            task_data->app_data->tasks = g_list_append(task_data->app_data->tasks,
+                                                       task_entry_new(task_text, task_data->day, task_data->time_slot));
+        } else {
+            g_printerr("Failed to add task to database: %s\n", sqlite3_errmsg(task_data->app_data->db));
+        }
+    }
+
+    gtk_window_destroy(GTK_WINDOW(task_data->dialog));
+    mem_free(task_data);
+}
+
+static void on_add_task_cancel_clicked(GtkButton *button, gpointer data) {
+    TaskDialogData *task_data = data;
+    gtk_window_destroy(GTK_WINDOW(task_data->dialog));
+    mem_free(task_data);
+}
+
+typedef struct {
+    AppData *app_data;
+    char *day;
+    char *time_slot;
+    GtkWidget *task_box_in_grid;
+} TimetableCellData;
+
+
+static void on_timetable_cell_clicked(GtkGestureClick *gesture, gint n_press, gdouble x, gdouble y, gpointer data) {
+    TimetableCellData *cell_data = data;
+
+    GtkWidget *dialog = gtk_window_new();
+    gtk_window_set_title(GTK_WINDOW(dialog), "Add Task");
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 350, 200);
+    gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(cell_data->app_data->main_window));
+    gtk_window_set_modal(GTK_WINDOW(dialog), TRUE);
+    gtk_window_set_resizable(GTK_WINDOW(dialog), FALSE);
+
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(vbox, 15);
+    gtk_widget_set_margin_end(vbox, 15);
+    gtk_widget_set_margin_top(vbox, 15);
+    gtk_widget_set_margin_bottom(vbox, 15);
+    gtk_window_set_child(GTK_WINDOW(dialog), vbox);
+
+    char label_text[128];
+    snprintf(label_text, sizeof(label_text), "Add task for %s at %s", cell_data->day, cell_data->time_slot);
+    GtkWidget *label = gtk_label_new(label_text);
+    gtk_widget_add_css_class(label,"heading");
+    gtk_box_append(GTK_BOX(vbox), label);
+
+    GtkWidget *entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(entry), "Enter task description...");
+    gtk_box_append(GTK_BOX(vbox), entry);
+
+    GtkWidget *button_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_halign(button_box, GTK_ALIGN_CENTER);
+    gtk_box_append(GTK_BOX(vbox), button_box);
+
+    TaskDialogData *task_dialog_data = mem_alloc(MEM_TIMETABLE_UI, sizeof(TaskDialogData));
+    task_dialog_data->app_data = cell_data->app_data;
+    task_dialog_data->day = cell_data->day;
+    task_dialog_data->time_slot = cell_data->time_slot;
+    task_dialog_data->task_box_in_grid = cell_data->task_box_in_grid;
+    task_dialog_data->dialog = dialog;
+    task_dialog_data->entry = entry;
+
+    GtkWidget *ok_button = gtk_button_new_with_label("OK");
+    g_signal_connect(ok_button, "clicked", G_CALLBACK(on_add_task_ok_clicked), task_dialog_data);
+    gtk_box_append(GTK_BOX(button_box), ok_button);
+
+    GtkWidget *cancel_button = gtk_button_new_with_label("Cancel");
+    g_signal_connect(cancel_button, "clicked", G_CALLBACK(on_add_task_cancel_clicked), task_dialog_data);
+    gtk_box_append(GTK_BOX(button_box), cancel_button);
+
+    gtk_window_present(GTK_WINDOW(dialog));
+}
+
+static void free_timetable_cell_data(gpointer data) {
+    TimetableCellData *cell_data = data;
+    mem_free(cell_data->day);
+    mem_free(cell_data->time_slot);
+    mem_free(cell_data);
+}
+
+
+static void on_remove_task(GtkButton *button, AppData *app_data) {
+    const char *task = (const char *)g_object_get_data(G_OBJECT(button), "task");
+    const char *day = (const char *)g_object_get_data(G_OBJECT(button), "day");
+    const char *time_slot = (const char *)g_object_get_data(G_OBJECT(button), "time_slot");
+    GtkWidget *row_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "row");
+
+    char query[512];
+    snprintf(query, sizeof(query),
+             "DELETE FROM timetable_tasks WHERE task = '%s' AND day = '%s' AND time_slot = '%s';",
+             task, day, time_slot);
+    if (sqlite3_exec(app_data->db, query, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to delete task from timetable_tasks: %s\n", sqlite3_errmsg(app_data->db));
+    }
+
+
+    GtkWidget *child = gtk_widget_get_first_child(app_data->pending_tasks_box);
+    while (child) {
+        GtkWidget *next = gtk_widget_get_next_sibling(child);
+        GtkWidget *label_widget = gtk_widget_get_first_child(child);
+        if (label_widget && GTK_IS_LABEL(label_widget)) {
+            const char *label_text_pending = gtk_label_get_text(GTK_LABEL(label_widget));
+            char task_display_pending[512];
+            snprintf(task_display_pending, sizeof(task_display_pending), "%s (%s, %s)", task, day, time_slot);
+            if (strcmp(label_text_pending, task_display_pending) == 0) {
+                gtk_box_remove(GTK_BOX(app_data->pending_tasks_box), child);
+                break;
+            }
+        }
+        child = next;
+    }
+
+    remove_task_from_timetable(app_data, task, day, time_slot);
+
+    if (row_widget && gtk_widget_get_parent(row_widget)) {
+        gtk_grid_remove(GTK_GRID(gtk_widget_get_parent(row_widget)), row_widget);
+    }
+    tasks_model_remove(app_data, task, day, time_slot);
+}
+
+
+static void on_add_task_in_edit(GtkButton *button, gpointer data) {
+    AppData *app_data = (AppData *)g_object_get_data(G_OBJECT(button), "app_data");
+    GtkWidget *entry_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "entry");
+    GtkWidget *calendar_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "calendar");
+    GtkWidget *hour_dropdown_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "hour_dropdown");
+    GtkWidget *tasks_grid_widget = (GtkWidget *)g_object_get_data(G_OBJECT(button), "tasks_grid");
+
+
+    const char *task_text = gtk_editable_get_text(GTK_EDITABLE(entry_widget));
+    if (task_text && strlen(task_text) > 0) {
+        GDateTime *calendar_date = gtk_calendar_get_date(GTK_CALENDAR(calendar_widget));
+        if (!calendar_date) return;
+
+        guint year_val = g_date_time_get_year(calendar_date);
+        guint month_val = g_date_time_get_month(calendar_date);
+        guint day_val = g_date_time_get_day_of_month(calendar_date);
+        g_date_time_unref(calendar_date);
+
+        guint selected_hour_val = gtk_drop_down_get_selected(GTK_DROP_DOWN(hour_dropdown_widget));
+        int hour_int = (int)selected_hour_val;
+
+        GDateTime *due_date_time = g_date_time_new_local(year_val, month_val, day_val, hour_int, 0, 0);
+        if (!due_date_time) return;
+
+
+        const char *days_of_week_map[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"}; //GTK is 1-7 Mon-Sun
+        int day_of_week_idx = g_date_time_get_day_of_week(due_date_time); // 1=Mon, ..., 7=Sun
+        const char *day_str_val = days_of_week_map[day_of_week_idx -1];
+
+
+        const char *time_slots_map[] = {
+            "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
+            "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
+            "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
         };
         int time_slot_idx_val = hour_int / 2;
         const char *time_slot_str_val = time_slots_map[time_slot_idx_val];
 
-        char query_insert[512];
-        snprintf(query_insert, sizeof(query_insert),
-                 "INSERT INTO timetable_tasks (day, time_slot, task) VALUES ('%s', '%s', '%s');",
-                 day_str_val, time_slot_str_val, task_text);
-        if (sqlite3_exec(app_data->db, query_insert, NULL, NULL, NULL) == SQLITE_OK) {
+        char query_insert[512];
+        snprintf(query_insert, sizeof(query_insert),
+                 "INSERT INTO timetable_tasks (day, time_slot, task) VALUES ('%s', '%s', '%s');",
+                 day_str_val, time_slot_str_val, task_text);
+        if (sqlite3_exec(app_data->db, query_insert, NULL, NULL, NULL) == SQLITE_OK) {
+
+            int day_idx_grid = 0, time_idx_grid = 0;
+             const char *days_grid_map[] = {"", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"}; // Grid is 1-indexed for days
+            for (int i = 1; i <= 7; i++) {
+                if (strcmp(days_grid_map[i], day_str_val) == 0) {
+                    day_idx_grid = i;
+                    break;
+                }
+            }
+            for (int i = 0; i < 12; i++) {
+                if (strcmp(time_slots_map[i], time_slot_str_val) == 0) {
+                    time_idx_grid = i + 1; // Grid is 1-indexed for time slots
+                    break;
+                }
+            }
+
+            GtkWidget *task_label_timetable = NULL;
+            if (app_data->timetable_grid && day_idx_grid > 0 && time_idx_grid > 0) {
+                GtkWidget *task_box_cell = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_idx_grid, time_idx_grid);
+                if (task_box_cell) {
+                    task_label_timetable = gtk_label_new(task_text);
+                    gtk_widget_set_halign(task_label_timetable, GTK_ALIGN_START);
+                    gtk_box_append(GTK_BOX(task_box_cell), task_label_timetable);
+                }
+            }
+
+            char task_display_pending[512];
+            snprintf(task_display_pending, sizeof(task_display_pending), "%s (%s, %s)", task_text, day_str_val, time_slot_str_val);
+            GtkWidget *task_row_box_pending = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+            GtkWidget *pending_task_label_ui = gtk_label_new(task_display_pending);
+            gtk_widget_set_halign(pending_task_label_ui, GTK_ALIGN_START);
+            gtk_box_append(GTK_BOX(task_row_box_pending), pending_task_label_ui);
+
+            GtkWidget *done_button_pending = gtk_button_new_with_label("Mark as Done");
+            g_object_set_data_full(G_OBJECT(done_button_pending), "task", mem_strdup(MEM_DASHBOARD_UI, task_text), mem_free);
+            g_object_set_data_full(G_OBJECT(done_button_pending), "day", mem_strdup(MEM_DASHBOARD_UI, day_str_val), mem_free);
+            g_object_set_data_full(G_OBJECT(done_button_pending), "time_slot", mem_strdup(MEM_DASHBOARD_UI, time_slot_str_val), mem_free);
+            g_object_set_data(G_OBJECT(done_button_pending), "task_row", task_row_box_pending);
+            if (task_label_timetable) {
+                g_object_set_data(G_OBJECT(done_button_pending), "task_label_timetable", task_label_timetable);
+            }
+            g_signal_connect(done_button_pending, "clicked", G_CALLBACK(on_mark_task_done), app_data);
+            gtk_box_append(GTK_BOX(task_row_box_pending), done_button_pending);
+
+            gtk_box_append(GTK_BOX(app_data->pending_tasks_box), task_row_box_pending);
+            app_data->tasks = g_list_append(app_data->tasks, task_entry_new(task_text, day_str_val, time_slot_str_val));
+
+
+            int next_row_edit_grid = 0;
+            GtkWidget *edit_grid_child = gtk_widget_get_first_child(tasks_grid_widget);
+            while(edit_grid_child){
+                next_row_edit_grid++;
+                edit_grid_child = gtk_widget_get_next_sibling(edit_grid_child);
+            }
+             if(next_row_edit_grid == 0) next_row_edit_grid = 1;
+
+
+            GtkWidget *row_box_edit_task = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+            char display_edit_task[512];
+            snprintf(display_edit_task, sizeof(display_edit_task), "%s (%s, %s)", task_text, day_str_val, time_slot_str_val);
+            GtkWidget *task_label_edit_ui = gtk_label_new(display_edit_task);
+             gtk_widget_set_hexpand(task_label_edit_ui, TRUE);
+            gtk_widget_set_halign(task_label_edit_ui, GTK_ALIGN_START);
+            gtk_box_append(GTK_BOX(row_box_edit_task), task_label_edit_ui);
+
+            GtkWidget *remove_button_edit_task = gtk_button_new_with_label("Remove");
+            g_object_set_data_full(G_OBJECT(remove_button_edit_task), "task", mem_strdup(MEM_DASHBOARD_UI, task_text), mem_free);
+            g_object_set_data_full(G_OBJECT(remove_button_edit_task), "day", mem_strdup(MEM_DASHBOARD_UI, day_str_val), mem_free);
+            g_object_set_data_full(G_OBJECT(remove_button_edit_task), "time_slot", mem_strdup(MEM_DASHBOARD_UI, time_slot_str_val), mem_free);
+            g_object_set_data(G_OBJECT(remove_button_edit_task), "row", row_box_edit_task);
+            g_signal_connect(remove_button_edit_task, "clicked", G_CALLBACK(on_remove_task), app_data);
+            gtk_box_append(GTK_BOX(row_box_edit_task), remove_button_edit_task);
+
+            gtk_grid_attach(GTK_GRID(tasks_grid_widget), row_box_edit_task, 0, next_row_edit_grid, 2, 1);
+        } else {
+            g_printerr("Failed to add task to database: %s\n", sqlite3_errmsg(app_data->db));
+        }
+
+        g_date_time_unref(due_date_time);
+        gtk_editable_set_text(GTK_EDITABLE(entry_widget), "");
+        gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_widget), 0);
+        GDateTime *now = g_date_time_new_now_local();
+        gtk_calendar_select_day(GTK_CALENDAR(calendar_widget), now);
+        g_date_time_unref(now);
+
+    }
+}
+
+
+static void on_edit_tasks(GtkButton *button, AppData *app_data) {
+    GtkWidget *edit_window = gtk_window_new();
+    gtk_window_set_title(GTK_WINDOW(edit_window), "Edit Tasks");
+    gtk_window_set_transient_for(GTK_WINDOW(edit_window), GTK_WINDOW(app_data->main_window));
+    gtk_window_set_modal(GTK_WINDOW(edit_window), TRUE);
+    gtk_window_set_default_size(GTK_WINDOW(edit_window), 700, 700);
+
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(vbox, 15);
+    gtk_widget_set_margin_end(vbox, 15);
+    gtk_widget_set_margin_top(vbox, 15);
+    gtk_widget_set_margin_bottom(vbox, 15);
+    gtk_window_set_child(GTK_WINDOW(edit_window), vbox);
+
+    GtkWidget *tasks_grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(tasks_grid), 5);
+    gtk_grid_set_column_spacing(GTK_GRID(tasks_grid), 10);
+    gtk_grid_set_column_homogeneous(GTK_GRID(tasks_grid), TRUE);
+
+
+    const char *labels[] = {"Task (Day, Time Slot)", "Action"};
+    GtkWidget* header_label1 = gtk_label_new(labels[0]);
+    gtk_widget_set_halign(header_label1, GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(tasks_grid), header_label1, 0, 0, 1, 1);
+    GtkWidget* header_label2 = gtk_label_new(labels[1]);
+    gtk_widget_set_halign(header_label2, GTK_ALIGN_CENTER);
+    gtk_grid_attach(GTK_GRID(tasks_grid), header_label2, 1, 0, 1, 1);
+
+
+    int row_idx = 1;
+    for (GList *iter = app_data->tasks; iter; iter = iter->next) {
+        const TaskEntry *entry = iter->data;
+        const char *task_text = entry->task;
+        const char *day_text = entry->day;
+        const char *time_slot_text = entry->time_slot;
+
+        GtkWidget *row_box_display = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+        char display_text[512];
+        snprintf(display_text, sizeof(display_text), "%s (%s, %s)", task_text, day_text, time_slot_text);
+        GtkWidget *task_label_display = gtk_label_new(display_text);
+        gtk_widget_set_hexpand(task_label_display, TRUE);
+        gtk_widget_set_halign(task_label_display, GTK_ALIGN_START);
+        gtk_box_append(GTK_BOX(row_box_display), task_label_display);
+
+        GtkWidget *remove_button_display = gtk_button_new_with_label("Remove");
+        g_object_set_data_full(G_OBJECT(remove_button_display), "task", mem_strdup(MEM_DASHBOARD_UI, task_text), mem_free);
+        g_object_set_data_full(G_OBJECT(remove_button_display), "day", mem_strdup(MEM_DASHBOARD_UI, day_text), mem_free);
+        g_object_set_data_full(G_OBJECT(remove_button_display), "time_slot", mem_strdup(MEM_DASHBOARD_UI, time_slot_text), mem_free);
+        g_object_set_data(G_OBJECT(remove_button_display), "row", row_box_display);
+        g_signal_connect(remove_button_display, "clicked", G_CALLBACK(on_remove_task), app_data);
+        gtk_box_append(GTK_BOX(row_box_display), remove_button_display);
+
+        gtk_grid_attach(GTK_GRID(tasks_grid), row_box_display, 0, row_idx++, 2, 1);
+    }
+
+    GtkWidget *scrolled_window_tasks = gtk_scrolled_window_new();
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scrolled_window_tasks), tasks_grid);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window_tasks),
+                                   GTK_POLICY_AUTOMATIC,
+                                   GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_vexpand(scrolled_window_tasks, TRUE);
+    gtk_box_append(GTK_BOX(vbox), scrolled_window_tasks);
+
+    GtkWidget *separator_edit_task = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
+    gtk_box_append(GTK_BOX(vbox), separator_edit_task);
+
+    GtkWidget *add_task_section_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_box_append(GTK_BOX(vbox), add_task_section_box);
+
+    GtkWidget *add_task_heading = gtk_label_new("Add New Task");
+    gtk_widget_add_css_class(add_task_heading, "heading");
+    gtk_widget_set_halign(add_task_heading, GTK_ALIGN_CENTER);
+    gtk_box_append(GTK_BOX(add_task_section_box), add_task_heading);
+
+
+    GtkWidget *task_entry_new = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(task_entry_new), "Enter new task description...");
+    gtk_box_append(GTK_BOX(add_task_section_box), task_entry_new);
+
+    GtkWidget *date_time_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_halign(date_time_box, GTK_ALIGN_CENTER);
+    gtk_box_append(GTK_BOX(add_task_section_box), date_time_box);
+
+    GtkWidget *calendar_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_box_append(GTK_BOX(date_time_box), calendar_box);
+    GtkWidget *calendar_label_new = gtk_label_new("Due Date:");
+    gtk_widget_set_halign(calendar_label_new, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(calendar_box), calendar_label_new);
+    GtkWidget *calendar_new = gtk_calendar_new();
+    gtk_box_append(GTK_BOX(calendar_box), calendar_new);
+
+
+    GtkWidget *time_select_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_widget_set_valign(time_select_box, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(date_time_box), time_select_box);
+    GtkWidget *time_label_new = gtk_label_new("Due Time (Hour):");
+    gtk_widget_set_halign(time_label_new, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(time_select_box), time_label_new);
+
+    GtkStringList *hours_list_new = gtk_string_list_new(NULL);
+    for (int i = 0; i < 24; i++) {
+        char hour_str[3];
+        snprintf(hour_str, sizeof(hour_str), "%02d", i);
+        gtk_string_list_append(hours_list_new, hour_str);
+    }
+    GtkWidget *hour_dropdown_new_task = gtk_drop_down_new(G_LIST_MODEL(hours_list_new), NULL);
+    gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_new_task), 0);
+    gtk_box_append(GTK_BOX(time_select_box), hour_dropdown_new_task);
+    g_object_unref(hours_list_new);
+
+
+    GtkWidget *add_button_new_task = gtk_button_new_with_label("Add Task");
+    gtk_widget_set_halign(add_button_new_task, GTK_ALIGN_CENTER);
+    g_object_set_data(G_OBJECT(add_button_new_task), "app_data", app_data);
+    g_object_set_data(G_OBJECT(add_button_new_task), "entry", task_entry_new);
+    g_object_set_data(G_OBJECT(add_button_new_task), "calendar", calendar_new);
+    g_object_set_data(G_OBJECT(add_button_new_task), "hour_dropdown", hour_dropdown_new_task);
+    g_object_set_data(G_OBJECT(add_button_new_task), "tasks_grid", tasks_grid);
+    g_signal_connect(add_button_new_task, "clicked", G_CALLBACK(on_add_task_in_edit), app_data);
+    gtk_box_append(GTK_BOX(add_task_section_box), add_button_new_task);
+
+    GtkWidget *separator_edit_task2 = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
+    gtk_box_append(GTK_BOX(vbox), separator_edit_task2);
+
+    GtkWidget *save_button_edit_task = gtk_button_new_with_label("Close");
+    gtk_widget_set_halign(save_button_edit_task, GTK_ALIGN_END);
+    g_signal_connect_swapped(save_button_edit_task, "clicked", G_CALLBACK(gtk_window_destroy), edit_window);
+    gtk_box_append(GTK_BOX(vbox), save_button_edit_task);
+
+    gtk_window_present(GTK_WINDOW(edit_window));
+}
+
+
+static GtkWidget *create_timetable_page(AppData *app_data) {
+    GtkWidget *grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(grid), 3);
+    gtk_grid_set_column_spacing(GTK_GRID(grid), 3);
+    gtk_widget_set_margin_start(grid, 10);
+    gtk_widget_set_margin_end(grid, 10);
+    gtk_widget_set_margin_top(grid, 10);
+    gtk_widget_set_margin_bottom(grid, 10);
+    gtk_widget_set_hexpand(grid, TRUE);
+    gtk_widget_set_vexpand(grid, TRUE);
+    gtk_grid_set_column_homogeneous(GTK_GRID(grid), TRUE);
+    gtk_grid_set_row_homogeneous(GTK_GRID(grid), TRUE);
+
+
+    app_data->timetable_grid = grid;
+
+    const char *days[] = {"", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+    for (int i = 0; i < 8; i++) {
+        GtkWidget *label = gtk_label_new(days[i]);
+        gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
+        gtk_widget_set_valign(label, GTK_ALIGN_CENTER);
+        gtk_widget_add_css_class(label, "heading");
+        gtk_grid_attach(GTK_GRID(grid), label, i, 0, 1, 1);
+        if (i == 0) {
+            gtk_widget_set_tooltip_text(label, "Time tracked this week");
+            app_data->session_week_label = label;
+        }
+    }
+
+    const char *times[] = {
+        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
+        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
+        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
+    };
+    for (int i = 0; i < 12; i++) {
+        GtkWidget *label = gtk_label_new(times[i]);
+        gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
+         gtk_widget_set_valign(label, GTK_ALIGN_CENTER);
+        gtk_widget_add_css_class(label, "heading");
+        gtk_grid_attach(GTK_GRID(grid), label, 0, i + 1, 1, 1);
+    }
+
+    for (int day_col = 1; day_col <= 7; day_col++) {
+        for (int time_row = 1; time_row <= 12; time_row++) {
+            GtkWidget *task_box_cell = gtk_box_new(GTK_ORIENTATION_VERTICAL, 3);
+            gtk_widget_set_hexpand(task_box_cell, TRUE);
+            gtk_widget_set_vexpand(task_box_cell, TRUE);
+            gtk_widget_add_css_class(task_box_cell, "task-slot");
+            GtkWidget *session_label = gtk_label_new("");
+            gtk_widget_set_halign(session_label, GTK_ALIGN_END);
+            gtk_widget_add_css_class(session_label, "session-time");
+            gtk_widget_set_visible(session_label, FALSE);
+            gtk_box_append(GTK_BOX(task_box_cell), session_label);
+            g_object_set_data(G_OBJECT(task_box_cell), "session_label", session_label);
+
+            GtkGesture *click_controller = gtk_gesture_click_new();
+            TimetableCellData *cell_data = mem_alloc(MEM_TIMETABLE_UI, sizeof(TimetableCellData));
+            cell_data->app_data = app_data;
+            cell_data->day = mem_strdup(MEM_TIMETABLE_UI, days[day_col]);
+            cell_data->time_slot = mem_strdup(MEM_TIMETABLE_UI, times[time_row - 1]);
+            cell_data->task_box_in_grid = task_box_cell;
+
+            g_signal_connect_data(click_controller, "pressed", G_CALLBACK(on_timetable_cell_clicked), cell_data, (GClosureNotify)free_timetable_cell_data, 0);
+            gtk_widget_add_controller(task_box_cell, GTK_EVENT_CONTROLLER(click_controller));
+
+            gtk_grid_attach(GTK_GRID(grid), task_box_cell, day_col, time_row, 1, 1);
+        }
+    }
+
+    return grid;
+}
+
+static gboolean table_has_column(sqlite3 *db, const char *schema, const char *table, const char *column) {
+    char query[128];
+    snprintf(query, sizeof(query), "PRAGMA %s.table_info(%s);", schema, table);
+    sqlite3_stmt *stmt;
+    gboolean found = FALSE;
+    if (sqlite3_prepare_v2(db, query, -1, &stmt, NULL) == SQLITE_OK) {
+        while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *name = (const char *)sqlite3_column_text(stmt, 1);
+            found = name && strcmp(name, column) == 0;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// Completions keyed by 'YYYY-MM-DD' text are rebuilt once with day numbers.
+// all_completions is dropped first so the rename does not rewrite it.
+static gboolean migrate_completion_dates(sqlite3 *db, const char *schema) {
+    if (!table_has_column(db, schema, "habit_completions", "date")) return TRUE;
+
+    char migrate_sql[1024];
+    snprintf(migrate_sql, sizeof(migrate_sql),
+             "BEGIN;"
+             "DROP VIEW IF EXISTS temp.all_completions;"
+             "ALTER TABLE %s.habit_completions RENAME TO habit_completions_text;"
+             "CREATE TABLE %s.habit_completions (" COMPLETIONS_TABLE_COLUMNS ") WITHOUT ROWID;"
+             "INSERT OR REPLACE INTO %s.habit_completions (habit_id, day, completed) "
+             "SELECT habit_id, " DAY_NUMBER_SQL("date") ", completed FROM %s.habit_completions_text WHERE date <> '';"
+             "DROP TABLE %s.habit_completions_text;"
+             "COMMIT;",
+             schema, schema, schema, schema, schema);
+    if (sqlite3_exec(db, migrate_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to convert %s.habit_completions to day numbers: %s\n", schema, sqlite3_errmsg(db));
+        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+        return FALSE;
+    }
+    return completions_view_create(db);
+}
+
+// Databases from before habit ids kept each habit's definition as a
+// habit_tracking row with an empty date and keyed every completion by name.
+// They are converted once into habits + habit_completions; completions of
+// habits that no longer have a definition row (removed, or tombstoned and
+// waiting for the name-based purge) are dropped along the way.
+static gboolean migrate_habit_tracking(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    gboolean legacy = FALSE;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'habit_tracking';", -1, &stmt, NULL) == SQLITE_OK) {
+        legacy = sqlite3_step(stmt) == SQLITE_ROW;
+    }
+    sqlite3_finalize(stmt);
+    if (!legacy) return TRUE;
+
+    const char *migrate_sql =
+        "BEGIN;"
+        "INSERT OR IGNORE INTO habits (name, days, time_slot) "
+        "SELECT habit_name, COALESCE(days, ''), COALESCE(time_slot, '') FROM habit_tracking "
+        "WHERE (date = '' OR date IS NULL) AND habit_name IS NOT NULL;"
+        "INSERT OR REPLACE INTO habit_completions (habit_id, day, completed) "
+        "SELECT habits.id, " DAY_NUMBER_SQL("habit_tracking.date") ", habit_tracking.completed FROM habit_tracking "
+        "JOIN habits ON habits.name = habit_tracking.habit_name WHERE habit_tracking.date <> '';"
+        "DROP TABLE habit_tracking;"
+        "DROP TABLE IF EXISTS habit_tombstones;"
+        "COMMIT;";
+    if (sqlite3_exec(db, migrate_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to migrate habit_tracking: %s\n", sqlite3_errmsg(db));
+        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean open_database(AppData *app_data) {
+    if (sqlite3_open(HABIT_DB_PATH, &app_data->db) != SQLITE_OK) {
+        g_printerr("Cannot open database: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+
+    // auto_vacuum only takes effect on a database without tables, so files
+    // created before this stay in full mode and skip incremental_vacuum.
+    sqlite3_exec(app_data->db, "PRAGMA auto_vacuum = INCREMENTAL;", NULL, NULL, NULL);
+    sqlite3_exec(app_data->db, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL);
+
+
+    // AUTOINCREMENT keeps ids of removed habits from being reused while
+    // their completions are still waiting to be purged.
+    const char *create_habits_table_sql =
+        "CREATE TABLE IF NOT EXISTS habits ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT NOT NULL UNIQUE, "
+        "days TEXT NOT NULL DEFAULT '', time_slot TEXT NOT NULL DEFAULT '', "
+        "archived INTEGER NOT NULL DEFAULT 0, target REAL NOT NULL DEFAULT 0, unit TEXT NOT NULL DEFAULT '', "
+        "quota INTEGER NOT NULL DEFAULT 0, quota_rolling INTEGER NOT NULL DEFAULT 0);";
+    if (sqlite3_exec(app_data->db, create_habits_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create habits table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+    if (!table_has_column(app_data->db, "main", "habits", "archived") &&
+        sqlite3_exec(app_data->db, "ALTER TABLE habits ADD COLUMN archived INTEGER NOT NULL DEFAULT 0;", NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to add habits.archived: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+    if (!table_has_column(app_data->db, "main", "habits", "target") &&
+        sqlite3_exec(app_data->db, "ALTER TABLE habits ADD COLUMN target REAL NOT NULL DEFAULT 0;"
+                     "ALTER TABLE habits ADD COLUMN unit TEXT NOT NULL DEFAULT '';", NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to add habits.target: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+    if (!table_has_column(app_data->db, "main", "habits", "quota") &&
+        sqlite3_exec(app_data->db, "ALTER TABLE habits ADD COLUMN quota INTEGER NOT NULL DEFAULT 0;"
+                     "ALTER TABLE habits ADD COLUMN quota_rolling INTEGER NOT NULL DEFAULT 0;", NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to add habits.quota: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+
+    // Startup and the value loader only read active habits, the archive view
+    // only archived ones. Each gets a partial index holding just its rows, so
+    // abandoned habits are never scanned at startup.
+    const char *create_habit_indexes_sql =
+        "CREATE INDEX IF NOT EXISTS habits_active ON habits (id) WHERE archived = 0;"
+        "CREATE INDEX IF NOT EXISTS habits_archived ON habits (name) WHERE archived = 1;";
+    if (sqlite3_exec(app_data->db, create_habit_indexes_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create habit indexes: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
 
-            int day_idx_grid = 0, time_idx_grid = 0;
-             const char *days_grid_map[] = {"", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"}; // Grid is 1-indexed for days
-            for (int i = 1; i <= 7; i++) {
-                if (strcmp(days_grid_map[i], day_str_val) == 0) {
-                    day_idx_grid = i;
-                    break;
-                }
-            }
-            for (int i = 0; i < 12; i++) {
-                if (strcmp(time_slots_map[i], time_slot_str_val) == 0) {
-                    time_idx_grid = i + 1; // Grid is 1-indexed for time slots
-                    break;
-                }
-            }
+    const char *create_completions_table_sql =
+        "CREATE TABLE IF NOT EXISTS habit_completions (" COMPLETIONS_TABLE_COLUMNS ") WITHOUT ROWID;";
+    if (sqlite3_exec(app_data->db, create_completions_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create habit_completions table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
 
-            GtkWidget *task_label_timetable = NULL;
-            if (app_data->timetable_grid && day_idx_grid > 0 && time_idx_grid > 0) {
-                GtkWidget *task_box_cell = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_idx_grid, time_idx_grid);
-                if (task_box_cell) {
-                    task_label_timetable = gtk_label_new(task_text);
-                    gtk_widget_set_halign(task_label_timetable, GTK_ALIGN_START);
-                    gtk_box_append(GTK_BOX(task_box_cell), task_label_timetable);
-                }
-            }
+    // Amounts stay in the hot file: one row per logged day of a quantitative
+    // habit, clustered by habit and day so a range is one contiguous scan.
+    const char *create_values_table_sql =
+        "CREATE TABLE IF NOT EXISTS habit_values ("
+        "habit_id INTEGER NOT NULL, day INTEGER NOT NULL, value REAL NOT NULL, "
+        "PRIMARY KEY (habit_id, day)) WITHOUT ROWID;";
+    if (sqlite3_exec(app_data->db, create_values_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create habit_values table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
 
-            char task_display_pending[512];
-            snprintf(task_display_pending, sizeof(task_display_pending), "%s (%s, %s)", task_text, day_str_val, time_slot_str_val);
-            GtkWidget *task_row_box_pending = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-            GtkWidget *pending_task_label_ui = gtk_label_new(task_display_pending);
-            gtk_widget_set_halign(pending_task_label_ui, GTK_ALIGN_START);
-            gtk_box_append(GTK_BOX(task_row_box_pending), pending_task_label_ui);
+    const char *create_schedules_table_sql =
+        "CREATE TABLE IF NOT EXISTS habit_schedules ("
+        "habit_id INTEGER NOT NULL, from_day INTEGER NOT NULL, days_mask INTEGER NOT NULL, "
+        "PRIMARY KEY (habit_id, from_day)) WITHOUT ROWID;";
+    if (sqlite3_exec(app_data->db, create_schedules_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create habit_schedules table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
 
-            GtkWidget *done_button_pending = gtk_button_new_with_label("Mark as Done");
-            g_object_set_data(G_OBJECT(done_button_pending), "task", g_strdup(task_text));
-            g_object_set_data(G_OBJECT(done_button_pending), "day", g_strdup(day_str_val));
-            g_object_set_data(G_OBJECT(done_button_pending), "time_slot", g_strdup(time_slot_str_val));
-            g_object_set_data(G_OBJECT(done_button_pending), "task_row", task_row_box_pending);
-            if (task_label_timetable) {
-                g_object_set_data(G_OBJECT(done_button_pending), "task_label_timetable", task_label_timetable);
-            }
-            g_signal_connect(done_button_pending, "clicked", G_CALLBACK(on_mark_task_done), app_data);
-            gtk_box_append(GTK_BOX(task_row_box_pending), done_button_pending);
+    const char *create_session_log_sql =
+        "CREATE TABLE IF NOT EXISTS session_log (week INTEGER PRIMARY KEY, entries BLOB NOT NULL);";
+    if (sqlite3_exec(app_data->db, create_session_log_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create session_log table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
 
-            gtk_box_append(GTK_BOX(app_data->pending_tasks_box), task_row_box_pending);
+    if (!archive_attach(app_data->db)) {
+        g_printerr("Cannot attach archive database: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+    const char *create_archive_tables_sql =
+        "CREATE TABLE IF NOT EXISTS archive.habit_completions (" COMPLETIONS_TABLE_COLUMNS ") WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS archive.habit_totals (" ARCHIVE_TOTALS_TABLE_COLUMNS ");";
+    if (sqlite3_exec(app_data->db, create_archive_tables_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create archive tables: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
 
+    if (!migrate_completion_dates(app_data->db, "main") ||
+        !migrate_completion_dates(app_data->db, "archive") ||
+        !migrate_habit_tracking(app_data->db)) {
+        return FALSE;
+    }
+    if (table_has_column(app_data->db, "archive", "habit_totals", "first_date")) {
+        const char *rebuild_totals_sql =
+            "BEGIN;"
+            "DROP TABLE archive.habit_totals;"
+            "CREATE TABLE archive.habit_totals (" ARCHIVE_TOTALS_TABLE_COLUMNS ");"
+            "INSERT INTO archive.habit_totals (habit_id, completed_days, first_day, last_day) "
+            "SELECT habit_id, SUM(completed = 1), MIN(day), MAX(day) FROM archive.habit_completions GROUP BY habit_id;"
+            "COMMIT;";
+        if (sqlite3_exec(app_data->db, rebuild_totals_sql, NULL, NULL, NULL) != SQLITE_OK) {
+            g_printerr("Failed to rebuild archive totals: %s\n", sqlite3_errmsg(app_data->db));
+            sqlite3_exec(app_data->db, "ROLLBACK;", NULL, NULL, NULL);
+            return FALSE;
+        }
+    }
 
-            int next_row_edit_grid = 0;
-            GtkWidget *edit_grid_child = gtk_widget_get_first_child(tasks_grid_widget);
-            while(edit_grid_child){
-                next_row_edit_grid++;
-                edit_grid_child = gtk_widget_get_next_sibling(edit_grid_child);
+    const char *create_tasks_table_sql =
+        "CREATE TABLE IF NOT EXISTS timetable_tasks ("
+        "day TEXT, time_slot TEXT, task TEXT, "
+        "PRIMARY KEY (day, time_slot, task));";
+    if (sqlite3_exec(app_data->db, create_tasks_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create timetable_tasks table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+
+    const char *create_completed_tasks_table_sql =
+        "CREATE TABLE IF NOT EXISTS completed_tasks ("
+        "task TEXT, day TEXT, time_slot TEXT, "
+        "PRIMARY KEY (task, day, time_slot));";
+    if (sqlite3_exec(app_data->db, create_completed_tasks_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create completed_tasks table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+
+    const char *create_tombstones_table_sql =
+        "CREATE TABLE IF NOT EXISTS habit_tombstones ("
+        "habit_id INTEGER PRIMARY KEY, "
+        "deleted_at TEXT DEFAULT CURRENT_TIMESTAMP);";
+    if (sqlite3_exec(app_data->db, create_tombstones_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create habit_tombstones table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+
+    // data_version is bumped by triggers on every write to the tables the
+    // dashboard shows; the startup snapshot records it to detect staleness.
+    const char *create_meta_table_sql =
+        "CREATE TABLE IF NOT EXISTS app_meta (key TEXT PRIMARY KEY, value INTEGER);"
+        "INSERT OR IGNORE INTO app_meta (key, value) VALUES ('data_version', 1);";
+    if (sqlite3_exec(app_data->db, create_meta_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to create app_meta table: %s\n", sqlite3_errmsg(app_data->db));
+        return FALSE;
+    }
+
+    const char *versioned_tables[] = {"habits", "habit_completions", "timetable_tasks", "completed_tasks"};
+    const char *versioned_events[] = {"INSERT", "UPDATE", "DELETE"};
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 3; j++) {
+            char trigger_sql[256];
+            snprintf(trigger_sql, sizeof(trigger_sql),
+                     "CREATE TRIGGER IF NOT EXISTS %s_%s_version AFTER %s ON %s "
+                     "BEGIN UPDATE app_meta SET value = value + 1 WHERE key = 'data_version'; END;",
+                     versioned_tables[i], versioned_events[j], versioned_events[j], versioned_tables[i]);
+            if (sqlite3_exec(app_data->db, trigger_sql, NULL, NULL, NULL) != SQLITE_OK) {
+                g_printerr("Failed to create data_version trigger: %s\n", sqlite3_errmsg(app_data->db));
+                return FALSE;
             }
-             if(next_row_edit_grid == 0) next_row_edit_grid = 1;
+        }
+    }
 
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app_data->db, "PRAGMA auto_vacuum;", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            app_data->incremental_vacuum = sqlite3_column_int(stmt, 0) == 2;
+        }
+    }
+    sqlite3_finalize(stmt);
 
-            GtkWidget *row_box_edit_task = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-            char display_edit_task[512];
-            snprintf(display_edit_task, sizeof(display_edit_task), "%s (%s, %s)", task_text, day_str_val, time_slot_str_val);
-            GtkWidget *task_label_edit_ui = gtk_label_new(display_edit_task);
-             gtk_widget_set_hexpand(task_label_edit_ui, TRUE);
-            gtk_widget_set_halign(task_label_edit_ui, GTK_ALIGN_START);
-            gtk_box_append(GTK_BOX(row_box_edit_task), task_label_edit_ui);
+    sql_profile_setup(app_data);
+    sqlite3_busy_timeout(app_data->db, 1000);
+    return TRUE;
+}
 
-            GtkWidget *remove_button_edit_task = gtk_button_new_with_label("Remove");
-            g_object_set_data(G_OBJECT(remove_button_edit_task), "task", g_strdup(task_text));
-            g_object_set_data(G_OBJECT(remove_button_edit_task), "day", g_strdup(day_str_val));
-            g_object_set_data(G_OBJECT(remove_button_edit_task), "time_slot", g_strdup(time_slot_str_val));
-            g_object_set_data(G_OBJECT(remove_button_edit_task), "row", row_box_edit_task);
-            g_signal_connect(remove_button_edit_task, "clicked", G_CALLBACK(on_remove_task), app_data);
-            gtk_box_append(GTK_BOX(row_box_edit_task), remove_button_edit_task);
+static gint64 data_version_read(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    gint64 version = 0;
+    if (sqlite3_prepare_v2(db, "SELECT value FROM app_meta WHERE key = 'data_version';", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            version = sqlite3_column_int64(stmt, 0);
+        }
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
 
-            gtk_grid_attach(GTK_GRID(tasks_grid_widget), row_box_edit_task, 0, next_row_edit_grid, 2, 1);
-        } else {
-            g_printerr("Failed to add task to database: %s\n", sqlite3_errmsg(app_data->db));
+// Idle-time maintenance. Once the user has not touched the window for
+// MAINTENANCE_IDLE_DELAY_MS, and only if data_version moved since the last
+// pass, a low-priority idle source runs one short step per callback: a
+// passive WAL checkpoint, incremental_vacuum batches until the freelist is
+// empty, PRAGMA optimize with a bounded analysis_limit, then an
+// integrity_check of one table at a time. A progress handler aborts any
+// step that outlives its budget; an aborted step is retried with twice the
+// budget, up to MAINTENANCE_STEP_MAX_BUDGET_US, and only skipped for this
+// pass when even that is not enough. The next input event removes the idle
+// source so the pass resumes at the same step later.
+#define MAINTENANCE_IDLE_DELAY_MS 5000
+#define MAINTENANCE_STEP_BUDGET_US 4000
+#define MAINTENANCE_STEP_MAX_BUDGET_US 64000
+#define MAINTENANCE_VACUUM_PAGES 32
+
+typedef enum {
+    MAINTENANCE_CHECKPOINT,
+    MAINTENANCE_VACUUM,
+    MAINTENANCE_OPTIMIZE,
+    MAINTENANCE_INTEGRITY,
+    MAINTENANCE_DONE
+} MaintenanceStep;
+
+static const char *maintenance_tables[] = {
+    "main.habits", "main.habit_completions", "main.habit_values", "main.habit_schedules", "main.session_log",
+    "main.timetable_tasks", "main.completed_tasks", "main.habit_tombstones", "main.app_meta",
+    "archive.habit_completions", "archive.habit_totals"
+};
+
+static int on_maintenance_progress(void *data) {
+    return g_get_monotonic_time() > *(gint64 *)data;
+}
+
+static int maintenance_freelist_count(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    int pages = 0;
+    if (sqlite3_prepare_v2(db, "PRAGMA freelist_count;", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            pages = sqlite3_column_int(stmt, 0);
         }
+    }
+    sqlite3_finalize(stmt);
+    return pages;
+}
 
-        g_date_time_unref(due_date_time);
-        gtk_editable_set_text(GTK_EDITABLE(entry_widget), "");
-        gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_widget), 0);
-         gtk_calendar_select_day(GTK_CALENDAR(calendar_widget), g_date_time_new_now_local());
+// table is schema-qualified, "main.habits" or "archive.habit_totals".
+static int maintenance_integrity_check(sqlite3 *db, const char *table) {
+    const char *name = strchr(table, '.') + 1;
+    char query[128];
+    snprintf(query, sizeof(query), "PRAGMA %.*s.integrity_check(%s);", (int)(name - table - 1), table, name);
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, query, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) return rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *result = (const char *)sqlite3_column_text(stmt, 0);
+        if (result && strcmp(result, "ok") != 0) {
+            g_printerr("Integrity check of %s: %s\n", table, result);
+        }
+    }
+    // An interrupted check says nothing about the table; the caller
+    // retries it with a larger budget.
+    if (rc != SQLITE_DONE && rc != SQLITE_INTERRUPT) {
+        g_printerr("Integrity check of %s failed: %s\n", table, sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Returns whether the current step is finished. An interrupted step stays
+// where it is with a doubled budget until it reaches the cap.
+static gboolean maintenance_step_finished(AppData *app_data, int rc) {
+    if (rc == SQLITE_INTERRUPT && app_data->maintenance_budget_us < MAINTENANCE_STEP_MAX_BUDGET_US) {
+        app_data->maintenance_budget_us *= 2;
+        return FALSE;
+    }
+    app_data->maintenance_budget_us = MAINTENANCE_STEP_BUDGET_US;
+    return TRUE;
+}
+
+static gboolean on_maintenance_step(gpointer data) {
+    AppData *app_data = data;
+    if (app_data->maintenance_budget_us == 0) {
+        app_data->maintenance_budget_us = MAINTENANCE_STEP_BUDGET_US;
+    }
+    gint64 deadline_us = g_get_monotonic_time() + app_data->maintenance_budget_us;
+    sqlite3_progress_handler(app_data->db, 1000, on_maintenance_progress, &deadline_us);
+
+    switch (app_data->maintenance_step) {
+    case MAINTENANCE_CHECKPOINT:
+        sqlite3_wal_checkpoint_v2(app_data->db, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+        app_data->maintenance_step++;
+        break;
+    case MAINTENANCE_VACUUM: {
+        if (!app_data->incremental_vacuum || maintenance_freelist_count(app_data->db) == 0) {
+            app_data->maintenance_step++;
+            break;
+        }
+        char query[64];
+        snprintf(query, sizeof(query), "PRAGMA incremental_vacuum(%d);", MAINTENANCE_VACUUM_PAGES);
+        int rc = sqlite3_exec(app_data->db, query, NULL, NULL, NULL);
+        // A finished batch keeps the step for the next one; any failure
+        // other than running out of budget ends it.
+        if (maintenance_step_finished(app_data, rc) && rc != SQLITE_OK) {
+            app_data->maintenance_step++;
+        }
+        break;
+    }
+    case MAINTENANCE_OPTIMIZE:
+        if (maintenance_step_finished(app_data, sqlite3_exec(app_data->db, "PRAGMA analysis_limit = 400; PRAGMA optimize;", NULL, NULL, NULL))) {
+            app_data->maintenance_step++;
+        }
+        break;
+    case MAINTENANCE_INTEGRITY:
+        if (!maintenance_step_finished(app_data, maintenance_integrity_check(app_data->db, maintenance_tables[app_data->maintenance_table]))) {
+            break;
+        }
+        if (++app_data->maintenance_table == G_N_ELEMENTS(maintenance_tables)) {
+            app_data->maintenance_table = 0;
+            app_data->maintenance_step++;
+        }
+        break;
+    }
+    sqlite3_progress_handler(app_data->db, 0, NULL, NULL);
 
+    if (app_data->maintenance_step == MAINTENANCE_DONE) {
+        app_data->maintenance_step = MAINTENANCE_CHECKPOINT;
+        app_data->maintained_version = data_version_read(app_data->db);
+        app_data->maintenance_source = 0;
+        return G_SOURCE_REMOVE;
     }
+    return G_SOURCE_CONTINUE;
 }
 
+static gboolean on_maintenance_idle_timeout(gpointer data) {
+    AppData *app_data = data;
+    gint64 idle_ms = (g_get_monotonic_time() - app_data->last_input_us) / 1000;
+    if (idle_ms < MAINTENANCE_IDLE_DELAY_MS) {
+        app_data->maintenance_timer = g_timeout_add(MAINTENANCE_IDLE_DELAY_MS - idle_ms, on_maintenance_idle_timeout, app_data);
+        return G_SOURCE_REMOVE;
+    }
 
-static void on_edit_tasks(GtkButton *button, AppData *app_data) {
-    GtkWidget *edit_window = gtk_window_new();
-    gtk_window_set_title(GTK_WINDOW(edit_window), "Edit Tasks");
-    gtk_window_set_transient_for(GTK_WINDOW(edit_window), GTK_WINDOW(app_data->main_window));
-    gtk_window_set_modal(GTK_WINDOW(edit_window), TRUE);
-    gtk_window_set_default_size(GTK_WINDOW(edit_window), 700, 700);
+    app_data->maintenance_timer = 0;
+    gboolean pass_in_progress = app_data->maintenance_step != MAINTENANCE_CHECKPOINT || app_data->maintenance_table != 0;
+    if (app_data->db && !app_data->maintenance_source &&
+        (pass_in_progress || data_version_read(app_data->db) != app_data->maintained_version)) {
+        app_data->maintenance_source = g_idle_add_full(G_PRIORITY_LOW, on_maintenance_step, app_data, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
 
+static void maintenance_schedule(AppData *app_data) {
+    if (!app_data->maintenance_timer) {
+        app_data->maintenance_timer = g_timeout_add(MAINTENANCE_IDLE_DELAY_MS, on_maintenance_idle_timeout, app_data);
+    }
+}
 
-    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_widget_set_margin_start(vbox, 15);
-    gtk_widget_set_margin_end(vbox, 15);
-    gtk_widget_set_margin_top(vbox, 15);
-    gtk_widget_set_margin_bottom(vbox, 15);
-    gtk_window_set_child(GTK_WINDOW(edit_window), vbox);
+static gboolean on_window_input(GtkEventControllerLegacy *controller, GdkEvent *event, AppData *app_data) {
+    app_data->last_input_us = g_get_monotonic_time();
+    if (app_data->maintenance_source) {
+        g_source_remove(app_data->maintenance_source);
+        app_data->maintenance_source = 0;
+    }
+    if (app_data->loaded_us) maintenance_schedule(app_data);
+    return FALSE;
+}
 
-    GtkWidget *tasks_grid = gtk_grid_new();
-    gtk_grid_set_row_spacing(GTK_GRID(tasks_grid), 5);
-    gtk_grid_set_column_spacing(GTK_GRID(tasks_grid), 10);
-    gtk_grid_set_column_homogeneous(GTK_GRID(tasks_grid), TRUE);
+static void maintenance_stop(AppData *app_data) {
+    if (app_data->maintenance_timer) {
+        g_source_remove(app_data->maintenance_timer);
+        app_data->maintenance_timer = 0;
+    }
+    if (app_data->maintenance_source) {
+        g_source_remove(app_data->maintenance_source);
+        app_data->maintenance_source = 0;
+    }
+}
 
+// Asynchronous startup. on_activate presents the window with empty
+// containers (or the snapshot contents, see below); once the first frame is
+// painted the database is opened and a worker thread reads the rows the
+// dashboard and timetable need on its own read-only connection. The main
+// thread turns them into widgets from an idle callback that yields once
+// STARTUP_SLICE_BUDGET_US has been spent, so frames keep being painted while
+// a large database loads.
+#define STARTUP_SLICE_BUDGET_US 8000
+
+static void startup_data_free(gpointer data) {
+    StartupData *startup = data;
+    g_ptr_array_unref(startup->habits);
+    g_ptr_array_unref(startup->tasks);
+    g_ptr_array_unref(startup->completed_tasks);
+    g_free(startup);
+}
 
-    const char *labels[] = {"Task (Day, Time Slot)", "Action"};
-    GtkWidget* header_label1 = gtk_label_new(labels[0]);
-    gtk_widget_set_halign(header_label1, GTK_ALIGN_START);
-    gtk_grid_attach(GTK_GRID(tasks_grid), header_label1, 0, 0, 1, 1);
-    GtkWidget* header_label2 = gtk_label_new(labels[1]);
-    gtk_widget_set_halign(header_label2, GTK_ALIGN_CENTER);
-    gtk_grid_attach(GTK_GRID(tasks_grid), header_label2, 1, 0, 1, 1);
+static gint compare_tasks_by_slot(gconstpointer a, gconstpointer b) {
+    const TaskEntry *task_a = *(TaskEntry *const *)a;
+    const TaskEntry *task_b = *(TaskEntry *const *)b;
+    int order = weekday_index(task_a->day) - weekday_index(task_b->day);
+    if (order == 0) order = time_slot_index(task_a->time_slot) - time_slot_index(task_b->time_slot);
+    return order;
+}
 
+static void startup_load_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    gint64 shown_version = *(gint64 *)task_data;
+    StartupData *startup = g_new0(StartupData, 1);
+    startup->habits = g_ptr_array_new_with_free_func(habit_free);
+    startup->tasks = g_ptr_array_new_with_free_func(task_entry_free);
+    startup->completed_tasks = g_ptr_array_new_with_free_func(task_entry_free);
+
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(HABIT_DB_PATH, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        g_printerr("Startup loader cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_task_return_pointer(task, startup, startup_data_free);
+        return;
+    }
 
-    char query_select[256];
-    snprintf(query_select, sizeof(query_select), "SELECT task, day, time_slot FROM timetable_tasks;");
-    sqlite3_stmt *stmt_select;
-    int row_idx = 1;
-    if (sqlite3_prepare_v2(app_data->db, query_select, -1, &stmt_select, NULL) == SQLITE_OK) {
-        while (sqlite3_step(stmt_select) == SQLITE_ROW) {
-            const char *task_text = (const char *)sqlite3_column_text(stmt_select, 0);
-            const char *day_text = (const char *)sqlite3_column_text(stmt_select, 1);
-            const char *time_slot_text = (const char *)sqlite3_column_text(stmt_select, 2);
+    // ATTACH is not allowed inside a transaction.
+    gboolean archive_attached = archive_attach(db);
+
+    // One read transaction so the rows match the data_version read first.
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    startup->data_version = data_version_read(db);
+    if (shown_version && startup->data_version == shown_version) {
+        startup->unchanged = TRUE;
+        sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+        sqlite3_close(db);
+        g_task_return_pointer(task, startup, startup_data_free);
+        return;
+    }
 
-            GtkWidget *row_box_display = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-            char display_text[512];
-            snprintf(display_text, sizeof(display_text), "%s (%s, %s)", task_text, day_text, time_slot_text);
-            GtkWidget *task_label_display = gtk_label_new(display_text);
-            gtk_widget_set_hexpand(task_label_display, TRUE);
-            gtk_widget_set_halign(task_label_display, GTK_ALIGN_START);
-            gtk_box_append(GTK_BOX(row_box_display), task_label_display);
+    sqlite3_stmt *stmt;
+    GHashTable *habits_by_id = g_hash_table_new(g_int64_hash, g_int64_equal);
+    if (sqlite3_prepare_v2(db, "SELECT id, name, days, time_slot, target, unit, quota, quota_rolling FROM habits WHERE archived = 0 ORDER BY id;", -1, &stmt, NULL) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+            Habit *habit = habit_new(sqlite3_column_int64(stmt, 0),
+                                     (const char *)sqlite3_column_text(stmt, 1),
+                                     (const char *)sqlite3_column_text(stmt, 2),
+                                     (const char *)sqlite3_column_text(stmt, 3));
+            habit_set_target(habit, sqlite3_column_double(stmt, 4), (const char *)sqlite3_column_text(stmt, 5));
+            habit->quota = sqlite3_column_int(stmt, 6);
+            habit->quota_rolling = sqlite3_column_int(stmt, 7);
+            g_ptr_array_add(startup->habits, habit);
+            g_hash_table_insert(habits_by_id, &habit->id, habit);
+        }
+    }
+    sqlite3_finalize(stmt);
 
-            GtkWidget *remove_button_display = gtk_button_new_with_label("Remove");
-            g_object_set_data(G_OBJECT(remove_button_display), "task", g_strdup(task_text));
-            g_object_set_data(G_OBJECT(remove_button_display), "day", g_strdup(day_text));
-            g_object_set_data(G_OBJECT(remove_button_display), "time_slot", g_strdup(time_slot_text));
-            g_object_set_data(G_OBJECT(remove_button_display), "row", row_box_display);
-            g_signal_connect(remove_button_display, "clicked", G_CALLBACK(on_remove_task), app_data);
-            gtk_box_append(GTK_BOX(row_box_display), remove_button_display);
+    // Lifetime counts: hot rows are counted, archived ones come from their
+    // precomputed totals. Both lists are added up per habit.
+    const char *count_sql[] = {
+        "SELECT habit_id, COUNT(*) FROM main.habit_completions "
+        "WHERE completed = 1 AND habit_id IN (SELECT id FROM habits WHERE archived = 0) GROUP BY habit_id;",
+        "SELECT habit_id, completed_days FROM archive.habit_totals;"
+    };
+    for (int i = 0; i < (archive_attached ? 2 : 1); i++) {
+        if (sqlite3_prepare_v2(db, count_sql[i], -1, &stmt, NULL) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+                gint64 habit_id = sqlite3_column_int64(stmt, 0);
+                Habit *habit = g_hash_table_lookup(habits_by_id, &habit_id);
+                if (habit) habit->days_completed += sqlite3_column_int(stmt, 1);
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    habit_counters_load(db, archive_attached ? "all_completions" : "main.habit_completions", habits_by_id, 0);
+    habit_schedules_load(db, habits_by_id, 0);
+    g_hash_table_destroy(habits_by_id);
+
+    if (sqlite3_prepare_v2(db, "SELECT task, day, time_slot FROM timetable_tasks;", -1, &stmt, NULL) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+            g_ptr_array_add(startup->tasks, task_entry_new((const char *)sqlite3_column_text(stmt, 0),
+                                                           (const char *)sqlite3_column_text(stmt, 1),
+                                                           (const char *)sqlite3_column_text(stmt, 2)));
+        }
+    }
+    sqlite3_finalize(stmt);
+    g_ptr_array_sort(startup->tasks, compare_tasks_by_slot);
 
-            gtk_grid_attach(GTK_GRID(tasks_grid), row_box_display, 0, row_idx++, 2, 1);
+    if (sqlite3_prepare_v2(db, "SELECT task, day, time_slot FROM completed_tasks;", -1, &stmt, NULL) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+            g_ptr_array_add(startup->completed_tasks, task_entry_new((const char *)sqlite3_column_text(stmt, 0),
+                                                                     (const char *)sqlite3_column_text(stmt, 1),
+                                                                     (const char *)sqlite3_column_text(stmt, 2)));
         }
     }
-    sqlite3_finalize(stmt_select);
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    sqlite3_close(db);
 
-    GtkWidget *scrolled_window_tasks = gtk_scrolled_window_new();
-    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scrolled_window_tasks), tasks_grid);
-    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window_tasks),
-                                   GTK_POLICY_AUTOMATIC,
-                                   GTK_POLICY_AUTOMATIC);
-    gtk_widget_set_vexpand(scrolled_window_tasks, TRUE);
-    gtk_box_append(GTK_BOX(vbox), scrolled_window_tasks);
+    g_task_return_pointer(task, startup, startup_data_free);
+}
 
-    GtkWidget *separator_edit_task = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
-    gtk_box_append(GTK_BOX(vbox), separator_edit_task);
+static void add_habit_widget(AppData *app_data, const Habit *habit, const char *current_day_name) {
+    GtkWidget *habit_box_ui = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
+    gtk_widget_set_valign(habit_box_ui, GTK_ALIGN_START);
+    GtkWidget *drawing_area_ui = gtk_drawing_area_new();
+    gtk_widget_set_size_request(drawing_area_ui, 70, 70);
+    gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(drawing_area_ui), draw_habit_logo, HABIT_ID_TO_POINTER(habit->id), NULL);
+    g_object_set_data(G_OBJECT(drawing_area_ui), "app_data", app_data);
+    gtk_box_append(GTK_BOX(habit_box_ui), drawing_area_ui);
+
+    g_object_set_data(G_OBJECT(habit_box_ui), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+
+    GtkWidget *label_ui = gtk_label_new(habit->name);
+    g_object_set_data(G_OBJECT(label_ui), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+    gtk_widget_set_halign(label_ui, GTK_ALIGN_CENTER);
+    gtk_box_append(GTK_BOX(habit_box_ui), label_ui);
+    g_object_set_data(G_OBJECT(habit_box_ui), "name_label", label_ui);
+
+    GtkWidget *forecast_label_ui = gtk_label_new("");
+    gtk_widget_add_css_class(forecast_label_ui, "forecast-risk");
+    gtk_widget_set_visible(forecast_label_ui, FALSE);
+    gtk_box_append(GTK_BOX(habit_box_ui), forecast_label_ui);
+    g_object_set_data(G_OBJECT(habit_box_ui), "forecast_label", forecast_label_ui);
+
+    gboolean due_today = habit_due_today(habit, day_number_today(), current_day_name);
+    if (habit->quota > 0) {
+        GtkWidget *quota_label_ui = gtk_label_new("");
+        gtk_box_append(GTK_BOX(habit_box_ui), quota_label_ui);
+        g_object_set_data(G_OBJECT(habit_box_ui), "quota_label", quota_label_ui);
+    }
 
-    GtkWidget *add_task_section_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_box_append(GTK_BOX(vbox), add_task_section_box);
+    if (habit->target > 0 && (due_today || habit->quota > 0)) {
+        // Quota habits keep the spin and hide it once the week's quota is met.
+        GtkWidget *amount_box_ui = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+        GtkWidget *amount_spin_ui = gtk_spin_button_new_with_range(0, 100000, 1);
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(amount_spin_ui),
+                                  habit->values ? habit_values_get(habit->values, day_number_today()) : 0);
+        g_object_set_data(G_OBJECT(amount_spin_ui), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+        g_signal_connect(amount_spin_ui, "value-changed", G_CALLBACK(on_habit_amount_changed), app_data);
+        gtk_box_append(GTK_BOX(amount_box_ui), amount_spin_ui);
+        gtk_box_append(GTK_BOX(amount_box_ui), gtk_label_new(habit->unit));
+        gtk_box_append(GTK_BOX(habit_box_ui), amount_box_ui);
+        g_object_set_data(G_OBJECT(habit_box_ui), "amount_spin", amount_spin_ui);
+        g_object_set_data(G_OBJECT(habit_box_ui), "amount_box", amount_box_ui);
+    } else if (habit->target <= 0 && (due_today || habit->quota > 0)) {
+        // Quota habits keep the button and hide it once the week's quota is met.
+        GtkWidget *done_button_ui = gtk_button_new_with_label("Done Today");
+        g_object_set_data(G_OBJECT(done_button_ui), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+        g_object_set_data(G_OBJECT(done_button_ui), "drawing_area", drawing_area_ui);
+        g_signal_connect(done_button_ui, "clicked", G_CALLBACK(on_done_today_clicked), app_data);
+        gtk_box_append(GTK_BOX(habit_box_ui), done_button_ui);
+        g_object_set_data(G_OBJECT(habit_box_ui), "done_button", done_button_ui);
+    }
+    gtk_box_append(GTK_BOX(habit_box_ui), session_button_new(app_data, habit->id, NULL, drawing_area_ui));
+
+    gtk_box_append(GTK_BOX(app_data->habits_box), habit_box_ui);
+    app_data->habit_widgets = g_list_prepend(app_data->habit_widgets, habit_box_ui);
+    gint64 *box_key = g_new(gint64, 1);
+    *box_key = habit->id;
+    g_hash_table_insert(app_data->habit_boxes, box_key, habit_box_ui);
+    if (habit->quota > 0) habit_quota_widgets_refresh(app_data, habit);
+}
 
-    GtkWidget *add_task_heading = gtk_label_new("Add New Task");
-    gtk_widget_add_css_class(add_task_heading, "heading");
-    gtk_widget_set_halign(add_task_heading, GTK_ALIGN_CENTER);
-    gtk_box_append(GTK_BOX(add_task_section_box), add_task_heading);
+static void add_habit_to_timetable(AppData *app_data, const Habit *habit) {
+    int time_row = time_slot_index(habit->time_slot);
+    if (!app_data->timetable_grid || time_row == 0) return;
 
+    for (int day_col = 1; day_col <= 7; day_col++) {
+        if (!strstr(habit->days, weekday_names[day_col - 1])) continue;
+        GtkWidget *task_box_cell = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_col, time_row);
+        if (!task_box_cell) continue;
+
+        GtkWidget *habit_label_ui = gtk_label_new(habit->name);
+        g_object_set_data(G_OBJECT(habit_label_ui), "habit_id", HABIT_ID_TO_POINTER(habit->id));
+        gtk_widget_set_halign(habit_label_ui, GTK_ALIGN_START);
+        gtk_widget_add_css_class(habit_label_ui, "habit-label");
+        gtk_widget_set_margin_start(habit_label_ui, 5);
+        gtk_box_append(GTK_BOX(task_box_cell), habit_label_ui);
+    }
+}
 
-    GtkWidget *task_entry_new = gtk_entry_new();
-    gtk_entry_set_placeholder_text(GTK_ENTRY(task_entry_new), "Enter new task description...");
-    gtk_box_append(GTK_BOX(add_task_section_box), task_entry_new);
+static GtkWidget *add_task_to_timetable(AppData *app_data, const TaskEntry *entry) {
+    int day_col = weekday_index(entry->day);
+    int time_row = time_slot_index(entry->time_slot);
+    if (!app_data->timetable_grid || day_col == 0 || time_row == 0) return NULL;
 
-    GtkWidget *date_time_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-    gtk_widget_set_halign(date_time_box, GTK_ALIGN_CENTER);
-    gtk_box_append(GTK_BOX(add_task_section_box), date_time_box);
+    GtkWidget *task_box_cell = gtk_grid_get_child_at(GTK_GRID(app_data->timetable_grid), day_col, time_row);
+    if (!task_box_cell) return NULL;
+
+    GtkWidget *task_label_ui = gtk_label_new(entry->task);
+    gtk_widget_set_halign(task_label_ui, GTK_ALIGN_START);
+    gtk_widget_set_margin_start(task_label_ui, 5);
+    gtk_box_append(GTK_BOX(task_box_cell), task_label_ui);
+    return task_label_ui;
+}
+
+static void add_pending_task(AppData *app_data, const TaskEntry *entry) {
+    GtkWidget *task_label_ui = add_task_to_timetable(app_data, entry);
+
+    char task_display_pending[512];
+    snprintf(task_display_pending, sizeof(task_display_pending), "%s (%s, %s)", entry->task, entry->day, entry->time_slot);
+    GtkWidget *task_row_pending_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    GtkWidget *pending_task_label_widget = gtk_label_new(task_display_pending);
+    gtk_widget_set_halign(pending_task_label_widget, GTK_ALIGN_START);
+    gtk_widget_set_hexpand(pending_task_label_widget, TRUE);
+    gtk_box_append(GTK_BOX(task_row_pending_box), pending_task_label_widget);
+
+    GtkWidget *done_button_pending = gtk_button_new_with_label("Mark as Done");
+    g_object_set_data_full(G_OBJECT(done_button_pending), "task", mem_strdup(MEM_DASHBOARD_UI, entry->task), mem_free);
+    g_object_set_data_full(G_OBJECT(done_button_pending), "day", mem_strdup(MEM_DASHBOARD_UI, entry->day), mem_free);
+    g_object_set_data_full(G_OBJECT(done_button_pending), "time_slot", mem_strdup(MEM_DASHBOARD_UI, entry->time_slot), mem_free);
+    g_object_set_data(G_OBJECT(done_button_pending), "task_row", task_row_pending_box);
+    g_object_set_data(G_OBJECT(done_button_pending), "task_label_timetable", task_label_ui);
+    g_signal_connect(done_button_pending, "clicked", G_CALLBACK(on_mark_task_done), app_data);
+    gtk_box_append(GTK_BOX(task_row_pending_box), session_button_new(app_data, 0, entry->task, NULL));
+    gtk_box_append(GTK_BOX(task_row_pending_box), done_button_pending);
+
+    gtk_box_append(GTK_BOX(app_data->pending_tasks_box), task_row_pending_box);
+}
+
+static void add_completed_task(AppData *app_data, const TaskEntry *entry) {
+    char task_display_completed[512];
+    snprintf(task_display_completed, sizeof(task_display_completed), "%s (%s, %s)", entry->task, entry->day, entry->time_slot);
+    GtkWidget *completed_task_label_ui = gtk_label_new(task_display_completed);
+    gtk_widget_set_halign(completed_task_label_ui, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(app_data->completed_tasks_box), completed_task_label_ui);
+}
+
+static void startup_load_async(AppData *app_data);
+static void timetable_page_build(AppData *app_data);
+
+static void box_remove_all(GtkWidget *box) {
+    GtkWidget *child;
+    while ((child = gtk_widget_get_first_child(box))) {
+        gtk_box_remove(GTK_BOX(box), child);
+    }
+}
+
+// Drops everything the dashboard shows so it can be rebuilt from fresher
+// rows. The timetable grid is rebuilt on demand from the new model.
+static void dashboard_clear(AppData *app_data) {
+    box_remove_all(app_data->pending_tasks_box);
+    box_remove_all(app_data->completed_tasks_box);
+    box_remove_all(app_data->habits_box);
+    app_data->loading_label = NULL;
+    g_list_free(app_data->habit_widgets);
+    app_data->habit_widgets = NULL;
+    g_hash_table_remove_all(app_data->habit_boxes);
+    g_hash_table_remove_all(app_data->habits_by_id);
+    g_list_free_full(app_data->habits, habit_free);
+    app_data->habits = NULL;
+    g_list_free_full(app_data->tasks, task_entry_free);
+    app_data->tasks = NULL;
+    g_list_free_full(app_data->completed_tasks, task_entry_free);
+    app_data->completed_tasks = NULL;
+    if (app_data->timetable_grid) {
+        gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->timetable_page), NULL);
+        app_data->timetable_grid = NULL;
+        app_data->session_week_label = NULL;
+    }
+}
+
+// Moves the next startup row into the model and builds its widgets.
+// Returns FALSE once every row has been materialized.
+static gboolean startup_materialize_next(AppData *app_data, const char *current_day_name) {
+    StartupData *startup = app_data->startup_data;
+    // Ownership of each entry moves to the AppData lists; the slot is
+    // cleared so startup_data_free does not free it again.
+    if (app_data->startup_task_pos < startup->tasks->len) {
+        TaskEntry *entry = g_ptr_array_index(startup->tasks, app_data->startup_task_pos);
+        startup->tasks->pdata[app_data->startup_task_pos++] = NULL;
+        app_data->tasks = g_list_prepend(app_data->tasks, entry);
+        add_pending_task(app_data, entry);
+    } else if (app_data->startup_completed_pos < startup->completed_tasks->len) {
+        TaskEntry *entry = g_ptr_array_index(startup->completed_tasks, app_data->startup_completed_pos);
+        startup->completed_tasks->pdata[app_data->startup_completed_pos++] = NULL;
+        app_data->completed_tasks = g_list_prepend(app_data->completed_tasks, entry);
+        add_completed_task(app_data, entry);
+    } else if (app_data->startup_habit_pos < startup->habits->len) {
+        Habit *habit = g_ptr_array_index(startup->habits, app_data->startup_habit_pos);
+        startup->habits->pdata[app_data->startup_habit_pos++] = NULL;
+        app_data->habits = g_list_prepend(app_data->habits, habit);
+        g_hash_table_insert(app_data->habits_by_id, &habit->id, habit);
+        add_habit_widget(app_data, habit, current_day_name);
+        add_habit_to_timetable(app_data, habit);
+    } else {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void startup_model_done(AppData *app_data) {
+    app_data->data_version = app_data->startup_data->data_version;
+    g_clear_pointer(&app_data->startup_data, startup_data_free);
+    app_data->startup_task_pos = 0;
+    app_data->startup_completed_pos = 0;
+    app_data->startup_habit_pos = 0;
+    app_data->habits = g_list_reverse(app_data->habits);
+    app_data->tasks = g_list_reverse(app_data->tasks);
+    app_data->completed_tasks = g_list_reverse(app_data->completed_tasks);
+    app_data->habit_widgets = g_list_reverse(app_data->habit_widgets);
+
+    if (app_data->loading_label) {
+        gtk_box_remove(GTK_BOX(app_data->habits_box), app_data->loading_label);
+        app_data->loading_label = NULL;
+    }
+}
+
+static void startup_finish(AppData *app_data, gboolean from_snapshot) {
+    app_data->loaded_us = g_get_monotonic_time();
+    g_debug("Startup: fully loaded after %.1f ms (%u habits, %u tasks, %u completed tasks%s)",
+            (app_data->loaded_us - app_data->startup_us) / 1000.0,
+            g_list_length(app_data->habits), g_list_length(app_data->tasks),
+            g_list_length(app_data->completed_tasks), from_snapshot ? ", snapshot up to date" : "");
+
+    if (!app_data->timetable_grid &&
+        gtk_notebook_get_current_page(GTK_NOTEBOOK(app_data->notebook)) ==
+        gtk_notebook_page_num(GTK_NOTEBOOK(app_data->notebook), app_data->timetable_page)) {
+        timetable_page_build(app_data);
+    }
+    gtk_widget_set_sensitive(app_data->management_buttons_box, TRUE);
+    maintenance_schedule(app_data);
+    purge_start(app_data);
+    archive_start(app_data);
+    forecast_start(app_data);
+    values_load_start(app_data);
+    day_rollover_schedule(app_data);
+    analytics_invalidate(app_data);
+    heatmap_page_invalidate(app_data);
+    month_overview_reset(app_data);
+}
+
+static const char *current_weekday_name(void) {
+    GDateTime *today = g_date_time_new_now_local();
+    const char *day_name = weekday_names[g_date_time_get_day_of_week(today) - 1];
+    g_date_time_unref(today);
+    return day_name;
+}
+
+static gboolean startup_materialize_slice(gpointer data) {
+    AppData *app_data = data;
+    gint64 deadline_us = g_get_monotonic_time() + STARTUP_SLICE_BUDGET_US;
+    const char *current_day_name = current_weekday_name();
+
+    while (g_get_monotonic_time() < deadline_us) {
+        if (!startup_materialize_next(app_data, current_day_name)) {
+            app_data->startup_source = 0;
+            startup_model_done(app_data);
+            startup_finish(app_data, FALSE);
+            return G_SOURCE_REMOVE;
+        }
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_startup_loaded(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    StartupData *startup = g_task_propagate_pointer(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        // The window is gone and data points at freed AppData.
+        if (startup) startup_data_free(startup);
+        return;
+    }
 
-    GtkWidget *calendar_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
-    gtk_box_append(GTK_BOX(date_time_box), calendar_box);
-    GtkWidget *calendar_label_new = gtk_label_new("Due Date:");
-    gtk_widget_set_halign(calendar_label_new, GTK_ALIGN_START);
-    gtk_box_append(GTK_BOX(calendar_box), calendar_label_new);
-    GtkWidget *calendar_new = gtk_calendar_new();
-    gtk_box_append(GTK_BOX(calendar_box), calendar_new);
+    AppData *app_data = data;
+    g_clear_object(&app_data->startup_cancellable);
+    if (startup->unchanged) {
+        startup_data_free(startup);
+        startup_finish(app_data, TRUE);
+        return;
+    }
+    if (data_version_read(app_data->db) != startup->data_version) {
+        // Something was written through the snapshot-built dashboard while
+        // the worker was reading; its rows are already stale.
+        startup_data_free(startup);
+        startup_load_async(app_data);
+        return;
+    }
 
+    if (app_data->data_version) {
+        g_debug("Startup: snapshot is stale (data version %" G_GINT64_FORMAT ", database %" G_GINT64_FORMAT "), reloading",
+                app_data->data_version, startup->data_version);
+        dashboard_clear(app_data);
+    }
+    app_data->startup_data = startup;
+    app_data->startup_source = g_idle_add(startup_materialize_slice, app_data);
+}
 
-    GtkWidget *time_select_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
-    gtk_widget_set_valign(time_select_box, GTK_ALIGN_START);
-    gtk_box_append(GTK_BOX(date_time_box), time_select_box);
-    GtkWidget *time_label_new = gtk_label_new("Due Time (Hour):");
-    gtk_widget_set_halign(time_label_new, GTK_ALIGN_START);
-    gtk_box_append(GTK_BOX(time_select_box), time_label_new);
+static void startup_load_async(AppData *app_data) {
+    gint64 *shown_version = g_new(gint64, 1);
+    *shown_version = app_data->data_version;
 
-    GtkStringList *hours_list_new = gtk_string_list_new(NULL);
-    for (int i = 0; i < 24; i++) {
-        char hour_str[3];
-        snprintf(hour_str, sizeof(hour_str), "%02d", i);
-        gtk_string_list_append(hours_list_new, hour_str);
+    app_data->startup_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->startup_cancellable, on_startup_loaded, app_data);
+    g_task_set_task_data(task, shown_version, g_free);
+    g_task_run_in_thread(task, startup_load_thread);
+    g_object_unref(task);
+}
+
+// The snapshot dashboard is drawn before the database is open, so the
+// widgets that write check-ins stay insensitive until this point.
+static void startup_connect(AppData *app_data) {
+    if (!open_database(app_data)) {
+        gtk_window_destroy(GTK_WINDOW(app_data->main_window));
+        return;
     }
-    GtkWidget *hour_dropdown_new_task = gtk_drop_down_new(G_LIST_MODEL(hours_list_new), NULL);
-    gtk_drop_down_set_selected(GTK_DROP_DOWN(hour_dropdown_new_task), 0);
-    gtk_box_append(GTK_BOX(time_select_box), hour_dropdown_new_task);
-    g_object_unref(hours_list_new);
+    gtk_widget_set_sensitive(app_data->pending_tasks_box, TRUE);
+    gtk_widget_set_sensitive(app_data->habits_box, TRUE);
+    gtk_widget_set_sensitive(app_data->timetable_page, TRUE);
+    gtk_widget_set_sensitive(app_data->heatmap_page, TRUE);
+    startup_load_async(app_data);
+}
 
+static void on_first_frame_painted(GdkFrameClock *frame_clock, AppData *app_data) {
+    app_data->first_frame_us = g_get_monotonic_time();
+    g_debug("Startup: first frame after %.1f ms", (app_data->first_frame_us - app_data->startup_us) / 1000.0);
+    g_signal_handler_disconnect(app_data->first_frame_clock, app_data->first_frame_handler);
+    g_clear_object(&app_data->first_frame_clock);
+    startup_connect(app_data);
+}
 
-    GtkWidget *add_button_new_task = gtk_button_new_with_label("Add Task");
-    gtk_widget_set_halign(add_button_new_task, GTK_ALIGN_CENTER);
-    g_object_set_data(G_OBJECT(add_button_new_task), "app_data", app_data);
-    g_object_set_data(G_OBJECT(add_button_new_task), "entry", task_entry_new);
-    g_object_set_data(G_OBJECT(add_button_new_task), "calendar", calendar_new);
-    g_object_set_data(G_OBJECT(add_button_new_task), "hour_dropdown", hour_dropdown_new_task);
-    g_object_set_data(G_OBJECT(add_button_new_task), "tasks_grid", tasks_grid);
-    g_signal_connect(add_button_new_task, "clicked", G_CALLBACK(on_add_task_in_edit), app_data);
-    gtk_box_append(GTK_BOX(add_task_section_box), add_button_new_task);
+// Startup snapshot. On shutdown the dashboard model (habits with their
+// completed-day counts, pending and completed tasks) is written to
+// HABIT_SNAPSHOT_PATH together with the data_version it was read at. The
+// next launch maps the file and builds the dashboard from it before the
+// database is opened; the startup worker then only compares data_version
+// and reloads from SQLite if the snapshot turned out to be stale. Fields
+// are in host byte order: the file is a local cache, and a magic number
+// from another machine simply fails validation.
+#define SNAPSHOT_MAGIC 0x48545331u
+#define SNAPSHOT_FORMAT_VERSION 6
 
-    GtkWidget *separator_edit_task2 = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
-    gtk_box_append(GTK_BOX(vbox), separator_edit_task2);
+typedef struct {
+    guint32 magic;
+    guint32 format_version;
+    gint64 data_version;
+    guint32 habit_count;
+    guint32 task_count;
+    guint32 completed_count;
+    guint32 reserved;
+} SnapshotHeader;
 
-    GtkWidget *save_button_edit_task = gtk_button_new_with_label("Close");
-    gtk_widget_set_halign(save_button_edit_task, GTK_ALIGN_END);
-    g_signal_connect_swapped(save_button_edit_task, "clicked", G_CALLBACK(gtk_window_destroy), edit_window);
-    gtk_box_append(GTK_BOX(vbox), save_button_edit_task);
+typedef struct {
+    const char *pos;
+    const char *end;
+} SnapshotReader;
 
-    gtk_window_present(GTK_WINDOW(edit_window));
+static void snapshot_append_u32(GByteArray *buffer, guint32 value) {
+    g_byte_array_append(buffer, (const guint8 *)&value, sizeof(value));
 }
 
+static void snapshot_append_string(GByteArray *buffer, const char *str) {
+    guint32 length = strlen(str);
+    snapshot_append_u32(buffer, length);
+    g_byte_array_append(buffer, (const guint8 *)str, length);
+}
 
-static GtkWidget *create_timetable_page(AppData *app_data) {
-    GtkWidget *grid = gtk_grid_new();
-    gtk_grid_set_row_spacing(GTK_GRID(grid), 3);
-    gtk_grid_set_column_spacing(GTK_GRID(grid), 3);
-    gtk_widget_set_margin_start(grid, 10);
-    gtk_widget_set_margin_end(grid, 10);
-    gtk_widget_set_margin_top(grid, 10);
-    gtk_widget_set_margin_bottom(grid, 10);
-    gtk_widget_set_hexpand(grid, TRUE);
-    gtk_widget_set_vexpand(grid, TRUE);
-    gtk_grid_set_column_homogeneous(GTK_GRID(grid), TRUE);
-    gtk_grid_set_row_homogeneous(GTK_GRID(grid), TRUE);
+static void snapshot_append_tasks(GByteArray *buffer, GList *tasks) {
+    for (GList *iter = tasks; iter; iter = iter->next) {
+        const TaskEntry *entry = iter->data;
+        snapshot_append_string(buffer, entry->task);
+        snapshot_append_string(buffer, entry->day);
+        snapshot_append_string(buffer, entry->time_slot);
+    }
+}
 
+static void snapshot_write(AppData *app_data) {
+    // A dashboard that never finished loading is not worth persisting.
+    if (!app_data->db || !app_data->loaded_us) return;
 
-    app_data->timetable_grid = grid;
+    SnapshotHeader header = {0};
+    header.magic = SNAPSHOT_MAGIC;
+    header.format_version = SNAPSHOT_FORMAT_VERSION;
+    header.data_version = data_version_read(app_data->db);
+    header.habit_count = g_list_length(app_data->habits);
+    header.task_count = g_list_length(app_data->tasks);
+    header.completed_count = g_list_length(app_data->completed_tasks);
 
-    const char *days[] = {"", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
-    for (int i = 0; i < 8; i++) {
-        GtkWidget *label = gtk_label_new(days[i]);
-        gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
-        gtk_widget_set_valign(label, GTK_ALIGN_CENTER);
-        gtk_widget_add_css_class(label, "heading");
-        gtk_grid_attach(GTK_GRID(grid), label, i, 0, 1, 1);
+    GByteArray *buffer = g_byte_array_new();
+    g_byte_array_append(buffer, (const guint8 *)&header, sizeof(header));
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        const Habit *habit = iter->data;
+        g_byte_array_append(buffer, (const guint8 *)&habit->id, sizeof(habit->id));
+        snapshot_append_string(buffer, habit->name);
+        snapshot_append_string(buffer, habit->days);
+        snapshot_append_string(buffer, habit->time_slot);
+        g_byte_array_append(buffer, (const guint8 *)&habit->target, sizeof(habit->target));
+        snapshot_append_string(buffer, habit->unit);
+        snapshot_append_u32(buffer, habit->quota);
+        snapshot_append_u32(buffer, habit->quota_rolling);
+        snapshot_append_u32(buffer, habit->schedule_count);
+        for (guint j = 0; j < habit->schedule_count; j++) {
+            snapshot_append_u32(buffer, (guint32)habit->schedule[j].from_day);
+            snapshot_append_u32(buffer, habit->schedule[j].days_mask);
+        }
+        snapshot_append_u32(buffer, habit->days_completed);
+
+        // Rolling counters are stored as their completed day numbers.
+        guint count_pos = buffer->len;
+        guint32 completed_days = 0;
+        snapshot_append_u32(buffer, 0);
+        for (int i = 0; habit->counter_tree && i < COUNTER_SPAN_DAYS; i++) {
+            if (counter_prefix(habit->counter_tree, i) - counter_prefix(habit->counter_tree, i - 1) > 0) {
+                gint32 day = habit->counter_base + i;
+                g_byte_array_append(buffer, (const guint8 *)&day, sizeof(day));
+                completed_days++;
+            }
+        }
+        memcpy(buffer->data + count_pos, &completed_days, sizeof(completed_days));
     }
+    snapshot_append_tasks(buffer, app_data->tasks);
+    snapshot_append_tasks(buffer, app_data->completed_tasks);
 
-    const char *times[] = {
-        "00:00-02:00", "02:00-04:00", "04:00-06:00", "06:00-08:00",
-        "08:00-10:00", "10:00-12:00", "12:00-14:00", "14:00-16:00",
-        "16:00-18:00", "18:00-20:00", "20:00-22:00", "22:00-24:00"
-    };
-    for (int i = 0; i < 12; i++) {
-        GtkWidget *label = gtk_label_new(times[i]);
-        gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
-         gtk_widget_set_valign(label, GTK_ALIGN_CENTER);
-        gtk_widget_add_css_class(label, "heading");
-        gtk_grid_attach(GTK_GRID(grid), label, 0, i + 1, 1, 1);
+    GError *error = NULL;
+    if (!g_file_set_contents(HABIT_SNAPSHOT_PATH, (const char *)buffer->data, buffer->len, &error)) {
+        g_printerr("Failed to write snapshot %s: %s\n", HABIT_SNAPSHOT_PATH, error->message);
+        g_error_free(error);
     }
+    g_byte_array_unref(buffer);
+}
 
-    for (int day_col = 1; day_col <= 7; day_col++) {
-        for (int time_row = 1; time_row <= 12; time_row++) {
-            GtkWidget *task_box_cell = gtk_box_new(GTK_ORIENTATION_VERTICAL, 3);
-            gtk_widget_set_hexpand(task_box_cell, TRUE);
-            gtk_widget_set_vexpand(task_box_cell, TRUE);
-            gtk_widget_add_css_class(task_box_cell, "task-slot");
+static gboolean snapshot_read_u32(SnapshotReader *reader, guint32 *value) {
+    if (reader->end - reader->pos < (gssize)sizeof(*value)) return FALSE;
+    memcpy(value, reader->pos, sizeof(*value));
+    reader->pos += sizeof(*value);
+    return TRUE;
+}
 
-            char query_tasks[256];
-            snprintf(query_tasks, sizeof(query_tasks),
-                     "SELECT task FROM timetable_tasks WHERE day = '%s' AND time_slot = '%s';",
-                     days[day_col], times[time_row - 1]);
-            sqlite3_stmt *stmt_tasks;
-            if (sqlite3_prepare_v2(app_data->db, query_tasks, -1, &stmt_tasks, NULL) == SQLITE_OK) {
-                while (sqlite3_step(stmt_tasks) == SQLITE_ROW) {
-                    const char *task_text = (const char *)sqlite3_column_text(stmt_tasks, 0);
-                    GtkWidget *task_label_ui = gtk_label_new(task_text);
-                    gtk_widget_set_halign(task_label_ui, GTK_ALIGN_START);
-                    gtk_widget_set_margin_start(task_label_ui, 5);
-                    gtk_box_append(GTK_BOX(task_box_cell), task_label_ui);
-
-                    char task_display_pending[512];
-                    snprintf(task_display_pending, sizeof(task_display_pending), "%s (%s, %s)", task_text, days[day_col], times[time_row - 1]);
-                    GtkWidget *task_row_pending_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-                    GtkWidget *pending_task_label_widget = gtk_label_new(task_display_pending);
-                    gtk_widget_set_halign(pending_task_label_widget, GTK_ALIGN_START);
-                     gtk_widget_set_hexpand(pending_task_label_widget, TRUE);
-                    gtk_box_append(GTK_BOX(task_row_pending_box), pending_task_label_widget);
-
-                    GtkWidget *done_button_pending = gtk_button_new_with_label("Mark as Done");
-                    g_object_set_data(G_OBJECT(done_button_pending), "task", g_strdup(task_text));
-                    g_object_set_data(G_OBJECT(done_button_pending), "day", g_strdup(days[day_col]));
-                    g_object_set_data(G_OBJECT(done_button_pending), "time_slot", g_strdup(times[time_row - 1]));
-                    g_object_set_data(G_OBJECT(done_button_pending), "task_row", task_row_pending_box);
-                    g_object_set_data(G_OBJECT(done_button_pending), "task_label_timetable", task_label_ui);
-                    g_signal_connect(done_button_pending, "clicked", G_CALLBACK(on_mark_task_done), app_data);
-                    gtk_box_append(GTK_BOX(task_row_pending_box), done_button_pending);
-
-                    gtk_box_append(GTK_BOX(app_data->pending_tasks_box), task_row_pending_box);
-                }
-            }
-            sqlite3_finalize(stmt_tasks);
-
-            char habit_query[256];
-            snprintf(habit_query, sizeof(habit_query),
-                     "SELECT habit_name, days FROM habit_tracking WHERE time_slot = '%s' AND (date = '' OR date IS NULL);", // only base habit defs
-                     times[time_row - 1]);
-            sqlite3_stmt *habit_stmt;
-            if (sqlite3_prepare_v2(app_data->db, habit_query, -1, &habit_stmt, NULL) == SQLITE_OK) {
-                while (sqlite3_step(habit_stmt) == SQLITE_ROW) {
-                    const char *habit_name_text = (const char *)sqlite3_column_text(habit_stmt, 0);
-                    const char *habit_days_text = (const char *)sqlite3_column_text(habit_stmt, 1);
-
-                    if (habit_days_text && strstr(habit_days_text, days[day_col])) {
-                        GtkWidget *habit_label_ui = gtk_label_new(habit_name_text);
-                        gtk_widget_set_halign(habit_label_ui, GTK_ALIGN_START);
-                        gtk_widget_add_css_class(habit_label_ui, "habit-label");
-                        gtk_widget_set_margin_start(habit_label_ui, 5);
-                        gtk_box_append(GTK_BOX(task_box_cell), habit_label_ui);
-                    }
-                }
-            }
-            sqlite3_finalize(habit_stmt);
+static gboolean snapshot_read_i64(SnapshotReader *reader, gint64 *value) {
+    if (reader->end - reader->pos < (gssize)sizeof(*value)) return FALSE;
+    memcpy(value, reader->pos, sizeof(*value));
+    reader->pos += sizeof(*value);
+    return TRUE;
+}
 
-            GtkGesture *click_controller = gtk_gesture_click_new();
-            TimetableCellData *cell_data = g_new0(TimetableCellData, 1);
-            cell_data->app_data = app_data;
-            cell_data->day = g_strdup(days[day_col]);
-            cell_data->time_slot = g_strdup(times[time_row - 1]);
-            cell_data->task_box_in_grid = task_box_cell;
+static gboolean snapshot_read_double(SnapshotReader *reader, double *value) {
+    if (reader->end - reader->pos < (gssize)sizeof(*value)) return FALSE;
+    memcpy(value, reader->pos, sizeof(*value));
+    reader->pos += sizeof(*value);
+    return TRUE;
+}
 
-            g_signal_connect_data(click_controller, "pressed", G_CALLBACK(on_timetable_cell_clicked), cell_data, (GClosureNotify)free_timetable_cell_data, 0);
-            gtk_widget_add_controller(task_box_cell, GTK_EVENT_CONTROLLER(click_controller));
+static char *snapshot_read_string(SnapshotReader *reader) {
+    guint32 length;
+    if (!snapshot_read_u32(reader, &length) || reader->end - reader->pos < (gssize)length) return NULL;
+    char *str = mem_alloc(MEM_MODEL, length + 1);
+    memcpy(str, reader->pos, length);
+    reader->pos += length;
+    return str;
+}
 
-            gtk_grid_attach(GTK_GRID(grid), task_box_cell, day_col, time_row, 1, 1);
+static gboolean snapshot_read_tasks(SnapshotReader *reader, guint32 count, GPtrArray *tasks) {
+    for (guint32 i = 0; i < count; i++) {
+        TaskEntry *entry = mem_alloc(MEM_MODEL, sizeof(TaskEntry));
+        g_ptr_array_add(tasks, entry);
+        entry->task = snapshot_read_string(reader);
+        entry->day = snapshot_read_string(reader);
+        entry->time_slot = snapshot_read_string(reader);
+        if (!entry->task || !entry->day || !entry->time_slot) return FALSE;
+    }
+    return TRUE;
+}
+
+static StartupData *snapshot_load(void) {
+    GError *error = NULL;
+    GMappedFile *mapped = g_mapped_file_new(HABIT_SNAPSHOT_PATH, FALSE, &error);
+    if (!mapped) {
+        if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+            g_printerr("Cannot map snapshot %s: %s\n", HABIT_SNAPSHOT_PATH, error->message);
         }
+        g_error_free(error);
+        return NULL;
     }
 
-    char completed_query[256];
-    snprintf(completed_query, sizeof(completed_query), "SELECT task, day, time_slot FROM completed_tasks;");
-    sqlite3_stmt *completed_stmt;
-    if (sqlite3_prepare_v2(app_data->db, completed_query, -1, &completed_stmt, NULL) == SQLITE_OK) {
-        while (sqlite3_step(completed_stmt) == SQLITE_ROW) {
-            const char *task_text = (const char *)sqlite3_column_text(completed_stmt, 0);
-            const char *day_text = (const char *)sqlite3_column_text(completed_stmt, 1);
-            const char *time_slot_text = (const char *)sqlite3_column_text(completed_stmt, 2);
+    SnapshotReader reader;
+    reader.pos = g_mapped_file_get_contents(mapped);
+    reader.end = reader.pos + g_mapped_file_get_length(mapped);
+
+    SnapshotHeader header;
+    if (reader.end - reader.pos < (gssize)sizeof(header)) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+    memcpy(&header, reader.pos, sizeof(header));
+    reader.pos += sizeof(header);
+    if (header.magic != SNAPSHOT_MAGIC || header.format_version != SNAPSHOT_FORMAT_VERSION) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
 
-            char task_display_completed[512];
-            snprintf(task_display_completed, sizeof(task_display_completed), "%s (%s, %s)", task_text, day_text, time_slot_text);
-            GtkWidget *completed_task_label_ui = gtk_label_new(task_display_completed);
-            gtk_widget_set_halign(completed_task_label_ui, GTK_ALIGN_START);
-            gtk_box_append(GTK_BOX(app_data->completed_tasks_box), completed_task_label_ui);
+    StartupData *startup = g_new0(StartupData, 1);
+    startup->habits = g_ptr_array_new_with_free_func(habit_free);
+    startup->tasks = g_ptr_array_new_with_free_func(task_entry_free);
+    startup->completed_tasks = g_ptr_array_new_with_free_func(task_entry_free);
+    startup->data_version = header.data_version;
+
+    gboolean valid = TRUE;
+    gint32 counter_base = habit_counter_base_for(day_number_today());
+    for (guint32 i = 0; valid && i < header.habit_count; i++) {
+        Habit *habit = mem_alloc(MEM_MODEL, sizeof(Habit));
+        g_ptr_array_add(startup->habits, habit);
+        guint32 days_completed = 0;
+        valid = snapshot_read_i64(&reader, &habit->id);
+        habit->name = valid ? snapshot_read_string(&reader) : NULL;
+        habit->days = habit->name ? snapshot_read_string(&reader) : NULL;
+        habit->time_slot = habit->days ? snapshot_read_string(&reader) : NULL;
+        valid = habit->time_slot && snapshot_read_double(&reader, &habit->target);
+        habit->unit = valid ? snapshot_read_string(&reader) : NULL;
+        guint32 quota = 0, quota_rolling = 0, schedule_count = 0;
+        valid = habit->unit && snapshot_read_u32(&reader, &quota) && snapshot_read_u32(&reader, &quota_rolling) &&
+                snapshot_read_u32(&reader, &schedule_count);
+        for (guint32 j = 0; valid && j < schedule_count; j++) {
+            guint32 from_day, days_mask;
+            valid = snapshot_read_u32(&reader, &from_day) && snapshot_read_u32(&reader, &days_mask);
+            if (valid) habit_schedule_set(habit, (gint32)from_day, days_mask);
+        }
+        valid = valid && snapshot_read_u32(&reader, &days_completed);
+        if (valid) habit_schedule_ensure(habit);
+        habit->quota = quota;
+        habit->quota_rolling = quota_rolling;
+        habit->days_completed = days_completed;
+
+        guint32 counter_days = 0;
+        valid = valid && snapshot_read_u32(&reader, &counter_days) &&
+                reader.end - reader.pos >= (gssize)(counter_days * sizeof(gint32));
+        if (valid) habit_counter_reset(habit, counter_base);
+        for (guint32 j = 0; valid && j < counter_days; j++) {
+            gint32 day;
+            memcpy(&day, reader.pos, sizeof(day));
+            reader.pos += sizeof(day);
+            habit_counter_add(habit, day, 1);
         }
+        if (valid) {
+            habit_strength_recompute(habit, day_number_today());
+            habit_quota_recompute(habit, day_number_today());
+        }
+    }
+    valid = valid && snapshot_read_tasks(&reader, header.task_count, startup->tasks) &&
+            snapshot_read_tasks(&reader, header.completed_count, startup->completed_tasks);
+    g_mapped_file_unref(mapped);
+
+    if (!valid) {
+        g_printerr("Ignoring truncated snapshot %s\n", HABIT_SNAPSHOT_PATH);
+        startup_data_free(startup);
+        return NULL;
     }
-    sqlite3_finalize(completed_stmt);
+    return startup;
+}
 
-    return grid;
+// Builds the whole dashboard from the snapshot in one go: it holds only
+// what the first screen shows, so its size does not grow with history.
+static void snapshot_apply(AppData *app_data) {
+    StartupData *snapshot = snapshot_load();
+    if (!snapshot) return;
+
+    app_data->startup_data = snapshot;
+    const char *current_day_name = current_weekday_name();
+    while (startup_materialize_next(app_data, current_day_name)) {
+    }
+    startup_model_done(app_data);
+}
+
+static void startup_begin(AppData *app_data) {
+    GdkFrameClock *frame_clock = gtk_widget_get_frame_clock(app_data->main_window);
+    if (frame_clock) {
+        app_data->first_frame_clock = g_object_ref(frame_clock);
+        app_data->first_frame_handler = g_signal_connect(frame_clock, "after-paint", G_CALLBACK(on_first_frame_painted), app_data);
+    } else {
+        startup_connect(app_data);
+    }
+}
+
+static void startup_stop(AppData *app_data) {
+    if (app_data->startup_cancellable) {
+        g_cancellable_cancel(app_data->startup_cancellable);
+        g_clear_object(&app_data->startup_cancellable);
+    }
+    if (app_data->startup_source) {
+        g_source_remove(app_data->startup_source);
+        app_data->startup_source = 0;
+    }
+    g_clear_pointer(&app_data->startup_data, startup_data_free);
+    if (app_data->first_frame_clock) {
+        g_signal_handler_disconnect(app_data->first_frame_clock, app_data->first_frame_handler);
+        g_clear_object(&app_data->first_frame_clock);
+    }
+}
+
+// The Weekly Timetable page starts as an empty scrolled window and its grid
+// is built on the first switch to it, from the habits and tasks already held
+// in memory, so a dashboard-only session never builds the 84 cells at all.
+static void timetable_page_build(AppData *app_data) {
+    GtkWidget *timetable_page_content = create_timetable_page(app_data);
+    for (GList *iter = app_data->tasks; iter; iter = iter->next) {
+        add_task_to_timetable(app_data, iter->data);
+    }
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        add_habit_to_timetable(app_data, iter->data);
+    }
+    timetable_sessions_refresh(app_data);
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(app_data->timetable_page), timetable_page_content);
+}
+
+static void on_notebook_switch_page(GtkNotebook *notebook, GtkWidget *page, guint page_num, AppData *app_data) {
+    if (page == app_data->stats_page) {
+        if (!app_data->stats_page_current) analytics_page_build(app_data);
+        return;
+    }
+    if (page == app_data->heatmap_page) {
+        if (!app_data->heatmap_page_current) heatmap_page_build(app_data);
+        return;
+    }
+    if (page == app_data->correlation_page) {
+        if (!app_data->correlation_page_current) correlation_page_build(app_data);
+        return;
+    }
+    if (page != app_data->timetable_page || app_data->timetable_grid) return;
+    timetable_page_build(app_data);
 }
 
 static void cleanup_app_data(AppData *app_data) {
-    g_list_free_full(app_data->habits, g_free);
+    hud_stop(app_data);
+    startup_stop(app_data);
+    maintenance_stop(app_data);
+    purge_stop(app_data);
+    archive_stop(app_data);
+    history_load_stop(app_data);
+    month_overview_stop(app_data);
+    correlation_stop(app_data);
+    analytics_stop(app_data);
+    forecast_stop(app_data);
+    values_load_stop(app_data);
+    session_stop(app_data);
+    if (app_data->day_rollover_source) {
+        g_source_remove(app_data->day_rollover_source);
+        app_data->day_rollover_source = 0;
+    }
+    g_clear_pointer(&app_data->correlation, correlation_result_free);
+    g_clear_pointer(&app_data->analytics, analytics_result_free);
+    snapshot_write(app_data);
+    if (app_data->edit_habits_window) {
+        gtk_window_destroy(GTK_WINDOW(app_data->edit_habits_window));
+    }
+    if (app_data->archive_window) {
+        gtk_window_destroy(GTK_WINDOW(app_data->archive_window));
+    }
+    if (app_data->memory_panel) {
+        gtk_window_destroy(GTK_WINDOW(app_data->memory_panel));
+    }
+    while (app_data->latency_probes) {
+        latency_probe_free((LatencyProbe *)app_data->latency_probes->data);
+    }
+    if (app_data->latency_signal_source) {
+        g_source_remove(app_data->latency_signal_source);
+        app_data->latency_signal_source = 0;
+    }
+    if (app_data->app) {
+        g_action_map_remove_action(G_ACTION_MAP(app_data->app), "dump-latency");
+        g_action_map_remove_action(G_ACTION_MAP(app_data->app), "toggle-hud");
+        g_action_map_remove_action(G_ACTION_MAP(app_data->app), "memory-panel");
+        g_action_map_remove_action(G_ACTION_MAP(app_data->app), "rolling-counts");
+    }
+
+    g_hash_table_remove_all(app_data->habits_by_id);
+    g_list_free_full(app_data->habits, habit_free);
     app_data->habits = NULL;
+    g_list_free_full(app_data->tasks, task_entry_free);
+    app_data->tasks = NULL;
+    g_list_free_full(app_data->completed_tasks, task_entry_free);
+    app_data->completed_tasks = NULL;
 
-    for (GList *iter = app_data->habit_widgets; iter; iter = iter->next) {
-        GtkWidget *habit_box_widget = (GtkWidget *)iter->data;
-        char *habit_name_data = (char *)g_object_get_data(G_OBJECT(habit_box_widget), "habit_name");
-        if (habit_name_data) g_free(habit_name_data);
-
-        GtkWidget *child_iter = gtk_widget_get_first_child(habit_box_widget);
-        while (child_iter) {
-            if (GTK_IS_DRAWING_AREA(child_iter)){
-                 char *drawing_habit_name = (char *)g_object_get_data(G_OBJECT(child_iter), "habit_name");
-                 if(drawing_habit_name) g_free(drawing_habit_name);
-            }
-            if (GTK_IS_BUTTON(child_iter) && strcmp(gtk_button_get_label(GTK_BUTTON(child_iter)), "Done Today") == 0) {
-                char *button_habit_name_data = (char *)g_object_get_data(G_OBJECT(child_iter), "habit_name");
-                if (button_habit_name_data) g_free(button_habit_name_data);
-            }
-            child_iter = gtk_widget_get_next_sibling(child_iter);
-        }
-    }
+    // Strings attached to the habit widgets are released by their destroy
+    // notifies when the window's children are finalized.
     g_list_free(app_data->habit_widgets);
     app_data->habit_widgets = NULL;
+    g_clear_pointer(&app_data->habit_boxes, g_hash_table_destroy);
+
+    if (app_data->metrics_source) {
+        g_source_remove(app_data->metrics_source);
+        app_data->metrics_source = 0;
+    }
+    g_free(app_data->metrics_path);
 
     if (app_data->db) {
+        sql_profile_report(app_data);
         sqlite3_close(app_data->db);
         app_data->db = NULL;
     }
+    g_clear_pointer(&app_data->sql_stats, g_hash_table_destroy);
+    g_clear_pointer(&app_data->sql_running_rows, g_hash_table_destroy);
+    g_clear_pointer(&app_data->heatmap_tiles, g_hash_table_destroy);
+    g_clear_pointer(&app_data->habits_by_id, g_hash_table_destroy);
+    g_clear_pointer(&app_data->month_overviews, g_hash_table_destroy);
+    g_clear_pointer(&app_data->session_weeks, g_hash_table_destroy);
 
     g_free(app_data);
 }
 
-static void on_done_today_clicked(GtkButton *button, AppData *app_data) {
-    const char *habit_name = (const char *)g_object_get_data(G_OBJECT(button), "habit_name");
-    GtkWidget *drawing_area = (GtkWidget *)g_object_get_data(G_OBJECT(button), "drawing_area");
+// The completion path for any habit-day. The stored state is flipped in
+// whichever file holds the row; new rows always go to the hot file, and the
+// next archiver pass moves them if they are old. Then the lifetime count,
+// rolling counter, history bitmap, statistics, heatmap tile and badge
+// are updated.
+static gboolean habit_toggle_day(AppData *app_data, gint64 habit_id, gint32 day) {
+    const char *schemas[] = {"main", "archive"};
+    const char *schema = NULL;
+    int completed_status = 0; // Default to not completed
+    for (int i = 0; i < 2 && !schema; i++) {
+        char query_select[256];
+        snprintf(query_select, sizeof(query_select),
+                 "SELECT completed FROM %s.habit_completions WHERE habit_id = %" G_GINT64_FORMAT " AND day = %d;",
+                 schemas[i], habit_id, day);
+        sqlite3_stmt *stmt_select;
+        if (sqlite3_prepare_v2(app_data->db, query_select, -1, &stmt_select, NULL) == SQLITE_OK) {
+            if (sqlite3_step(stmt_select) == SQLITE_ROW) {
+                completed_status = sqlite3_column_int(stmt_select, 0);
+                schema = schemas[i];
+            }
+        }
+        sqlite3_finalize(stmt_select);
+    }
 
-    GDateTime *date_time = g_date_time_new_now_local();
-    if (!date_time) return;
+    char query_update[768];
+    if (schema) {
+        completed_status = !completed_status; // Toggle if exists
+        int length = snprintf(query_update, sizeof(query_update),
+                              "BEGIN; UPDATE %s.habit_completions SET completed = %d WHERE habit_id = %" G_GINT64_FORMAT " AND day = %d;",
+                              schema, completed_status, habit_id, day);
+        if (schema == schemas[1]) {
+            length += snprintf(query_update + length, sizeof(query_update) - length,
+                               "INSERT OR REPLACE INTO archive.habit_totals (habit_id, completed_days, first_day, last_day) "
+                               "SELECT habit_id, SUM(completed = 1), MIN(day), MAX(day) FROM archive.habit_completions "
+                               "WHERE habit_id = %" G_GINT64_FORMAT " GROUP BY habit_id;", habit_id);
+        }
+        snprintf(query_update + length, sizeof(query_update) - length, "COMMIT;");
+    } else {
+        completed_status = 1;
+        snprintf(query_update, sizeof(query_update),
+                 "INSERT INTO habit_completions (habit_id, day, completed) VALUES (%" G_GINT64_FORMAT ", %d, %d);",
+                 habit_id, day, completed_status);
+    }
 
-    gint year_val = g_date_time_get_year(date_time);
-    gint month_val = g_date_time_get_month(date_time);
-    gint day_val = g_date_time_get_day_of_month(date_time);
-    char date_str_val[11];
-    snprintf(date_str_val, sizeof(date_str_val), "%04d-%02d-%02d", year_val, month_val, day_val);
+    if (sqlite3_exec(app_data->db, query_update, NULL, NULL, NULL) != SQLITE_OK) {
+        g_printerr("Failed to update habit completion: %s\n", sqlite3_errmsg(app_data->db));
+        sqlite3_exec(app_data->db, "ROLLBACK;", NULL, NULL, NULL);
+        return FALSE;
+    }
 
-    g_date_time_unref(date_time);
+    Habit *habit = habit_find(app_data, habit_id);
+    if (habit) {
+        habit->days_completed += completed_status ? 1 : -1;
+        habit_counter_add(habit, day, completed_status ? 1 : -1);
+        habit_strength_toggle(habit, day, completed_status ? 1 : -1);
+        habit_quota_toggle(habit, day, completed_status ? 1 : -1);
+        habit_quota_widgets_refresh(app_data, habit);
+        forecast_check_in(app_data, habit, day, completed_status);
+        if (habit->history) {
+            history_set(habit->history, day, completed_status);
+        } else if (app_data->history_cancellable) {
+            app_data->history_stale = TRUE;
+        }
+        analytics_invalidate(app_data);
+        heatmap_day_changed(app_data, habit_id, day);
+        month_overview_day_changed(app_data, day, completed_status);
+    }
+    GtkWidget *habit_box = habit_box_find(app_data, habit_id);
+    if (habit_box) gtk_widget_queue_draw(gtk_widget_get_first_child(habit_box));
+    return TRUE;
+}
 
-    char query_select[256];
-    snprintf(query_select, sizeof(query_select),
-             "SELECT completed FROM habit_tracking WHERE habit_name = '%s' AND date = '%s';",
-             habit_name, date_str_val);
+static void on_done_today_clicked(GtkButton *button, AppData *app_data) {
+    gint64 click_us = g_get_monotonic_time();
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(button), "habit_id"));
+    GtkWidget *drawing_area = (GtkWidget *)g_object_get_data(G_OBJECT(button), "drawing_area");
 
-    sqlite3_stmt *stmt_select;
-    int completed_status = 0; // Default to not completed
-    gboolean entry_exists = FALSE;
+    habit_toggle_day(app_data, habit_id, day_number_today());
+    latency_probe_committed(app_data, LATENCY_ACTION_DONE_TODAY, click_us, drawing_area);
+}
 
-    if (sqlite3_prepare_v2(app_data->db, query_select, -1, &stmt_select, NULL) == SQLITE_OK) {
-        if (sqlite3_step(stmt_select) == SQLITE_ROW) {
-            completed_status = sqlite3_column_int(stmt_select, 0);
-            entry_exists = TRUE;
-        }
+// Amounts of every active quantitative habit, read in day order by a worker
+// after startup so the columns are appended to rather than inserted into.
+static void values_load_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    GHashTable *values_by_id = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, (GDestroyNotify)habit_values_free);
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(HABIT_DB_PATH, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        g_printerr("Amount loader cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        g_task_return_pointer(task, values_by_id, (GDestroyNotify)g_hash_table_unref);
+        return;
     }
-    sqlite3_finalize(stmt_select);
 
-    char query_update[512];
-    if (entry_exists) {
-         completed_status = !completed_status; // Toggle if exists
-         snprintf(query_update, sizeof(query_update),
-                 "UPDATE habit_tracking SET completed = %d WHERE habit_name = '%s' AND date = '%s';",
-                 completed_status, habit_name, date_str_val);
-    } else {
-        char fetch_details_query[256];
-        snprintf(fetch_details_query, sizeof(fetch_details_query),
-                 "SELECT days, time_slot FROM habit_tracking WHERE habit_name = '%s' AND (date = '' OR date IS NULL);", habit_name);
-        sqlite3_stmt *stmt_details;
-        const char *days_str = "";
-        const char *time_slot_str = "";
-        if (sqlite3_prepare_v2(app_data->db, fetch_details_query, -1, &stmt_details, NULL) == SQLITE_OK) {
-            if (sqlite3_step(stmt_details) == SQLITE_ROW) {
-                const char* fetched_days = (const char*)sqlite3_column_text(stmt_details, 0);
-                const char* fetched_time_slot = (const char*)sqlite3_column_text(stmt_details, 1);
-                if(fetched_days) days_str = fetched_days;
-                if(fetched_time_slot) time_slot_str = fetched_time_slot;
+    const char *values_sql =
+        "SELECT habit_id, day, value FROM habit_values "
+        "WHERE habit_id IN (SELECT id FROM habits WHERE archived = 0 AND target > 0) ORDER BY habit_id, day;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, values_sql, -1, &stmt, NULL) == SQLITE_OK) {
+        gint64 current_id = 0;
+        HabitValues *values = NULL;
+        while (sqlite3_step(stmt) == SQLITE_ROW && !g_cancellable_is_cancelled(cancellable)) {
+            gint64 habit_id = sqlite3_column_int64(stmt, 0);
+            if (!values || habit_id != current_id) {
+                gint64 *key = g_new(gint64, 1);
+                *key = current_id = habit_id;
+                values = habit_values_new();
+                g_hash_table_insert(values_by_id, key, values);
             }
+            habit_values_set(values, sqlite3_column_int(stmt, 1), sqlite3_column_double(stmt, 2));
         }
-        sqlite3_finalize(stmt_details);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    g_task_return_pointer(task, values_by_id, (GDestroyNotify)g_hash_table_unref);
+}
 
-        completed_status = 1;
-        snprintf(query_update, sizeof(query_update),
-                 "INSERT INTO habit_tracking (date, habit_name, completed, days, time_slot) "
-                 "VALUES ('%s', '%s', %d, '%s', '%s');",
-                 date_str_val, habit_name, completed_status, days_str, time_slot_str);
+static void on_values_loaded(GObject *source_object, GAsyncResult *result, gpointer data) {
+    GTask *task = G_TASK(result);
+    GHashTable *values_by_id = g_task_propagate_pointer(task, NULL);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        if (values_by_id) g_hash_table_unref(values_by_id);
+        return;
     }
 
+    AppData *app_data = data;
+    g_clear_object(&app_data->values_cancellable);
+    if (app_data->values_stale) {
+        // An amount was logged while the rows were read; they may not have it.
+        app_data->values_stale = FALSE;
+        g_hash_table_unref(values_by_id);
+        values_load_start(app_data);
+        return;
+    }
 
-    if (sqlite3_exec(app_data->db, query_update, NULL, NULL, NULL) != SQLITE_OK) {
-        g_printerr("Failed to update habit completion: %s\n", sqlite3_errmsg(app_data->db));
+    gint32 today = day_number_today();
+    for (GList *iter = app_data->habits; iter; iter = iter->next) {
+        Habit *habit = iter->data;
+        if (habit->target <= 0 || habit->values) continue;
+        gpointer key, values;
+        if (g_hash_table_steal_extended(values_by_id, &habit->id, &key, &values)) {
+            g_free(key);
+            habit->values = values;
+        } else {
+            habit->values = habit_values_new();
+        }
     }
+    g_hash_table_unref(values_by_id);
 
+    for (GList *iter = app_data->habit_widgets; iter; iter = iter->next) {
+        GtkWidget *habit_box = iter->data;
+        const Habit *habit = habit_find(app_data, HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(habit_box), "habit_id")));
+        GtkWidget *amount_spin = g_object_get_data(G_OBJECT(habit_box), "amount_spin");
+        if (!habit || !habit->values) continue;
+        if (amount_spin) {
+            g_signal_handlers_block_by_func(amount_spin, on_habit_amount_changed, app_data);
+            gtk_spin_button_set_value(GTK_SPIN_BUTTON(amount_spin), habit_values_get(habit->values, today));
+            g_signal_handlers_unblock_by_func(amount_spin, on_habit_amount_changed, app_data);
+        }
+        gtk_widget_queue_draw(gtk_widget_get_first_child(habit_box));
+    }
+    app_data->stats_page_current = FALSE;
+    analytics_page_refresh(app_data);
+}
+
+static void values_load_start(AppData *app_data) {
+    if (app_data->values_cancellable) return;
+    app_data->values_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app_data->values_cancellable, on_values_loaded, app_data);
+    g_task_run_in_thread(task, values_load_thread);
+    g_object_unref(task);
+}
+
+static void values_load_stop(AppData *app_data) {
+    if (app_data->values_cancellable) {
+        g_cancellable_cancel(app_data->values_cancellable);
+        g_clear_object(&app_data->values_cancellable);
+    }
+}
 
-    if (drawing_area) {
-        gtk_widget_queue_draw(drawing_area);
+// Logs amount for a quantitative habit's day and keeps the completion in
+// step with it: reaching the target completes the day, dropping below it
+// takes the completion back, both through habit_toggle_day. Every way of
+// checking such a habit in goes through here.
+static void habit_amount_set(AppData *app_data, gint64 habit_id, gint32 day, double amount) {
+    sqlite3_stmt *stmt;
+    const char *sql = amount > 0 ? "INSERT OR REPLACE INTO habit_values (habit_id, day, value) VALUES (?1, ?2, ?3);"
+                                 : "DELETE FROM habit_values WHERE habit_id = ?1 AND day = ?2;";
+    if (sqlite3_prepare_v2(app_data->db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        g_printerr("Failed to log amount: %s\n", sqlite3_errmsg(app_data->db));
+        return;
+    }
+    sqlite3_bind_int64(stmt, 1, habit_id);
+    sqlite3_bind_int(stmt, 2, day);
+    if (amount > 0) sqlite3_bind_double(stmt, 3, amount);
+    gboolean failed = sqlite3_step(stmt) != SQLITE_DONE;
+    if (failed) g_printerr("Failed to log amount: %s\n", sqlite3_errmsg(app_data->db));
+    sqlite3_finalize(stmt);
+    if (failed) return;
+
+    Habit *habit = habit_find(app_data, habit_id);
+    if (!habit) return;
+    if (habit->values) {
+        habit_values_set(habit->values, day, amount);
+    } else if (app_data->values_cancellable) {
+        app_data->values_stale = TRUE;
+    }
+    GtkWidget *habit_box = habit_box_find(app_data, habit_id);
+    if (habit_box) {
+        GtkWidget *amount_spin = g_object_get_data(G_OBJECT(habit_box), "amount_spin");
+        if (amount_spin && day == day_number_today()) {
+            g_signal_handlers_block_by_func(amount_spin, on_habit_amount_changed, app_data);
+            gtk_spin_button_set_value(GTK_SPIN_BUTTON(amount_spin), amount);
+            g_signal_handlers_unblock_by_func(amount_spin, on_habit_amount_changed, app_data);
+        }
+        gtk_widget_queue_draw(gtk_widget_get_first_child(habit_box));
+    }
+    if ((amount >= habit->target) != (habit_counter_range(habit, day, day) > 0)) {
+        habit_toggle_day(app_data, habit_id, day);
     }
+    app_data->stats_page_current = FALSE;
+    analytics_page_refresh(app_data);
+}
+
+static void on_habit_amount_changed(GtkSpinButton *spin_button, AppData *app_data) {
+    gint64 habit_id = HABIT_ID_FROM_POINTER(g_object_get_data(G_OBJECT(spin_button), "habit_id"));
+    habit_amount_set(app_data, habit_id, day_number_today(), gtk_spin_button_get_value(spin_button));
 }
 
 
 static void on_activate(GtkApplication *app, gpointer user_data) {
+    gint64 startup_us = *(gint64 *)user_data;
     GtkSettings *settings = gtk_settings_get_default();
     g_object_set(settings, "gtk-application-prefer-dark-theme", TRUE, NULL);
 
@@ -1449,6 +6818,8 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
         ".task-slot { border: 1px solid #4A4A6A; background-color: rgba(50, 50, 70, 0.65); padding: 8px; border-radius: 4px; transition: background-color 0.2s ease-in-out; }"
         ".task-slot:hover { background-color: rgba(60, 60, 80, 0.75); }"
         ".habit-label { color: #90B0E0; font-weight: normal; font-size: 13px; }"
+        ".forecast-risk { color: #E0A060; font-size: 12px; }"
+        ".session-time { color: #7FB3E0; font-size: 11px; }"
         "checkbutton label, radiobutton label { font-size: 14px; color: #E0E0E0; }"
         "togglebutton { padding: 8px 10px; font-size: 13px; background-color: #484868; border-radius: 5px; border: 1px solid #585878; color: #EAEAEA; }"
         "togglebutton:checked { background-color: #6A6AA0; border-color: #7A7AC0; color: white; }"
@@ -1466,7 +6837,8 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
         "dropdown listview row:selected { background-color: #505075 !important; color: white !important; }"
         "dropdown listview row:hover { background-color: rgba(80,80,110,0.5); }"
         "grid label { font-weight: bold; color: #D5D5D5; font-size: 10px; }"
-        "separator { background-color: #4A4A6A; min-height: 1px; margin-top: 10px; margin-bottom: 10px; }";
+        "separator { background-color: #4A4A6A; min-height: 1px; margin-top: 10px; margin-bottom: 10px; }"
+        ".hud { font-family: monospace; font-size: 12px; color: #B0F0B0; background-color: rgba(0, 0, 0, 0.75); padding: 8px; margin: 8px; border-radius: 4px; }";
 
     gtk_css_provider_load_from_string(css_provider, css);
     gtk_style_context_add_provider_for_display(gdk_display_get_default(),
@@ -1476,63 +6848,32 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
 
 
     AppData *app_data = g_new0(AppData, 1);
+    app_data->app = app;
+    app_data->startup_us = startup_us;
     app_data->habits = NULL;
+    app_data->habits_by_id = g_hash_table_new(g_int64_hash, g_int64_equal);
     app_data->habit_widgets = NULL;
+    app_data->habit_boxes = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
     app_data->timetable_grid = NULL;
-
-    if (sqlite3_open("habit_tracker.db", &app_data->db) != SQLITE_OK) {
-        g_printerr("Cannot open database: %s\n", sqlite3_errmsg(app_data->db));
-        cleanup_app_data(app_data);
-        return;
-    }
-
-    /*  
-    const char *drop_habits_table_sql = "DROP TABLE IF EXISTS habit_tracking;";
-    sqlite3_exec(app_data->db, drop_habits_table_sql, NULL, NULL, NULL);
-    const char *drop_tasks_table_sql = "DROP TABLE IF EXISTS timetable_tasks;";
-    sqlite3_exec(app_data->db, drop_tasks_table_sql, NULL, NULL, NULL);
-    const char *drop_completed_tasks_table_sql = "DROP TABLE IF EXISTS completed_tasks;";
-    sqlite3_exec(app_data->db, drop_completed_tasks_table_sql, NULL, NULL, NULL);
-    */
-
-    const char *create_habits_table_sql =
-        "CREATE TABLE IF NOT EXISTS habit_tracking ("
-        "date TEXT, habit_name TEXT, completed INTEGER, "
-        "days TEXT, time_slot TEXT, "
-        "PRIMARY KEY (date, habit_name));";
-    if (sqlite3_exec(app_data->db, create_habits_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
-        g_printerr("Failed to create habit_tracking table: %s\n", sqlite3_errmsg(app_data->db));
-        cleanup_app_data(app_data);
-        return;
-    }
-
-    const char *create_tasks_table_sql =
-        "CREATE TABLE IF NOT EXISTS timetable_tasks ("
-        "day TEXT, time_slot TEXT, task TEXT, "
-        "PRIMARY KEY (day, time_slot, task));";
-    if (sqlite3_exec(app_data->db, create_tasks_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
-        g_printerr("Failed to create timetable_tasks table: %s\n", sqlite3_errmsg(app_data->db));
-        cleanup_app_data(app_data);
-        return;
-    }
-
-    const char *create_completed_tasks_table_sql =
-        "CREATE TABLE IF NOT EXISTS completed_tasks ("
-        "task TEXT, day TEXT, time_slot TEXT, "
-        "PRIMARY KEY (task, day, time_slot));";
-    if (sqlite3_exec(app_data->db, create_completed_tasks_table_sql, NULL, NULL, NULL) != SQLITE_OK) {
-        g_printerr("Failed to create completed_tasks table: %s\n", sqlite3_errmsg(app_data->db));
-        cleanup_app_data(app_data);
-        return;
-    }
-
     app_data->main_window = gtk_application_window_new(app);
     gtk_window_set_title(GTK_WINDOW(app_data->main_window), "Habit & Task Manager");
     gtk_window_set_default_size(GTK_WINDOW(app_data->main_window), 1000, 750);
 
 
+    GtkWidget *overlay = gtk_overlay_new();
+    gtk_window_set_child(GTK_WINDOW(app_data->main_window), overlay);
+
     GtkWidget *notebook = gtk_notebook_new();
-    gtk_window_set_child(GTK_WINDOW(app_data->main_window), notebook);
+    app_data->notebook = notebook;
+    gtk_overlay_set_child(GTK_OVERLAY(overlay), notebook);
+
+    app_data->hud_label = gtk_label_new("");
+    gtk_widget_add_css_class(app_data->hud_label, "hud");
+    gtk_widget_set_halign(app_data->hud_label, GTK_ALIGN_END);
+    gtk_widget_set_valign(app_data->hud_label, GTK_ALIGN_START);
+    gtk_widget_set_can_target(app_data->hud_label, FALSE);
+    gtk_widget_set_visible(app_data->hud_label, FALSE);
+    gtk_overlay_add_overlay(GTK_OVERLAY(overlay), app_data->hud_label);
 
     GtkWidget *habits_page_scroll = gtk_scrolled_window_new();
     gtk_widget_set_name(habits_page_scroll, "habits-page-scroll");
@@ -1554,7 +6895,8 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
     gtk_box_append(GTK_BOX(habits_page), pending_tasks_label);
 
     app_data->pending_tasks_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-     gtk_widget_set_margin_bottom(app_data->pending_tasks_box, 15);
+    gtk_widget_set_margin_bottom(app_data->pending_tasks_box, 15);
+    gtk_widget_set_sensitive(app_data->pending_tasks_box, FALSE);
     gtk_box_append(GTK_BOX(habits_page), app_data->pending_tasks_box);
 
     GtkWidget *separator1 = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
@@ -1580,62 +6922,50 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
     app_data->habits_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 15);
     gtk_widget_set_halign(app_data->habits_box, GTK_ALIGN_CENTER);
     gtk_widget_set_margin_bottom(app_data->habits_box, 15);
+    gtk_widget_set_sensitive(app_data->habits_box, FALSE);
     GtkWidget* habits_scroll = gtk_scrolled_window_new();
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(habits_scroll), GTK_POLICY_AUTOMATIC, GTK_POLICY_NEVER);
     gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(habits_scroll), app_data->habits_box);
     gtk_widget_set_vexpand(habits_scroll, FALSE);
     gtk_box_append(GTK_BOX(habits_page), habits_scroll);
 
-
-    char query_load_habits[256];
-    snprintf(query_load_habits, sizeof(query_load_habits), "SELECT DISTINCT habit_name, days FROM habit_tracking WHERE date = '' OR date IS NULL;");
-    sqlite3_stmt *stmt_load_habits;
-    if (sqlite3_prepare_v2(app_data->db, query_load_habits, -1, &stmt_load_habits, NULL) == SQLITE_OK) {
-        GDateTime *today = g_date_time_new_now_local();
-        int day_of_week = g_date_time_get_day_of_week(today);
-        const char *day_names_map[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
-        const char *current_day_name = day_names_map[day_of_week -1];
-        g_date_time_unref(today);
-
-        while (sqlite3_step(stmt_load_habits) == SQLITE_ROW) {
-            const char *habit_name_db = (const char *)sqlite3_column_text(stmt_load_habits, 0);
-            const char *days_str_db = (const char *)sqlite3_column_text(stmt_load_habits, 1);
-            if (!days_str_db) days_str_db = "";
-
-            app_data->habits = g_list_append(app_data->habits, g_strdup(habit_name_db));
-
-            GtkWidget *habit_box_ui = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
-            gtk_widget_set_valign(habit_box_ui, GTK_ALIGN_START);
-            GtkWidget *drawing_area_ui = gtk_drawing_area_new();
-            gtk_widget_set_size_request(drawing_area_ui, 70, 70);
-            gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(drawing_area_ui), draw_habit_logo, g_strdup(habit_name_db), g_free);
-            g_object_set_data(G_OBJECT(drawing_area_ui), "app_data", app_data);
-            g_object_set_data(G_OBJECT(drawing_area_ui), "habit_name", g_strdup(habit_name_db));
-            gtk_box_append(GTK_BOX(habit_box_ui), drawing_area_ui);
-
-            g_object_set_data(G_OBJECT(habit_box_ui), "habit_name", g_strdup(habit_name_db));
-
-            GtkWidget *label_ui = gtk_label_new(habit_name_db);
-            gtk_widget_set_halign(label_ui, GTK_ALIGN_CENTER);
-            gtk_box_append(GTK_BOX(habit_box_ui), label_ui);
-
-            if (strstr(days_str_db, current_day_name)) {
-                GtkWidget *done_button_ui = gtk_button_new_with_label("Done Today");
-                g_object_set_data(G_OBJECT(done_button_ui), "habit_name", g_strdup(habit_name_db));
-                g_object_set_data(G_OBJECT(done_button_ui), "drawing_area", drawing_area_ui);
-                g_signal_connect(done_button_ui, "clicked", G_CALLBACK(on_done_today_clicked), app_data);
-                gtk_box_append(GTK_BOX(habit_box_ui), done_button_ui);
-            }
-
-            gtk_box_append(GTK_BOX(app_data->habits_box), habit_box_ui);
-            app_data->habit_widgets = g_list_append(app_data->habit_widgets, habit_box_ui);
-        }
-    }
-    sqlite3_finalize(stmt_load_habits);
+    GtkWidget *month_heading = gtk_label_new("Month Overview");
+    gtk_widget_add_css_class(month_heading, "heading");
+    gtk_widget_set_halign(month_heading, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(habits_page), month_heading);
+
+    GtkWidget *month_nav_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_halign(month_nav_box, GTK_ALIGN_CENTER);
+    GtkWidget *month_previous_button = gtk_button_new_with_label("‹");
+    g_signal_connect(month_previous_button, "clicked", G_CALLBACK(on_month_previous), app_data);
+    gtk_box_append(GTK_BOX(month_nav_box), month_previous_button);
+    app_data->month_label = gtk_label_new("");
+    gtk_widget_set_size_request(app_data->month_label, 120, -1);
+    gtk_box_append(GTK_BOX(month_nav_box), app_data->month_label);
+    GtkWidget *month_next_button = gtk_button_new_with_label("›");
+    g_signal_connect(month_next_button, "clicked", G_CALLBACK(on_month_next), app_data);
+    gtk_box_append(GTK_BOX(month_nav_box), month_next_button);
+    gtk_box_append(GTK_BOX(habits_page), month_nav_box);
+
+    app_data->month_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(app_data->month_area, 7 * MONTH_CELL_WIDTH, MONTH_HEADER_HEIGHT + 6 * MONTH_CELL_HEIGHT);
+    gtk_widget_set_halign(app_data->month_area, GTK_ALIGN_CENTER);
+    gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(app_data->month_area), draw_month_overview, app_data, NULL);
+    gtk_box_append(GTK_BOX(habits_page), app_data->month_area);
+    app_data->month_overviews = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, g_free);
+    app_data->session_weeks = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, session_week_free);
+    app_data->month_shown = month_key_for_day(day_number_today());
+    month_overview_show(app_data, app_data->month_shown);
+
+
+    app_data->loading_label = gtk_label_new("Loading habits and tasks…");
+    gtk_box_append(GTK_BOX(app_data->habits_box), app_data->loading_label);
 
     GtkWidget* management_buttons_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
     gtk_widget_set_halign(management_buttons_box, GTK_ALIGN_CENTER);
+    gtk_widget_set_sensitive(management_buttons_box, FALSE);
     gtk_box_append(GTK_BOX(habits_page), management_buttons_box);
+    app_data->management_buttons_box = management_buttons_box;
 
 
     GtkWidget *edit_habits_button = gtk_button_new_with_label("Manage Habits");
@@ -1646,24 +6976,99 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
     g_signal_connect(edit_tasks_button, "clicked", G_CALLBACK(on_edit_tasks), app_data);
     gtk_box_append(GTK_BOX(management_buttons_box), edit_tasks_button);
 
+    GtkWidget *archived_habits_button = gtk_button_new_with_label("Archived Habits");
+    g_signal_connect(archived_habits_button, "clicked", G_CALLBACK(on_show_archived_habits), app_data);
+    gtk_box_append(GTK_BOX(management_buttons_box), archived_habits_button);
+
 
-    GtkWidget *timetable_page_content = create_timetable_page(app_data);
     GtkWidget *timetable_scrolled = gtk_scrolled_window_new();
-    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(timetable_scrolled), timetable_page_content);
+    app_data->timetable_page = timetable_scrolled;
+    gtk_widget_set_sensitive(timetable_scrolled, FALSE);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(timetable_scrolled),
                                    GTK_POLICY_AUTOMATIC,
                                    GTK_POLICY_AUTOMATIC);
     gtk_notebook_append_page(GTK_NOTEBOOK(notebook), timetable_scrolled, gtk_label_new("Weekly Timetable"));
 
+    GtkWidget *stats_scrolled = gtk_scrolled_window_new();
+    app_data->stats_page = stats_scrolled;
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), stats_scrolled, gtk_label_new("Statistics"));
+
+    GtkWidget *heatmap_scrolled = gtk_scrolled_window_new();
+    app_data->heatmap_page = heatmap_scrolled;
+    gtk_widget_set_sensitive(heatmap_scrolled, FALSE);
+    app_data->heatmap_tiles = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, heatmap_tile_free);
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), heatmap_scrolled, gtk_label_new("Heatmap"));
+
+    GtkWidget *correlation_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    app_data->correlation_page = correlation_box;
+    GtkWidget *correlation_controls = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_halign(correlation_controls, GTK_ALIGN_CENTER);
+    gtk_widget_set_margin_top(correlation_controls, 10);
+    GtkWidget *range_dropdown = gtk_drop_down_new_from_strings(correlation_range_names);
+    g_signal_connect(range_dropdown, "notify::selected", G_CALLBACK(on_correlation_range_changed), app_data);
+    gtk_box_append(GTK_BOX(correlation_controls), range_dropdown);
+    GtkWidget *sort_dropdown = gtk_drop_down_new_from_strings(correlation_sort_names);
+    g_signal_connect(sort_dropdown, "notify::selected", G_CALLBACK(on_correlation_sort_changed), app_data);
+    gtk_box_append(GTK_BOX(correlation_controls), sort_dropdown);
+    gtk_box_append(GTK_BOX(correlation_box), correlation_controls);
+    app_data->correlation_results = gtk_scrolled_window_new();
+    gtk_widget_set_vexpand(app_data->correlation_results, TRUE);
+    gtk_box_append(GTK_BOX(correlation_box), app_data->correlation_results);
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), correlation_box, gtk_label_new("Correlations"));
+    g_signal_connect(notebook, "switch-page", G_CALLBACK(on_notebook_switch_page), app_data);
+
+
+    // Latency histograms are dumped to stdout with Ctrl+Shift+L or `kill -USR1 <pid>`.
+    GSimpleAction *dump_latency_action = g_simple_action_new("dump-latency", NULL);
+    g_signal_connect(dump_latency_action, "activate", G_CALLBACK(on_dump_latency_action), app_data);
+    g_action_map_add_action(G_ACTION_MAP(app), G_ACTION(dump_latency_action));
+    g_object_unref(dump_latency_action);
+    const char *dump_latency_accels[] = {"<Control><Shift>l", NULL};
+    gtk_application_set_accels_for_action(app, "app.dump-latency", dump_latency_accels);
+    app_data->latency_signal_source = g_unix_signal_add(SIGUSR1, on_dump_latency_signal, app_data);
+
+    GSimpleAction *toggle_hud_action = g_simple_action_new("toggle-hud", NULL);
+    g_signal_connect(toggle_hud_action, "activate", G_CALLBACK(on_toggle_hud_action), app_data);
+    g_action_map_add_action(G_ACTION_MAP(app), G_ACTION(toggle_hud_action));
+    g_object_unref(toggle_hud_action);
+    const char *toggle_hud_accels[] = {"F12", NULL};
+    gtk_application_set_accels_for_action(app, "app.toggle-hud", toggle_hud_accels);
+
+    GSimpleAction *memory_panel_action = g_simple_action_new("memory-panel", NULL);
+    g_signal_connect(memory_panel_action, "activate", G_CALLBACK(on_memory_panel_action), app_data);
+    g_action_map_add_action(G_ACTION_MAP(app), G_ACTION(memory_panel_action));
+    g_object_unref(memory_panel_action);
+    const char *memory_panel_accels[] = {"<Control><Shift>m", NULL};
+    gtk_application_set_accels_for_action(app, "app.memory-panel", memory_panel_accels);
+
+    GSimpleAction *rolling_counts_action = g_simple_action_new("rolling-counts", NULL);
+    g_signal_connect(rolling_counts_action, "activate", G_CALLBACK(on_rolling_counts_action), app_data);
+    g_action_map_add_action(G_ACTION_MAP(app), G_ACTION(rolling_counts_action));
+    g_object_unref(rolling_counts_action);
+    const char *rolling_counts_accels[] = {"<Control><Shift>r", NULL};
+    gtk_application_set_accels_for_action(app, "app.rolling-counts", rolling_counts_accels);
+
+    metrics_setup(app_data);
+
+    snapshot_apply(app_data);
+
+    // Any input postpones idle maintenance and cancels a pass in progress.
+    GtkEventController *input_controller = gtk_event_controller_legacy_new();
+    gtk_event_controller_set_propagation_phase(input_controller, GTK_PHASE_CAPTURE);
+    g_signal_connect(input_controller, "event", G_CALLBACK(on_window_input), app_data);
+    gtk_widget_add_controller(app_data->main_window, input_controller);
 
     g_signal_connect(app_data->main_window, "destroy", G_CALLBACK(cleanup_app_data), app_data);
     gtk_window_present(GTK_WINDOW(app_data->main_window));
+    startup_begin(app_data);
 }
 
 int main(int argc, char *argv[]) {
+    gint64 startup_us = g_get_monotonic_time();
     GtkApplication *app = gtk_application_new("org.example.hb", G_APPLICATION_DEFAULT_FLAGS);
-    g_signal_connect(app, "activate", G_CALLBACK(on_activate), NULL);
+    g_signal_connect(app, "activate", G_CALLBACK(on_activate), &startup_us);
     int status = g_application_run(G_APPLICATION(app), argc, argv);
     g_object_unref(app);
+    mem_report_leaks();
     return status;
 }
\ No newline at end of file